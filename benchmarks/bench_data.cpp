@@ -0,0 +1,246 @@
+#include "bench_data.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "perf_counters.h"
+#include "utils.h"
+#include "encryptor/encryptor.h"
+
+namespace rdh::bench {
+    const std::vector<ReferenceImage> BenchData::s_ReferenceImages{
+        { "Airplane", "airplane" },
+        { "Boat", "boat" },
+        { "Crowd", "crowd" },
+        { "Lena", "lena_gray" },
+        { "Man", "man" },
+        { "Liberty", "liberty1024x1024" },
+        { "Man", "man2048x2048" },
+        { "Man", "man4096x4096" }
+    };
+
+    namespace {
+        std::string OriginalPath(const ReferenceImage& t_Image)
+        {
+            return "images/original/" + t_Image.m_FileName + ".bmp";
+        }
+
+        std::string EncryptedPath(const ReferenceImage& t_Image)
+        {
+            return "images/encrypted/" + t_Image.m_FileName + "-enc.bmp";
+        }
+    }
+
+    BenchData& BenchData::Instance()
+    {
+        static BenchData s_Instance;
+        return s_Instance;
+    }
+
+    bool BenchData::Init(int& t_Argc, char** t_Argv)
+    {
+        std::filesystem::path dataRoot = TakeFlag(t_Argc, t_Argv, "--rdh_data_root");
+
+        if (const std::string maxImageSize = TakeFlag(t_Argc, t_Argv, "--rdh_max_image_size"); !maxImageSize.empty()) {
+            try {
+                m_MaxImageSize = static_cast<uint32_t>(std::stoul(maxImageSize));
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+        }
+
+        if (!TakeBoolFlag(t_Argc, t_Argv, "--rdh_memory_stats", m_MemoryStats) || !TakeBoolFlag(t_Argc, t_Argv, "--rdh_perf_counters", m_PerfCounters)) {
+            return false;
+        }
+
+        if (dataRoot.empty()) {
+            if (const char* envDataRoot = std::getenv("RDH_DATA_ROOT"); envDataRoot != nullptr) {
+                dataRoot = envDataRoot;
+            }
+        }
+
+        if (dataRoot.empty()) {
+            std::error_code ec;
+            for (auto dir = std::filesystem::current_path(ec); !dir.empty(); dir = dir.parent_path()) {
+                if (std::filesystem::is_directory(dir / "images" / "original", ec)) {
+                    dataRoot = dir;
+                    break;
+                }
+
+                if (dir == dir.parent_path()) {
+                    break;
+                }
+            }
+        }
+
+        if (dataRoot.empty() || !std::filesystem::is_directory(dataRoot / "images" / "original")) {
+            return false;
+        }
+
+        m_DataRoot = dataRoot;
+        return true;
+    }
+
+    const BmpImage& BenchData::GetImage(const std::string& t_RelativePath)
+    {
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+
+        auto& image = m_Images[t_RelativePath];
+        if (!image) {
+            const std::filesystem::path path = m_DataRoot / t_RelativePath;
+            if (!std::filesystem::is_regular_file(path)) {
+                m_Images.erase(t_RelativePath);
+                throw std::runtime_error("Benchmark image " + path.string() + " doesn't exist!");
+            }
+
+            image = std::make_unique<BmpImage>(path.string());
+        }
+
+        return *image;
+    }
+
+    const BmpImage& BenchData::GetSyntheticImage(SyntheticImage::Kind t_Kind, uint32_t t_Size, bool t_Encrypted)
+    {
+        const std::string key = "synthetic/" + SyntheticImage::KindName(t_Kind) + "/" + std::to_string(t_Size) + (t_Encrypted ? "-enc" : "");
+
+        {
+            std::lock_guard<std::mutex> lock(m_CacheMutex);
+            if (auto imageIt = m_Images.find(key); imageIt != m_Images.end()) {
+                return *imageIt->second;
+            }
+        }
+
+        /* Generated without holding the lock: encrypted image is made from the plain one. */
+        std::unique_ptr<BmpImage> image;
+        if (t_Encrypted) {
+            std::vector<uint8_t> encryptionKey = GetEncryptionKey();
+            image = std::make_unique<BmpImage>(Encryptor::Encrypt(GetSyntheticImage(t_Kind, t_Size), encryptionKey));
+        }
+        else {
+            image = std::make_unique<BmpImage>(SyntheticImage::Generate(t_Kind, t_Size, t_Size, c_SyntheticSeed));
+        }
+
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+        return *m_Images.try_emplace(key, std::move(image)).first->second;
+    }
+
+    const std::vector<uint8_t>& BenchData::GetFile(const std::string& t_RelativePath)
+    {
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+
+        auto fileIt = m_Files.find(t_RelativePath);
+        if (fileIt == m_Files.end()) {
+            fileIt = m_Files.emplace(t_RelativePath, utils::LoadFileData<uint8_t>((m_DataRoot / t_RelativePath).string())).first;
+        }
+
+        return fileIt->second;
+    }
+
+    std::vector<ReferenceImage> BenchData::GetReferenceImages(ImageSet t_Set) const
+    {
+        std::vector<ReferenceImage> images;
+
+        for (const auto& image : s_ReferenceImages) {
+            std::error_code ec;
+            if (!std::filesystem::is_regular_file(m_DataRoot / OriginalPath(image), ec)) {
+                continue;
+            }
+
+            if (t_Set == ImageSet::ENCRYPTED && !std::filesystem::is_regular_file(m_DataRoot / EncryptedPath(image), ec)) {
+                continue;
+            }
+
+            images.push_back(image);
+        }
+
+        return images;
+    }
+
+    std::vector<benchmark::internal::Benchmark*> BenchData::RegisterForEachImage(const std::string& t_Name, ImageSet t_Set,
+        const std::function<void(benchmark::State&, const ImageCase&)>& t_Body)
+    {
+        std::vector<benchmark::internal::Benchmark*> registered;
+
+        for (const auto& image : GetReferenceImages(t_Set)) {
+            /* Decoding here keeps file loading out of the measured runs. Cached images live as long as the process. */
+            const BmpImage& original = GetImage(OriginalPath(image));
+            const BmpImage* encrypted = (t_Set == ImageSet::ENCRYPTED) ? &GetImage(EncryptedPath(image)) : nullptr;
+
+            const std::string name = t_Name + "/" + image.m_Name + "_"
+                + std::to_string(original.GetHeight()) + "x" + std::to_string(original.GetWidth());
+
+            registered.push_back(Register(name,
+                [t_Body, image, originalPath = m_DataRoot / OriginalPath(image), &original, encrypted](benchmark::State& t_State) {
+                    t_Body(t_State, ImageCase{ image, originalPath, original, encrypted });
+                }
+            ));
+        }
+
+        return registered;
+    }
+
+    benchmark::internal::Benchmark* BenchData::Register(const std::string& t_Name, const std::function<void(benchmark::State&)>& t_Body)
+    {
+        return benchmark::RegisterBenchmark(t_Name.c_str(), [t_Body](benchmark::State& t_State) {
+            PerfMonitor::Instance().Run(t_State, t_Body);
+        });
+    }
+
+    bool BenchData::AddSuite(const std::function<void()>& t_Suite)
+    {
+        Suites().push_back(t_Suite);
+        return true;
+    }
+
+    void BenchData::RegisterSuites()
+    {
+        for (const auto& suite : Suites()) {
+            suite();
+        }
+    }
+
+    std::string BenchData::TakeFlag(int& t_Argc, char** t_Argv, const std::string& t_Name)
+    {
+        const std::string prefix = t_Name + "=";
+        std::string value;
+
+        int argIdx = 1;
+        while (argIdx < t_Argc) {
+            if (std::strncmp(t_Argv[argIdx], prefix.c_str(), prefix.size()) == 0) {
+                value = t_Argv[argIdx] + prefix.size();
+                for (int nextIdx = argIdx; nextIdx + 1 < t_Argc; ++nextIdx) {
+                    t_Argv[nextIdx] = t_Argv[nextIdx + 1];
+                }
+                t_Argc--;
+            }
+            else {
+                argIdx++;
+            }
+        }
+
+        return value;
+    }
+
+    bool BenchData::TakeBoolFlag(int& t_Argc, char** t_Argv, const std::string& t_Name, bool& t_Value)
+    {
+        const std::string value = TakeFlag(t_Argc, t_Argv, t_Name);
+        if (value.empty()) {
+            return true;
+        }
+
+        if (value != "true" && value != "false") {
+            return false;
+        }
+
+        t_Value = (value == "true");
+        return true;
+    }
+
+    std::vector<std::function<void()>>& BenchData::Suites()
+    {
+        static std::vector<std::function<void()>> s_Suites;
+        return s_Suites;
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "benchmark/include/benchmark/benchmark.h"
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "image/bmp_image.h"
+#include "synthetic_image.h"
+
+namespace rdh::bench {
+    /**
+     * @brief Test image from the data root: images/original/<m_FileName>.bmp and (optionally)
+     * images/encrypted/<m_FileName>-enc.bmp.
+    */
+    struct ReferenceImage {
+        std::string m_Name;
+        std::string m_FileName;
+    };
+
+    /**
+     * @brief Images, that benchmarks can run on.
+    */
+    enum class ImageSet {
+        /* Every original image, that exists in the data root. */
+        ORIGINAL,
+        /* Images, that also have an encrypted version. */
+        ENCRYPTED
+    };
+
+    /**
+     * @brief Image, that a single registered benchmark runs on. Images are decoded once and shared
+     * between all of the benchmarks, so each iteration should copy them (BmpImage copy is a plain memory copy).
+    */
+    struct ImageCase {
+        const ReferenceImage& m_Reference;
+        /* Absolute path of the original image (for benchmarks, that measure decoding). */
+        const std::filesystem::path& m_OriginalPath;
+        const BmpImage& m_Original;
+        /* nullptr for ImageSet::ORIGINAL. */
+        const BmpImage* m_Encrypted;
+    };
+
+    /**
+     * @brief Locates the benchmark data (images, keys and payload) and caches decoded files in memory.
+    */
+    class BenchData {
+    public:
+        static BenchData& Instance();
+
+        /**
+         * @brief Parses and removes benchmark data flags from argv:
+         * --rdh_data_root=<path> - data root (RDH_DATA_ROOT environment variable is used, if the flag isn't set).
+         * Otherwise, the working directory and its parents are searched for a directory with images/original.
+         * --rdh_max_image_size=<pixels> - side of the biggest synthetic image (16384 by default).
+         * --rdh_memory_stats=true - measure allocations and peak memory of each benchmark (see BenchMemoryManager).
+         * --rdh_perf_counters=true - collect hardware counters of each benchmark and phase (see PerfMonitor).
+         * @return false, if the data root can't be found, or the flags are malformed.
+        */
+        bool Init(int& t_Argc, char** t_Argv);
+
+        const std::filesystem::path& GetDataRoot() const { return m_DataRoot; }
+
+        uint32_t GetMaxImageSize() const { return m_MaxImageSize; }
+
+        bool IsMemoryStatsEnabled() const { return m_MemoryStats; }
+
+        bool IsPerfCountersEnabled() const { return m_PerfCounters; }
+
+        /**
+         * @brief Decodes image (path relative to the data root) on the first request.
+         * @throw std::runtime_error if the image doesn't exist.
+        */
+        const BmpImage& GetImage(const std::string& t_RelativePath);
+
+        /**
+         * @brief Loads file (path relative to the data root) on the first request.
+        */
+        const std::vector<uint8_t>& GetFile(const std::string& t_RelativePath);
+
+        /**
+         * @brief Generates square synthetic image on the first request. All of the synthetic images use the same seed.
+         * @param t_Kind kind of the image.
+         * @param t_Size side of the image.
+         * @param t_Encrypted if set, returns the image encrypted using the example encryption key.
+        */
+        const BmpImage& GetSyntheticImage(SyntheticImage::Kind t_Kind, uint32_t t_Size, bool t_Encrypted = false);
+
+        const std::vector<uint8_t>& GetEncryptionKey() { return GetFile("example_encrypt_key.bin"); }
+        const std::vector<uint8_t>& GetEmbedKey() { return GetFile("example_embed_key.bin"); }
+        const std::vector<uint8_t>& GetPayload() { return GetFile("example_data_to_embed.bin"); }
+
+        /**
+         * @brief Reference images from t_Set, that are present in the data root.
+        */
+        std::vector<ReferenceImage> GetReferenceImages(ImageSet t_Set) const;
+
+        /**
+         * @brief Registers benchmark t_Name/<Image>_<Height>x<Width> for each image of t_Set.
+         * @param t_Name benchmark name.
+         * @param t_Set images to run on.
+         * @param t_Body benchmark body.
+         * @return registered benchmarks (to configure units, arguments, etc.).
+        */
+        std::vector<benchmark::internal::Benchmark*> RegisterForEachImage(const std::string& t_Name, ImageSet t_Set,
+            const std::function<void(benchmark::State&, const ImageCase&)>& t_Body);
+
+        /**
+         * @brief Registers benchmark t_Name. All of the benchmarks should be registered using it (or RegisterForEachImage),
+         * so that they report hardware counters.
+         * @return registered benchmark.
+        */
+        static benchmark::internal::Benchmark* Register(const std::string& t_Name, const std::function<void(benchmark::State&)>& t_Body);
+
+        /**
+         * @brief Adds a function, that registers benchmarks. Suites are registered after the data root is known,
+         * so that benchmark names can depend on the data. Use it to initialize a static variable.
+         * @return true.
+        */
+        static bool AddSuite(const std::function<void()>& t_Suite);
+
+        /**
+         * @brief Registers all of the added suites.
+        */
+        static void RegisterSuites();
+
+    private:
+        BenchData() = default;
+
+        static std::vector<std::function<void()>>& Suites();
+
+        /**
+         * @brief Removes flag t_Name (in the form t_Name=<value>) from argv.
+         * @return value of the last occurrence of the flag, or empty string.
+        */
+        static std::string TakeFlag(int& t_Argc, char** t_Argv, const std::string& t_Name);
+
+        /**
+         * @brief Removes boolean flag t_Name (t_Name=true or t_Name=false) from argv.
+         * @return false, if the flag has some other value (t_Value is left unchanged, if the flag isn't set).
+        */
+        static bool TakeBoolFlag(int& t_Argc, char** t_Argv, const std::string& t_Name, bool& t_Value);
+
+        static const std::vector<ReferenceImage> s_ReferenceImages;
+
+        static constexpr uint64_t c_SyntheticSeed{ 0x5EED };
+
+        std::filesystem::path m_DataRoot;
+        uint32_t m_MaxImageSize{ 16384 };
+        bool m_MemoryStats{ false };
+        bool m_PerfCounters{ false };
+
+        std::mutex m_CacheMutex;
+        std::map<std::string, std::unique_ptr<BmpImage>> m_Images;
+        std::map<std::string, std::vector<uint8_t>> m_Files;
+    };
+}
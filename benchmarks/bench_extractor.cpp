@@ -1,32 +1,56 @@
 #include "benchmark/include/benchmark/benchmark.h"
 
+#include <optional>
+
+#include "bench_data.h"
 #include "params_generator.h"
-#include "reference_images.h"
+#include "perf_counters.h"
 
-#include "utils.h"
 #include "embedder/embedder.h"
 #include "extractor/extractor.h"
 #include "image/image_quality.h"
 
 using namespace rdh;
+using namespace rdh::bench;
 
-static void Extractor_ExtractData_Boat_512x512_bench(benchmark::State& state)
+/**
+ * @brief Applies benchmark arguments and embeds the payload into a copy of the encrypted image.
+ * @return marked encrypted image, that iterations copy from.
+ */
+static std::optional<BmpImage> PrepareMarkedImage(benchmark::State& state, const ImageCase& t_Case)
 {
-    for (auto _ : state)
+    ApplyCustomArguments(state);
+
+    BmpImage markedImage(*t_Case.m_Encrypted);
+    try
     {
-        state.PauseTiming();
+        Embedder::Embed(markedImage, BenchData::Instance().GetPayload(), BenchData::Instance().GetEmbedKey(), std::nullopt, std::nullopt);
+    }
+    catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return std::nullopt;
+    }
 
-        std::vector<uint8_t> dataEmbedKey = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_embed_key.bin");
-        std::vector<uint8_t> dataToEmbed = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_data_to_embed.bin");
-        rdh::BmpImage image("..\\..\\..\\..\\images\\encrypted\\boat-enc.bmp");
+    /* Hardware counters shouldn't include embedding. */
+    PerfMonitor::Instance().Restart();
 
-        rdh::Consts::Instance().UpdateThreshold(state.range(0));
-        rdh::Consts::Instance().UpdateAlpha(state.range(1));
-        rdh::Consts::Instance().UpdateLambda(state.range(2));
-        rdh::Consts::Instance().UpdateLsbLayers(state.range(3));
+    return markedImage;
+}
+
+static void Extractor_ExtractData_bench(benchmark::State& state, const ImageCase& t_Case)
+{
+    const std::optional<BmpImage> markedImage = PrepareMarkedImage(state, t_Case);
+    if (!markedImage) {
+        return;
+    }
+
+    std::vector<uint8_t> dataEmbedKey = BenchData::Instance().GetEmbedKey();
 
-        Embedder::Embed(image, dataToEmbed, dataEmbedKey, std::nullopt, std::nullopt);
-        
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        rdh::BmpImage image(*markedImage);
         state.ResumeTiming();
 
         try
@@ -40,28 +64,22 @@ static void Extractor_ExtractData_Boat_512x512_bench(benchmark::State& state)
         }
     }
 }
-BENCHMARK(Extractor_ExtractData_Boat_512x512_bench)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
 
-static void Extractor_RecoverImage_Boat_512x512_bench(benchmark::State& state)
+static void Extractor_RecoverImage_bench(benchmark::State& state, const ImageCase& t_Case)
 {
+    const std::optional<BmpImage> markedImage = PrepareMarkedImage(state, t_Case);
+    if (!markedImage) {
+        return;
+    }
+
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
+
     rdh::BmpImage image(0, 0);
 
     for (auto _ : state)
     {
         state.PauseTiming();
-
-        std::vector<uint8_t> dataEmbedKey = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_embed_key.bin");
-        std::vector<uint8_t> encryptionKey = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_encrypt_key.bin");
-        std::vector<uint8_t> dataToEmbed = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_data_to_embed.bin");
-        image = rdh::BmpImage("..\\..\\..\\..\\images\\encrypted\\boat-enc.bmp");
-
-        rdh::Consts::Instance().UpdateThreshold(state.range(0));
-        rdh::Consts::Instance().UpdateAlpha(state.range(1));
-        rdh::Consts::Instance().UpdateLambda(state.range(2));
-        rdh::Consts::Instance().UpdateLsbLayers(state.range(3));
-
-        Embedder::Embed(image, dataToEmbed, dataEmbedKey, std::nullopt, std::nullopt);
-
+        image = rdh::BmpImage(*markedImage);
         state.ResumeTiming();
 
         try
@@ -75,31 +93,49 @@ static void Extractor_RecoverImage_Boat_512x512_bench(benchmark::State& state)
         }
     }
 
-    state.counters["PSNR"] = rdh::ImageQuality::CalculatePSNR(References::GetInstance().GetBoat(), image);
-    state.counters["SSIM"] = rdh::ImageQuality::CalculateSSIM(References::GetInstance().GetBoat(), image);
+    state.counters["PSNR"] = rdh::ImageQuality::CalculatePSNR(t_Case.m_Original, image);
+    state.counters["SSIM"] = rdh::ImageQuality::CalculateSSIM(t_Case.m_Original, image);
 }
-BENCHMARK(Extractor_RecoverImage_Boat_512x512_bench)->Iterations(3)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
 
-static void Extractor_RecoverImageExtractData_Boat_512x512_bench(benchmark::State& state)
+static void Extractor_RecoverPreview_bench(benchmark::State& state, const ImageCase& t_Case)
 {
-    rdh::BmpImage image(0, 0);
+    const std::optional<BmpImage> markedImage = PrepareMarkedImage(state, t_Case);
+    if (!markedImage) {
+        return;
+    }
+
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
 
     for (auto _ : state)
     {
-        state.PauseTiming();
+        try
+        {
+            benchmark::DoNotOptimize(Extractor::RecoverPreview(*markedImage, "", encryptionKey));
+        }
+        catch (const std::exception& e)
+        {
+            state.SkipWithError(e.what());
+            break;
+        }
+    }
+}
 
-        std::vector<uint8_t> dataEmbedKey = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_embed_key.bin");
-        std::vector<uint8_t> encryptionKey = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_encrypt_key.bin");
-        std::vector<uint8_t> dataToEmbed = utils::LoadFileData<uint8_t>("..\\..\\..\\..\\example_data_to_embed.bin");
-        image = rdh::BmpImage("..\\..\\..\\..\\images\\encrypted\\boat-enc.bmp");
+static void Extractor_RecoverImageExtractData_bench(benchmark::State& state, const ImageCase& t_Case)
+{
+    const std::optional<BmpImage> markedImage = PrepareMarkedImage(state, t_Case);
+    if (!markedImage) {
+        return;
+    }
 
-        rdh::Consts::Instance().UpdateThreshold(state.range(0));
-        rdh::Consts::Instance().UpdateAlpha(state.range(1));
-        rdh::Consts::Instance().UpdateLambda(state.range(2));
-        rdh::Consts::Instance().UpdateLsbLayers(state.range(3));
+    std::vector<uint8_t> dataEmbedKey = BenchData::Instance().GetEmbedKey();
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
 
-        Embedder::Embed(image, dataToEmbed, dataEmbedKey, std::nullopt, std::nullopt);
+    rdh::BmpImage image(0, 0);
 
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        image = rdh::BmpImage(*markedImage);
         state.ResumeTiming();
 
         try
@@ -113,7 +149,26 @@ static void Extractor_RecoverImageExtractData_Boat_512x512_bench(benchmark::Stat
         }
     }
 
-    state.counters["PSNR"] = rdh::ImageQuality::CalculatePSNR(References::GetInstance().GetBoat(), image);
-    state.counters["SSIM"] = rdh::ImageQuality::CalculateSSIM(References::GetInstance().GetBoat(), image);
+    state.counters["PSNR"] = rdh::ImageQuality::CalculatePSNR(t_Case.m_Original, image);
+    state.counters["SSIM"] = rdh::ImageQuality::CalculateSSIM(t_Case.m_Original, image);
 }
-BENCHMARK(Extractor_RecoverImageExtractData_Boat_512x512_bench)->Iterations(3)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
+
+static const bool s_ExtractorSuite = BenchData::AddSuite([]() {
+    BenchData& data = BenchData::Instance();
+
+    for (auto* bench : data.RegisterForEachImage("Extractor_ExtractData", ImageSet::ENCRYPTED, Extractor_ExtractData_bench)) {
+        bench->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
+    }
+
+    for (auto* bench : data.RegisterForEachImage("Extractor_RecoverImage", ImageSet::ENCRYPTED, Extractor_RecoverImage_bench)) {
+        bench->Iterations(3)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
+    }
+
+    for (auto* bench : data.RegisterForEachImage("Extractor_RecoverPreview", ImageSet::ENCRYPTED, Extractor_RecoverPreview_bench)) {
+        bench->Iterations(3)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
+    }
+
+    for (auto* bench : data.RegisterForEachImage("Extractor_RecoverImageExtractData", ImageSet::ENCRYPTED, Extractor_RecoverImageExtractData_bench)) {
+        bench->Iterations(3)->Unit(benchmark::kMillisecond)->Apply(CustomArguments);
+    }
+});
@@ -0,0 +1,461 @@
+#include "benchmark/include/benchmark/benchmark.h"
+
+#include <array>
+#include <numeric>
+#include <random>
+
+#include "bench_data.h"
+
+#include "utils.h"
+#include "embedder/compressor.h"
+#include "embedder/consts.h"
+#include "embedder/embedder.h"
+#include "embedder/embedding_params.h"
+#include "embedder/group_compressor-impl.h"
+#include "extractor/extractor.h"
+
+namespace rdh::bench {
+    /**
+     * @brief Microbenchmarks for the individual kernels of embedding and extraction. Every kernel reports
+     * items/s (blocks, symbols, groups or bits) and bytes/s, so that its cost can be compared against the whole pipeline.
+     * Parameters are the defaults, except for the number of LSB layers, which is the benchmark argument where it matters.
+    */
+    class Kernels {
+    public:
+        static void Register();
+
+    private:
+        /**
+         * @brief Top-left pixel of a block, and the other three.
+        */
+        using Block = std::array<Color8u, 4>;
+
+        /**
+         * @brief All 2x2 blocks of the image in raster order.
+        */
+        static std::vector<Block> CollectBlocks(const BmpImage& t_Image);
+
+        /**
+         * @brief Seed sequence, that is used to shuffle bitstream for the data embedding key.
+        */
+        static std::array<uint32_t, 5> ShuffleSeed(const std::vector<uint8_t>& t_DataEmbeddingKey);
+
+        /**
+         * @brief Group of LSBs, as the embedder collects them: first t_LsbLayers LSBs of each \omega_2 block pixel
+         * (without the top-left pixel LSB). Blocks are taken from the beginning of the image, whatever their type is.
+        */
+        static Embedder::Group CollectGroup(const BmpImage& t_Image, const Consts& t_Params);
+
+        static void RlcCompressor_TryCompress(benchmark::State& state, const ImageCase& t_Case);
+        static void RlcCompressor_Decompress(benchmark::State& state, const ImageCase& t_Case);
+        static void RlcHuffmanCode_Encode(benchmark::State& state, const ImageCase& t_Case);
+        static void RlcHuffmanCode_Decode(benchmark::State& state, const ImageCase& t_Case);
+        /**
+         * @brief Appends bits of a single group to Embedder::GroupCompressor<Params> and compresses it, as PrepareInPlace does.
+        */
+        template <class Params>
+        static void RunGroupCompressor(benchmark::State& state, const ImageCase& t_Case, const Consts& t_Params);
+
+        static void Embedder_GroupCompressor(benchmark::State& state, const ImageCase& t_Case);
+        static void Embedder_GroupCompressorDynamic(benchmark::State& state, const ImageCase& t_Case);
+        static void Utils_ShuffleFisherYates(benchmark::State& state, const ImageCase& t_Case);
+        static void Utils_DeshuffleFisherYates(benchmark::State& state, const ImageCase& t_Case);
+        static void Extractor_ExtractBitStreams(benchmark::State& state, const ImageCase& t_Case);
+        static void CandidateSearch_Recover(benchmark::State& state, const ImageCase& t_Case);
+    };
+
+    std::vector<Kernels::Block> Kernels::CollectBlocks(const BmpImage& t_Image)
+    {
+        std::vector<Block> blocks;
+        blocks.reserve(static_cast<std::size_t>(t_Image.GetHeight() / 2) * (t_Image.GetWidth() / 2));
+
+        for (uint32_t imgY = 0; imgY < t_Image.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_Image.GetWidth(); imgX += 2) {
+                blocks.push_back({
+                    t_Image.GetPixel(imgY, imgX), t_Image.GetPixel(imgY, imgX + 1),
+                    t_Image.GetPixel(imgY + 1, imgX), t_Image.GetPixel(imgY + 1, imgX + 1)
+                });
+            }
+        }
+
+        return blocks;
+    }
+
+    std::array<uint32_t, 5> Kernels::ShuffleSeed(const std::vector<uint8_t>& t_DataEmbeddingKey)
+    {
+        std::array<uint32_t, 5> hash;
+        utils::CalculateSHA1(t_DataEmbeddingKey, hash);
+        return hash;
+    }
+
+    Embedder::Group Kernels::CollectGroup(const BmpImage& t_Image, const Consts& t_Params)
+    {
+        Embedder::Group group = Embedder::Group::Zero(t_Params.GetGroupSizeBeforeCompression(), 1);
+
+        uint32_t bitIdx{ 0 };
+        for (const Block& block : CollectBlocks(t_Image)) {
+            for (uint32_t pxIdx = 0; pxIdx < block.size(); ++pxIdx) {
+                for (uint32_t bitPos = (pxIdx == 0) ? 1 : 0; bitPos < t_Params.GetLsbLayers(); ++bitPos) {
+                    if (bitIdx == group.rows()) {
+                        return group;
+                    }
+
+                    group(bitIdx++, 0) = (block[pxIdx] >> bitPos) & 1;
+                }
+            }
+        }
+
+        return group;
+    }
+
+    void Kernels::RlcCompressor_TryCompress(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const std::vector<Block> blocks = CollectBlocks(*t_Case.m_Encrypted);
+        const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+        std::string compressed;
+        compressed.reserve(64);
+
+        for (auto _ : state)
+        {
+            uint32_t compressibleBlocks{ 0 };
+            for (const Block& block : blocks) {
+                compressibleBlocks += RlcCompressor::TryCompress(block[0], block[1], block[2], block[3], huffmanCoder, compressed) ? 1 : 0;
+            }
+
+            benchmark::DoNotOptimize(compressibleBlocks);
+        }
+
+        state.SetItemsProcessed(state.iterations() * blocks.size());
+        state.SetBytesProcessed(state.iterations() * blocks.size() * sizeof(Block));
+    }
+
+    void Kernels::RlcCompressor_Decompress(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+        /* Only blocks, that have a Huffman code, can be decompressed. */
+        std::vector<std::pair<Color8u, std::string>> compressedBlocks;
+        for (const Block& block : CollectBlocks(*t_Case.m_Encrypted)) {
+            std::string compressed;
+            if (RlcCompressor::TryCompress(block[0], block[1], block[2], block[3], huffmanCoder, compressed)) {
+                compressedBlocks.emplace_back(block[0], std::move(compressed));
+            }
+        }
+
+        for (auto _ : state)
+        {
+            for (const auto& [topLeftPixel, compressed] : compressedBlocks) {
+                benchmark::DoNotOptimize(RlcCompressor::Decompress(topLeftPixel, compressed, huffmanCoder));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * compressedBlocks.size());
+        state.SetBytesProcessed(state.iterations() * compressedBlocks.size() * sizeof(Block));
+    }
+
+    void Kernels::RlcHuffmanCode_Encode(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+        std::vector<RlcHuffmanCode::Symbol> symbols;
+        std::string encoded;
+        for (const Block& block : CollectBlocks(*t_Case.m_Encrypted)) {
+            std::array<RlcHuffmanCode::Symbol, 3> blockSymbols;
+            const uint32_t symbolsCount = RlcCompressor::EncodeRlcSymbols(block[0], block[1], block[2], block[3], blockSymbols);
+
+            if (huffmanCoder.TryEncode(std::span<const RlcHuffmanCode::Symbol>(blockSymbols.data(), symbolsCount), encoded)) {
+                symbols.insert(symbols.end(), blockSymbols.begin(), blockSymbols.begin() + symbolsCount);
+            }
+        }
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(huffmanCoder.Encode(symbols));
+        }
+
+        state.SetItemsProcessed(state.iterations() * symbols.size());
+        /* Size of the produced code. */
+        state.SetBytesProcessed(state.iterations() * (encoded.size() / 8));
+    }
+
+    void Kernels::RlcHuffmanCode_Decode(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+        std::size_t symbolsCount{ 0 };
+        std::string encoded;
+        for (const Block& block : CollectBlocks(*t_Case.m_Encrypted)) {
+            std::array<RlcHuffmanCode::Symbol, 3> blockSymbols;
+            const uint32_t blockSymbolsCount = RlcCompressor::EncodeRlcSymbols(block[0], block[1], block[2], block[3], blockSymbols);
+
+            const std::size_t encodedSize = encoded.size();
+            if (huffmanCoder.TryEncode(std::span<const RlcHuffmanCode::Symbol>(blockSymbols.data(), blockSymbolsCount), encoded)) {
+                symbolsCount += blockSymbolsCount;
+            }
+            else {
+                encoded.resize(encodedSize);
+            }
+        }
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(huffmanCoder.Decode(encoded));
+        }
+
+        state.SetItemsProcessed(state.iterations() * symbolsCount);
+        state.SetBytesProcessed(state.iterations() * (encoded.size() / 8));
+    }
+
+    template <class Params>
+    void Kernels::RunGroupCompressor(benchmark::State& state, const ImageCase& t_Case, const Consts& t_Params)
+    {
+        const std::vector<uint8_t>& dataEmbedKey = BenchData::Instance().GetEmbedKey();
+        const Embedder::Group group = CollectGroup(*t_Case.m_Encrypted, t_Params);
+
+        Embedder::GroupCompressor<Params> groupCompressor(t_Params, dataEmbedKey);
+
+        std::string lsbEncodedBitStream;
+        std::string hashesBitStream;
+
+        const auto compressGroup = [&]() {
+            lsbEncodedBitStream.clear();
+            hashesBitStream.clear();
+
+            for (uint32_t bitIdx = 0; bitIdx < group.rows(); ++bitIdx) {
+                groupCompressor.Append(group(bitIdx, 0));
+            }
+            groupCompressor.Compress(lsbEncodedBitStream, hashesBitStream);
+        };
+
+        /* The first group of the Eigen version initializes the hash matrix, so it's done outside of the measured loop. */
+        compressGroup();
+
+        for (auto _ : state)
+        {
+            compressGroup();
+            benchmark::DoNotOptimize(lsbEncodedBitStream.data());
+            benchmark::DoNotOptimize(hashesBitStream.data());
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * (t_Params.GetGroupSizeBeforeCompression() / 8));
+    }
+
+    void Kernels::Embedder_GroupCompressor(benchmark::State& state, const ImageCase& t_Case)
+    {
+        Consts params;
+        params.UpdateLsbLayers(static_cast<uint16_t>(state.range(0)));
+        Consts::ThreadOverride paramsOverride(params);
+
+        /* The same kernel, that the embedder picks for these parameters. */
+        DispatchEmbeddingParams(params, [&](auto t_Params) {
+            using Params = decltype(t_Params);
+
+            if constexpr (!Params::c_IsSpecialized) {
+                state.SkipWithError("There is no preset for these parameters!");
+            }
+            else {
+                RunGroupCompressor<Params>(state, t_Case, params);
+            }
+        });
+    }
+
+    void Kernels::Embedder_GroupCompressorDynamic(benchmark::State& state, const ImageCase& t_Case)
+    {
+        Consts params;
+        params.UpdateLsbLayers(static_cast<uint16_t>(state.range(0)));
+        Consts::ThreadOverride paramsOverride(params);
+
+        /* Generic Eigen version (CompressCurrentGroup and HashLsbBlock), that is used only for parameters without a preset. */
+        RunGroupCompressor<DynamicEmbeddingParams>(state, t_Case, params);
+    }
+
+    void Kernels::Utils_ShuffleFisherYates(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const std::array<uint32_t, 5> seed = ShuffleSeed(BenchData::Instance().GetEmbedKey());
+
+        /* One bit per pixel, the same order of magnitude as the embedded bitstream. */
+        std::string bitStream;
+        for (const Block& block : CollectBlocks(*t_Case.m_Encrypted)) {
+            for (Color8u pixel : block) {
+                bitStream += (pixel & 1) ? '1' : '0';
+            }
+        }
+
+        for (auto _ : state)
+        {
+            std::seed_seq seq(seed.begin(), seed.end());
+            utils::ShuffleFisherYates(seq, bitStream);
+            benchmark::DoNotOptimize(bitStream.data());
+        }
+
+        state.SetItemsProcessed(state.iterations() * bitStream.size());
+        state.SetBytesProcessed(state.iterations() * bitStream.size());
+    }
+
+    void Kernels::Utils_DeshuffleFisherYates(benchmark::State& state, const ImageCase& t_Case)
+    {
+        const std::array<uint32_t, 5> seed = ShuffleSeed(BenchData::Instance().GetEmbedKey());
+
+        std::string bitStream;
+        for (const Block& block : CollectBlocks(*t_Case.m_Encrypted)) {
+            for (Color8u pixel : block) {
+                bitStream += (pixel & 1) ? '1' : '0';
+            }
+        }
+
+        for (auto _ : state)
+        {
+            std::seed_seq seq(seed.begin(), seed.end());
+            utils::DeshuffleFisherYates(seq, bitStream);
+            benchmark::DoNotOptimize(bitStream.data());
+        }
+
+        state.SetItemsProcessed(state.iterations() * bitStream.size());
+        state.SetBytesProcessed(state.iterations() * bitStream.size());
+    }
+
+    void Kernels::Extractor_ExtractBitStreams(benchmark::State& state, const ImageCase& t_Case)
+    {
+        Consts params;
+        params.UpdateLsbLayers(static_cast<uint16_t>(state.range(0)));
+        Consts::ThreadOverride paramsOverride(params);
+
+        std::vector<uint8_t> dataEmbedKey = BenchData::Instance().GetEmbedKey();
+
+        BmpImage markedImage(*t_Case.m_Encrypted);
+        try
+        {
+            Embedder::Embed(markedImage, BenchData::Instance().GetPayload(), dataEmbedKey, std::nullopt, std::nullopt);
+        }
+        catch (const std::exception& e)
+        {
+            state.SkipWithError(e.what());
+            return;
+        }
+
+        for (auto _ : state)
+        {
+            RlcHuffmanCode huffmanCoder{ consts::huffman::c_DefaultCode };
+            std::vector<uint16_t> rlcCompressedBlocksLengths;
+            std::string rlcCompressedBitStream;
+            std::vector<std::string> lsbCompressedGroups;
+            std::vector<std::string> groupsHashes;
+            std::string lsbsBitStream;
+            std::string userDataBitStream;
+            std::vector<bool> binaryLocationMap;
+
+            Extractor::ExtractBitStreams(markedImage, dataEmbedKey, huffmanCoder, rlcCompressedBlocksLengths, rlcCompressedBitStream,
+                lsbCompressedGroups, groupsHashes, lsbsBitStream, userDataBitStream, binaryLocationMap);
+            benchmark::DoNotOptimize(userDataBitStream.data());
+        }
+
+        const std::size_t pixelsCount = static_cast<std::size_t>(markedImage.GetHeight()) * markedImage.GetWidth();
+        state.SetItemsProcessed(state.iterations() * (pixelsCount / 4));
+        state.SetBytesProcessed(state.iterations() * pixelsCount);
+    }
+
+    void Kernels::CandidateSearch_Recover(benchmark::State& state, const ImageCase& t_Case)
+    {
+        Consts params;
+        params.UpdateLsbLayers(static_cast<uint16_t>(state.range(0)));
+        Consts::ThreadOverride paramsOverride(params);
+
+        const std::vector<uint8_t>& dataEmbedKey = BenchData::Instance().GetEmbedKey();
+
+        BmpImage markedImage(*t_Case.m_Encrypted);
+        try
+        {
+            Embedder::Embed(markedImage, BenchData::Instance().GetPayload(), dataEmbedKey, std::nullopt, std::nullopt);
+        }
+        catch (const std::exception& e)
+        {
+            state.SkipWithError(e.what());
+            return;
+        }
+
+        const Extractor::RawBitStream rawBitStream = Extractor::ExtractRawBitStream(markedImage);
+
+        RlcHuffmanCode huffmanCoder{ consts::huffman::c_DefaultCode };
+        std::vector<std::string> lsbCompressedGroups;
+        std::vector<std::string> groupsHashes;
+        std::string lsbsBitStream;
+        Extractor::ParseBitStreams(rawBitStream, dataEmbedKey, huffmanCoder, std::nullopt, std::nullopt, lsbCompressedGroups, groupsHashes, lsbsBitStream, std::nullopt);
+
+        if (lsbCompressedGroups.empty()) {
+            state.SkipWithError("Image doesn't have LSB-compressed groups!");
+            return;
+        }
+
+        /* The same blocks, as Extractor::ProbeRawBitStream collects: \omega_2 blocks with the original top-left LSB. */
+        const std::size_t groupedBlocksCount = lsbCompressedGroups.size() * static_cast<std::size_t>(params.GetLambda());
+        std::vector<CandidateSearch::PackedBlock> omegaTwoEncryptedBlocks;
+        omegaTwoEncryptedBlocks.reserve(groupedBlocksCount);
+
+        uint32_t currBlockIdx{ 0 };
+        for (const Block& block : CollectBlocks(markedImage)) {
+            if (omegaTwoEncryptedBlocks.size() == groupedBlocksCount) {
+                break;
+            }
+
+            if (!rawBitStream.m_BinaryLocationMap[currBlockIdx]) {
+                omegaTwoEncryptedBlocks.push_back(CandidateSearch::PackBlock(
+                    utils::ClearLastNBits(block[0], 1) | ((lsbsBitStream[currBlockIdx] == '1') ? 1 : 0), block[1], block[2], block[3]
+                ));
+            }
+
+            currBlockIdx++;
+        }
+
+        CandidateSearch candidateSearch = Extractor::CreateCandidateSearch(dataEmbedKey);
+
+        /* Each iteration recovers the next group, search overwrites LSBs of the blocks, so it works on a copy. */
+        std::vector<CandidateSearch::PackedBlock> groupBlocks(params.GetLambda());
+        Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> restoredGroup;
+        std::size_t groupIdx{ 0 };
+
+        for (auto _ : state)
+        {
+            std::copy_n(omegaTwoEncryptedBlocks.begin() + groupIdx * params.GetLambda(), params.GetLambda(), groupBlocks.begin());
+
+            if (!candidateSearch.Recover(lsbCompressedGroups[groupIdx], groupsHashes[groupIdx], groupBlocks, huffmanCoder, restoredGroup)) {
+                state.SkipWithError("Group can't be recovered!");
+                break;
+            }
+
+            groupIdx = (groupIdx + 1) % lsbCompressedGroups.size();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * params.GetLambda() * sizeof(CandidateSearch::PackedBlock));
+    }
+
+    void Kernels::Register()
+    {
+        BenchData& data = BenchData::Instance();
+
+        const auto registerKernel = [&data](const std::string& t_Name, void (*t_Kernel)(benchmark::State&, const ImageCase&), bool t_LsbLayersArgument) {
+            for (auto* bench : data.RegisterForEachImage(t_Name, ImageSet::ENCRYPTED, t_Kernel)) {
+                bench->Unit(benchmark::kMicrosecond);
+
+                if (t_LsbLayersArgument) {
+                    bench->ArgName("lsbLayers")->DenseRange(1, 3);
+                }
+            }
+        };
+
+        registerKernel("Kernel_RlcCompressor_TryCompress", RlcCompressor_TryCompress, false);
+        registerKernel("Kernel_RlcCompressor_Decompress", RlcCompressor_Decompress, false);
+        registerKernel("Kernel_RlcHuffmanCode_Encode", RlcHuffmanCode_Encode, false);
+        registerKernel("Kernel_RlcHuffmanCode_Decode", RlcHuffmanCode_Decode, false);
+        registerKernel("Kernel_Embedder_GroupCompressor", Embedder_GroupCompressor, true);
+        registerKernel("Kernel_Embedder_GroupCompressorDynamic", Embedder_GroupCompressorDynamic, true);
+        registerKernel("Kernel_Utils_ShuffleFisherYates", Utils_ShuffleFisherYates, false);
+        registerKernel("Kernel_Utils_DeshuffleFisherYates", Utils_DeshuffleFisherYates, false);
+        registerKernel("Kernel_Extractor_ExtractBitStreams", Extractor_ExtractBitStreams, true);
+        registerKernel("Kernel_CandidateSearch_Recover", CandidateSearch_Recover, true);
+    }
+}
+
+static const bool s_KernelsSuite = rdh::bench::BenchData::AddSuite(rdh::bench::Kernels::Register);
@@ -1,39 +1,36 @@
 #include "benchmark/include/benchmark/benchmark.h"
 
-#include "utils.h"
+#include "bench_data.h"
+
 #include "image/bmp_image.h"
-#include "encryptor/encryptor.h"
 
 using namespace rdh;
+using namespace rdh::bench;
+
+static void Loader_Load_bench(benchmark::State& state, const ImageCase& t_Case)
+{
+    const std::string imagePath = t_Case.m_OriginalPath.string();
 
-static void Loader_Load_512x512_bench(benchmark::State& state) {
     for (auto _ : state)
     {
-        benchmark::DoNotOptimize(rdh::BmpImage("..\\..\\..\\..\\images\\original\\airplane.bmp"));
+        benchmark::DoNotOptimize(rdh::BmpImage(imagePath));
     }
 }
-BENCHMARK(Loader_Load_512x512_bench)->Unit(benchmark::kMillisecond);
 
-static void Loader_Load_1024x1024_bench(benchmark::State& state) {
+static void Loader_Copy_bench(benchmark::State& state, const ImageCase& t_Case)
+{
     for (auto _ : state)
     {
-        benchmark::DoNotOptimize(rdh::BmpImage("..\\..\\..\\..\\images\\original\\liberty1024x1024.bmp"));
+        benchmark::DoNotOptimize(rdh::BmpImage(t_Case.m_Original));
     }
 }
-BENCHMARK(Loader_Load_1024x1024_bench)->Unit(benchmark::kMillisecond);
 
-static void Loader_Load_2048x2048_bench(benchmark::State& state) {
-    for (auto _ : state)
-    {
-        benchmark::DoNotOptimize(rdh::BmpImage("..\\..\\..\\..\\images\\original\\man2048x2048.bmp"));
+static const bool s_LoaderSuite = BenchData::AddSuite([]() {
+    for (auto* bench : BenchData::Instance().RegisterForEachImage("Loader_Load", ImageSet::ORIGINAL, Loader_Load_bench)) {
+        bench->Unit(benchmark::kMillisecond);
     }
-}
-BENCHMARK(Loader_Load_2048x2048_bench)->Unit(benchmark::kMillisecond);
 
-static void Loader_Load_4096x4096_bench(benchmark::State& state) {
-    for (auto _ : state)
-    {
-        benchmark::DoNotOptimize(rdh::BmpImage("..\\..\\..\\..\\images\\original\\man4096x4096.bmp"));
+    for (auto* bench : BenchData::Instance().RegisterForEachImage("Loader_Copy", ImageSet::ORIGINAL, Loader_Copy_bench)) {
+        bench->Unit(benchmark::kMicrosecond);
     }
-}
-BENCHMARK(Loader_Load_4096x4096_bench)->Unit(benchmark::kMillisecond);
+});
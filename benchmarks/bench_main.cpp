@@ -1,17 +1,36 @@
 #include "benchmark/include/benchmark/benchmark.h"
 
+#include <iostream>
+
 #include <boost/log/trivial.hpp>
 
 #include "logging.h"
-#include "reference_images.h"
+#include "bench_data.h"
+#include "bench_memory.h"
+#include "perf_counters.h"
 
 int main(int argc, char** argv)
 {
     /* Initialize logger in a way that it will write nothing to the stdout */
     rdh::log::InitLogger(boost::log::trivial::severity_level::fatal);
 
-    References::GetInstance();
+    if (!rdh::bench::BenchData::Instance().Init(argc, argv)) {
+        std::cerr << "Benchmark data wasn't found, or flags are malformed! Pass --rdh_data_root=<repository root> or set RDH_DATA_ROOT." << std::endl;
+        return 1;
+    }
+
+    if (rdh::bench::BenchData::Instance().IsPerfCountersEnabled() && !rdh::bench::PerfMonitor::Instance().Enable()) {
+        std::cerr << "Hardware counters aren't available (perf_event_open failed, check /proc/sys/kernel/perf_event_paranoid), running without them." << std::endl;
+    }
+
+    rdh::bench::BenchData::RegisterSuites();
+
+    rdh::bench::BenchMemoryManager memoryManager;
+    if (rdh::bench::BenchData::Instance().IsMemoryStatsEnabled()) {
+        ::benchmark::RegisterMemoryManager(&memoryManager);
+    }
 
     ::benchmark::Initialize(&argc, argv);
     ::benchmark::RunSpecifiedBenchmarks();
-}
\ No newline at end of file
+    ::benchmark::RegisterMemoryManager(nullptr);
+}
@@ -0,0 +1,33 @@
+#include "bench_memory.h"
+
+namespace rdh::bench {
+    void BenchMemoryManager::Start()
+    {
+        m_RssSampler = std::make_unique<PeakRssSampler>();
+
+        MemoryStats::ResetPeakHeapBytes();
+        m_StartHeapBytes = MemoryStats::GetHeapBytes();
+        m_StartAllocations = MemoryStats::GetAllocations();
+    }
+
+    void BenchMemoryManager::Stop(Result& t_Result)
+    {
+        const AllocationCounters allocations = MemoryStats::GetAllocations() - m_StartAllocations;
+        const uint64_t peakHeapBytes = MemoryStats::GetPeakHeapBytes();
+        const uint64_t heapBytes = MemoryStats::GetHeapBytes();
+
+        m_RssSampler->Stop();
+
+        if (MemoryStats::IsAllocationTrackingEnabled()) {
+            t_Result.num_allocs = static_cast<int64_t>(allocations.m_Count);
+            t_Result.total_allocated_bytes = static_cast<int64_t>(allocations.m_Bytes);
+            t_Result.max_bytes_used = static_cast<int64_t>(peakHeapBytes - m_StartHeapBytes);
+            t_Result.net_heap_growth = static_cast<int64_t>(heapBytes) - static_cast<int64_t>(m_StartHeapBytes);
+        }
+        else {
+            t_Result.max_bytes_used = static_cast<int64_t>(m_RssSampler->GetPeakRss() - m_RssSampler->GetStartRss());
+        }
+
+        m_RssSampler.reset();
+    }
+}
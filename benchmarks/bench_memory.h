@@ -0,0 +1,30 @@
+#pragma once
+
+#include "benchmark/include/benchmark/benchmark.h"
+
+#include <memory>
+
+#include "memory_stats.h"
+
+namespace rdh::bench {
+    /**
+     * @brief Memory manager, that Google Benchmark uses for an additional run of each benchmark (--rdh_memory_stats=true).
+     * Results are written by the JSON reporter (--benchmark_format=json or --benchmark_out=<file>):
+     * allocs_per_iter, total_allocated_bytes, max_bytes_used and net_heap_growth.
+     * With the counting operator new/delete (ENABLE_ALLOCATION_STATS), max_bytes_used is the peak heap growth during the run.
+     * Otherwise only max_bytes_used is available, and it's the peak RSS growth, sampled by PeakRssSampler.
+    */
+    class BenchMemoryManager : public benchmark::MemoryManager {
+    public:
+        void Start() override;
+        void Stop(Result& t_Result) override;
+
+        /* Google Benchmark before 1.8 calls the pointer overload. */
+        void Stop(Result* t_Result) { Stop(*t_Result); }
+
+    private:
+        AllocationCounters m_StartAllocations;
+        uint64_t m_StartHeapBytes{ 0 };
+        std::unique_ptr<PeakRssSampler> m_RssSampler;
+    };
+}
@@ -0,0 +1,225 @@
+#include "benchmark/include/benchmark/benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "bench_data.h"
+#include "perf_counters.h"
+#include "synthetic_image.h"
+
+#include "embedder/consts.h"
+#include "embedder/embedder.h"
+#include "encryptor/encryptor.h"
+#include "extractor/extractor.h"
+
+using namespace rdh;
+using namespace rdh::bench;
+
+/**
+ * Size/thread scaling matrix on synthetic images: 512x512 up to --rdh_max_image_size (16384x16384 by default),
+ * crossed with thread counts from 1 to the number of hardware threads. Images are embedded in tiled mode,
+ * because tiles are the unit of parallelism of the embedder and extractor.
+ * Encryption runs on every kind of images. Noise has no RLC-compressible blocks, so it can't hold any payload,
+ * and embedding and extraction run only on the gradient (best case) and natural-like images.
+ */
+static constexpr uint16_t c_ScalingTileSize{ 256 };
+static const std::vector<SyntheticImage::Kind> c_AllImageKinds{
+    SyntheticImage::Kind::GRADIENT, SyntheticImage::Kind::NOISE, SyntheticImage::Kind::NATURAL
+};
+static const std::vector<SyntheticImage::Kind> c_EmbeddableImageKinds{ SyntheticImage::Kind::GRADIENT, SyntheticImage::Kind::NATURAL };
+
+/**
+ * @brief Time per iteration of the single-threaded runs, by operation (with the image kind) and image size.
+ */
+static std::map<std::pair<std::string, uint32_t>, double> s_SingleThreadSeconds;
+
+/**
+ * @brief Parameters of the scaling runs: tiled mode and the thread count from the benchmark arguments.
+ */
+static Consts ScalingParams(const benchmark::State& state)
+{
+    Consts params;
+    params.UpdateTileSize(c_ScalingTileSize);
+    params.UpdateThreadsCount(static_cast<uint16_t>(state.range(1)));
+
+    return params;
+}
+
+/**
+ * @brief Encrypted synthetic image of size t_Size with the example payload embedded (tiled mode).
+ * Embedding doesn't depend on the number of threads, so it's done once per kind and size.
+ */
+static const BmpImage& MarkedImage(SyntheticImage::Kind t_Kind, uint32_t t_Size)
+{
+    static std::map<std::pair<SyntheticImage::Kind, uint32_t>, std::unique_ptr<BmpImage>> s_MarkedImages;
+
+    auto& markedImage = s_MarkedImages[{ t_Kind, t_Size }];
+    if (!markedImage) {
+        auto newMarkedImage = std::make_unique<BmpImage>(BenchData::Instance().GetSyntheticImage(t_Kind, t_Size, true));
+        Embedder::Embed(*newMarkedImage, BenchData::Instance().GetPayload(), BenchData::Instance().GetEmbedKey(), std::nullopt, std::nullopt);
+        markedImage = std::move(newMarkedImage);
+    }
+
+    return *markedImage;
+}
+
+/**
+ * @brief Runs t_Operation on a fresh copy of the t_Input result in each iteration. Only the operation itself is timed (manual time,
+ * so that the wall time of all threads is measured). Reports throughput in pixels per second, and, for more than one thread,
+ * speedup and parallel efficiency relative to the single-threaded run of the same operation, image kind and size.
+ * If the input can't be created, or the operation throws, the benchmark is skipped with the error.
+ */
+static void RunScaling(benchmark::State& state, const std::string& t_Operation, SyntheticImage::Kind t_Kind,
+    const std::function<const BmpImage&()>& t_Input, const std::function<void(BmpImage&)>& t_Body)
+{
+    const uint32_t size = static_cast<uint32_t>(state.range(0));
+    const uint32_t threadsCount = static_cast<uint32_t>(state.range(1));
+    const std::string operation = t_Operation + "/" + SyntheticImage::KindName(t_Kind);
+
+    const BmpImage* input{ nullptr };
+    try
+    {
+        input = &t_Input();
+    }
+    catch (const std::exception& e)
+    {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    /* Hardware counters shouldn't include generation and embedding of the (cached) input. */
+    PerfMonitor::Instance().Restart();
+
+    double totalSeconds{ 0 };
+    for (auto _ : state)
+    {
+        BmpImage image(*input);
+
+        const auto start = std::chrono::steady_clock::now();
+        try
+        {
+            t_Body(image);
+        }
+        catch (const std::exception& e)
+        {
+            state.SkipWithError(e.what());
+            break;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        state.SetIterationTime(seconds);
+        totalSeconds += seconds;
+    }
+
+    if (state.iterations() == 0) {
+        return;
+    }
+
+    /* One item is one pixel. */
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size) * size);
+
+    const double secondsPerIteration = totalSeconds / state.iterations();
+    if (threadsCount == 1) {
+        s_SingleThreadSeconds[{ operation, size }] = secondsPerIteration;
+    }
+    else if (auto baselineIt = s_SingleThreadSeconds.find({ operation, size }); baselineIt != s_SingleThreadSeconds.end()) {
+        const double speedup = baselineIt->second / secondsPerIteration;
+        state.counters["speedup"] = speedup;
+        state.counters["efficiency"] = speedup / threadsCount;
+    }
+}
+
+static void Scaling_Encrypt_bench(benchmark::State& state, SyntheticImage::Kind t_Kind)
+{
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
+
+    const auto input = [&]() -> const BmpImage& { return BenchData::Instance().GetSyntheticImage(t_Kind, state.range(0)); };
+    RunScaling(state, "Encrypt", t_Kind, input, [&](BmpImage& t_Image) {
+        benchmark::DoNotOptimize(Encryptor::Encrypt(t_Image, encryptionKey));
+    });
+}
+
+static void Scaling_Embed_bench(benchmark::State& state, SyntheticImage::Kind t_Kind)
+{
+    Consts params = ScalingParams(state);
+    Consts::ThreadOverride paramsOverride(params);
+
+    const auto input = [&]() -> const BmpImage& { return BenchData::Instance().GetSyntheticImage(t_Kind, state.range(0), true); };
+    RunScaling(state, "Embed", t_Kind, input, [](BmpImage& t_Image) {
+        Embedder::Embed(t_Image, BenchData::Instance().GetPayload(), BenchData::Instance().GetEmbedKey(), std::nullopt, std::nullopt);
+    });
+}
+
+static void Scaling_ExtractData_bench(benchmark::State& state, SyntheticImage::Kind t_Kind)
+{
+    Consts params = ScalingParams(state);
+    Consts::ThreadOverride paramsOverride(params);
+
+    std::vector<uint8_t> dataEmbedKey = BenchData::Instance().GetEmbedKey();
+
+    RunScaling(state, "ExtractData", t_Kind, [&]() -> const BmpImage& { return MarkedImage(t_Kind, state.range(0)); }, [&](BmpImage& t_Image) {
+        Extractor::ExtractData(t_Image, "", dataEmbedKey);
+    });
+}
+
+static void Scaling_RecoverImage_bench(benchmark::State& state, SyntheticImage::Kind t_Kind)
+{
+    Consts params = ScalingParams(state);
+    Consts::ThreadOverride paramsOverride(params);
+
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
+
+    RunScaling(state, "RecoverImage", t_Kind, [&]() -> const BmpImage& { return MarkedImage(t_Kind, state.range(0)); }, [&](BmpImage& t_Image) {
+        Extractor::RecoverImage(t_Image, "", encryptionKey);
+    });
+}
+
+static void Scaling_RecoverImageExtractData_bench(benchmark::State& state, SyntheticImage::Kind t_Kind)
+{
+    Consts params = ScalingParams(state);
+    Consts::ThreadOverride paramsOverride(params);
+
+    std::vector<uint8_t> dataEmbedKey = BenchData::Instance().GetEmbedKey();
+    std::vector<uint8_t> encryptionKey = BenchData::Instance().GetEncryptionKey();
+
+    RunScaling(state, "RecoverImageExtractData", t_Kind, [&]() -> const BmpImage& { return MarkedImage(t_Kind, state.range(0)); }, [&](BmpImage& t_Image) {
+        Extractor::RecoverImageAndExract(t_Image, "", "", dataEmbedKey, encryptionKey);
+    });
+}
+
+static const bool s_ScalingSuite = BenchData::AddSuite([]() {
+    const uint32_t hardwareThreads = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+
+    /* 1, 2, 4, ... and the number of hardware threads. */
+    std::vector<int64_t> threadCounts;
+    for (uint32_t threadsCount = 1; threadsCount < hardwareThreads; threadsCount *= 2) {
+        threadCounts.push_back(threadsCount);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    const auto registerScaling = [&](const std::string& t_Name, void (*t_Bench)(benchmark::State&, SyntheticImage::Kind),
+        const std::vector<SyntheticImage::Kind>& t_Kinds, bool t_IsThreaded) {
+        for (SyntheticImage::Kind kind : t_Kinds) {
+            auto* bench = BenchData::Register(t_Name + "/" + SyntheticImage::KindName(kind), [t_Bench, kind](benchmark::State& state) {
+                t_Bench(state, kind);
+            });
+            bench->ArgNames({ "size", "threads" })->UseManualTime()->Unit(benchmark::kMillisecond);
+
+            for (uint32_t size = 512; size <= std::min<uint32_t>(BenchData::Instance().GetMaxImageSize(), 16384); size *= 2) {
+                /* Encryption is single-threaded. */
+                for (int64_t threadsCount : t_IsThreaded ? threadCounts : std::vector<int64_t>{ 1 }) {
+                    bench->Args({ size, threadsCount });
+                }
+            }
+        }
+    };
+
+    registerScaling("Scaling_Encrypt", Scaling_Encrypt_bench, c_AllImageKinds, false);
+    registerScaling("Scaling_Embed", Scaling_Embed_bench, c_EmbeddableImageKinds, true);
+    registerScaling("Scaling_ExtractData", Scaling_ExtractData_bench, c_EmbeddableImageKinds, true);
+    registerScaling("Scaling_RecoverImage", Scaling_RecoverImage_bench, c_EmbeddableImageKinds, true);
+    registerScaling("Scaling_RecoverImageExtractData", Scaling_RecoverImageExtractData_bench, c_EmbeddableImageKinds, true);
+});
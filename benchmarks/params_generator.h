@@ -1,18 +1,32 @@
 #pragma once
 
+#include "embedder/consts.h"
+#include "embedder/params_grid.h"
+
 static void CustomArguments(benchmark::internal::Benchmark* b)
 {
-    for (uint16_t threshold : { 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24 })
+    for (uint16_t threshold : rdh::consts::grid::c_Thresholds)
     {
-        for (uint16_t alpha : { 4, 5, 6 })
+        for (uint16_t alpha : rdh::consts::grid::c_Alphas)
         {
-            for (uint16_t lambda : { 60, 80, 100, 150, 200, 300, 400 })
+            for (uint16_t lambda : rdh::consts::grid::c_Lambdas)
             {
-                for (uint16_t lsbLayers : { 1, 2, 3 })
+                for (uint16_t lsbLayers : rdh::consts::grid::c_LsbLayers)
                 {
                     b->Args({ threshold, alpha, lambda, lsbLayers });
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Applies arguments generated by CustomArguments to the global parameters.
+ */
+static void ApplyCustomArguments(const benchmark::State& state)
+{
+    rdh::Consts::Instance().UpdateThreshold(state.range(0));
+    rdh::Consts::Instance().UpdateAlpha(state.range(1));
+    rdh::Consts::Instance().UpdateLambda(state.range(2));
+    rdh::Consts::Instance().UpdateLsbLayers(state.range(3));
+}
@@ -0,0 +1,180 @@
+#include "perf_counters.h"
+
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rdh::bench {
+    PerfCounters::PerfCounters(bool t_Inherit)
+    {
+        m_Fds.fill(-1);
+
+#if defined(__linux__)
+        constexpr std::array<uint64_t, EVENTS_COUNT> c_Configs{
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (uint32_t eventIdx = 0; eventIdx < EVENTS_COUNT; ++eventIdx) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = c_Configs[eventIdx];
+            attr.inherit = t_Inherit ? 1 : 0;
+            /* User space only, so that it works with the default perf_event_paranoid. */
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            /* Calling thread, any CPU. */
+            m_Fds[eventIdx] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#else
+        (void)t_Inherit;
+#endif
+    }
+
+    PerfCounters::~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int fd : m_Fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    bool PerfCounters::IsValid() const
+    {
+        for (int fd : m_Fds) {
+            if (fd < 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    PerfCounters::Values PerfCounters::Read() const
+    {
+        Values values{};
+
+#if defined(__linux__)
+        for (uint32_t eventIdx = 0; eventIdx < EVENTS_COUNT; ++eventIdx) {
+            /* Value, time enabled and time running. */
+            std::array<uint64_t, 3> data{};
+            if (m_Fds[eventIdx] < 0 || read(m_Fds[eventIdx], data.data(), sizeof(data)) != sizeof(data) || data[2] == 0) {
+                continue;
+            }
+
+            values[eventIdx] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+#endif
+
+        return values;
+    }
+
+    PerfMonitor& PerfMonitor::Instance()
+    {
+        static PerfMonitor s_Instance;
+        return s_Instance;
+    }
+
+    bool PerfMonitor::Enable()
+    {
+        if (!PerfCounters(false).IsValid()) {
+            return false;
+        }
+
+        m_Enabled = true;
+        PhaseScope::SetListener(this);
+        return true;
+    }
+
+    void PerfMonitor::Run(benchmark::State& t_State, const std::function<void(benchmark::State&)>& t_Body)
+    {
+        if (!m_Enabled) {
+            t_Body(t_State);
+            return;
+        }
+
+        /* Inherited, so that the worker threads of the embedder and extractor are counted. */
+        PerfCounters counters(true);
+        m_Counters = &counters;
+        Restart();
+
+        t_Body(t_State);
+
+        const PerfCounters::Values start = m_Start;
+        const PerfCounters::Values end = counters.Read();
+        m_Counters = nullptr;
+
+        if (t_State.iterations() == 0) {
+            return;
+        }
+
+        const auto perIteration = [](double t_Value) { return benchmark::Counter(t_Value, benchmark::Counter::kAvgIterations); };
+        const auto perKiloInstructions = [](double t_Value, double t_Instructions) { return (t_Instructions > 0) ? 1000.0 * t_Value / t_Instructions : 0.0; };
+
+        const double cycles = end[PerfCounters::CYCLES] - start[PerfCounters::CYCLES];
+        const double instructions = end[PerfCounters::INSTRUCTIONS] - start[PerfCounters::INSTRUCTIONS];
+
+        t_State.counters["cycles"] = perIteration(cycles);
+        t_State.counters["instructions"] = perIteration(instructions);
+        t_State.counters["IPC"] = (cycles > 0) ? instructions / cycles : 0.0;
+        t_State.counters["cache_misses"] = perIteration(end[PerfCounters::CACHE_MISSES] - start[PerfCounters::CACHE_MISSES]);
+        t_State.counters["branch_misses"] = perIteration(end[PerfCounters::BRANCH_MISSES] - start[PerfCounters::BRANCH_MISSES]);
+
+        std::lock_guard<std::mutex> lock(m_PhasesMutex);
+        for (const auto& [phase, values] : m_Phases) {
+            t_State.counters[phase + ".cycles"] = perIteration(values[PerfCounters::CYCLES]);
+            t_State.counters[phase + ".IPC"] = (values[PerfCounters::CYCLES] > 0) ? values[PerfCounters::INSTRUCTIONS] / values[PerfCounters::CYCLES] : 0.0;
+            t_State.counters[phase + ".cache_MPKI"] = perKiloInstructions(values[PerfCounters::CACHE_MISSES], values[PerfCounters::INSTRUCTIONS]);
+            t_State.counters[phase + ".branch_MPKI"] = perKiloInstructions(values[PerfCounters::BRANCH_MISSES], values[PerfCounters::INSTRUCTIONS]);
+        }
+    }
+
+    void PerfMonitor::Restart()
+    {
+        if (m_Counters == nullptr) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_PhasesMutex);
+        m_Phases.clear();
+        m_Start = m_Counters->Read();
+    }
+
+    namespace {
+        /* Counters of the current thread (opened by its first phase) and values at the start of its open phases. */
+        thread_local std::unique_ptr<PerfCounters> s_ThreadCounters;
+        thread_local std::vector<PerfCounters::Values> s_PhaseStarts;
+    }
+
+    void PerfMonitor::OnPhaseBegin(const char*)
+    {
+        if (!s_ThreadCounters) {
+            s_ThreadCounters = std::make_unique<PerfCounters>(false);
+        }
+
+        s_PhaseStarts.push_back(s_ThreadCounters->Read());
+    }
+
+    void PerfMonitor::OnPhaseEnd(const char* t_Phase)
+    {
+        const PerfCounters::Values end = s_ThreadCounters->Read();
+        const PerfCounters::Values start = s_PhaseStarts.back();
+        s_PhaseStarts.pop_back();
+
+        std::lock_guard<std::mutex> lock(m_PhasesMutex);
+        PerfCounters::Values& total = m_Phases[t_Phase];
+        for (uint32_t eventIdx = 0; eventIdx < PerfCounters::EVENTS_COUNT; ++eventIdx) {
+            total[eventIdx] += end[eventIdx] - start[eventIdx];
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "benchmark/include/benchmark/benchmark.h"
+
+#include <array>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "phase_scope.h"
+
+namespace rdh::bench {
+    /**
+     * @brief Hardware counters of the calling thread, opened using perf_event_open (Linux only, no libpfm).
+     * Counters are opened separately (not as a group), because groups can't be inherited by the new threads.
+    */
+    class PerfCounters {
+    public:
+        enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, EVENTS_COUNT };
+
+        using Values = std::array<double, EVENTS_COUNT>;
+
+        /**
+         * @brief Opens and starts the counters.
+         * @param t_Inherit if set, threads, created by the calling thread after this call, are counted as well
+         * (their counts are added, when they exit).
+        */
+        explicit PerfCounters(bool t_Inherit);
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        /**
+         * @brief Checks whether all of the counters were opened.
+        */
+        bool IsValid() const;
+
+        /**
+         * @brief Current counter values, scaled up, if the kernel had to multiplex the counters.
+        */
+        Values Read() const;
+
+    private:
+        std::array<int, EVENTS_COUNT> m_Fds;
+    };
+
+    /**
+     * @brief Collects hardware counters of each benchmark (--rdh_perf_counters=true) and of each embedder/extractor phase,
+     * and reports them as benchmark counters: per-iteration cycles, instructions, cache and branch misses of the whole benchmark,
+     * and for each phase (e.g. Embed.CompressBlocks) its cycles, IPC, and cache/branch misses per thousand instructions.
+     * Low IPC with many cache misses points to a memory-bound phase, with many branch misses - to a branch-bound one.
+    */
+    class PerfMonitor : public PhaseListener {
+    public:
+        static PerfMonitor& Instance();
+
+        /**
+         * @brief Starts collecting counters in Run, and installs itself as the phase listener.
+         * @return false, if the hardware counters can't be opened (not Linux, no PMU or perf_event_paranoid is too strict).
+        */
+        bool Enable();
+
+        bool IsEnabled() const { return m_Enabled; }
+
+        /**
+         * @brief Runs the benchmark body, and adds counters to its state (if enabled).
+         * Counters include everything, that the body does after the last Restart (including paused parts), phases - only the phases themselves.
+        */
+        void Run(benchmark::State& t_State, const std::function<void(benchmark::State&)>& t_Body);
+
+        /**
+         * @brief Drops counters, that were collected so far by the running benchmark. Call it after an expensive setup
+         * (e.g. embedding before the extraction benchmarks), so that it isn't reported.
+        */
+        void Restart();
+
+        void OnPhaseBegin(const char* t_Phase) override;
+        void OnPhaseEnd(const char* t_Phase) override;
+
+    private:
+        PerfMonitor() = default;
+
+        bool m_Enabled{ false };
+
+        /* Counters of the running benchmark and their values at its start. */
+        const PerfCounters* m_Counters{ nullptr };
+        PerfCounters::Values m_Start{};
+
+        /* Counters of all of the phases, that have ended since the start of the current benchmark. */
+        std::mutex m_PhasesMutex;
+        std::map<std::string, PerfCounters::Values> m_Phases;
+    };
+}
@@ -0,0 +1,117 @@
+#include "synthetic_image.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace rdh::bench {
+    BmpImage SyntheticImage::Generate(Kind t_Kind, uint32_t t_Height, uint32_t t_Width, uint64_t t_Seed)
+    {
+        if (t_Height == 0 || t_Width == 0 || t_Height % 2 != 0 || t_Width % 2 != 0) {
+            throw std::invalid_argument("Synthetic image dimensions should be positive and divisible by 2!");
+        }
+
+        BmpImage image(t_Height, t_Width);
+        std::vector<float> row(t_Width);
+
+        /* Gradient direction and the octaves of the natural image depend on the seed. */
+        const float angle = static_cast<float>(Mix(t_Seed) >> 40) / static_cast<float>(1 << 24) * 6.2831853f;
+        const float dirY = std::sin(angle) / static_cast<float>(std::abs(std::sin(angle)) * t_Height + std::abs(std::cos(angle)) * t_Width);
+        const float dirX = std::cos(angle) / static_cast<float>(std::abs(std::sin(angle)) * t_Height + std::abs(std::cos(angle)) * t_Width);
+        const float gradientOffset = 0.5f - 0.5f * (dirY * t_Height + dirX * t_Width);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            switch (t_Kind) {
+            case Kind::GRADIENT:
+                for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                    row[imgX] = 255.0f * (gradientOffset + dirY * imgY + dirX * imgX);
+                }
+                break;
+
+            case Kind::NOISE:
+                std::fill(row.begin(), row.end(), 0.0f);
+                AddValueNoiseRow(row, imgY, t_Seed, 0, 4, 127.5f);
+                for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                    row[imgX] += 127.5f * LatticeValue(t_Seed, 1, imgY, imgX);
+                }
+                break;
+
+            case Kind::NATURAL:
+            {
+                /* Amplitude is proportional to the cell size (1/f spectrum), the biggest cells form the composition. */
+                const uint32_t maxCellSize = std::clamp<uint32_t>(std::bit_floor(std::min(t_Height, t_Width)) / 2, 2, 256);
+
+                float amplitudesSum{ 0 };
+                for (uint32_t cellSize = maxCellSize; cellSize >= 2; cellSize /= 2) {
+                    amplitudesSum += static_cast<float>(cellSize);
+                }
+
+                std::fill(row.begin(), row.end(), 0.0f);
+                uint32_t octave{ 0 };
+                for (uint32_t cellSize = maxCellSize; cellSize >= 2; cellSize /= 2, ++octave) {
+                    AddValueNoiseRow(row, imgY, t_Seed, octave, cellSize, 235.0f * static_cast<float>(cellSize) / amplitudesSum);
+                }
+
+                /* Sensor-like noise of a few levels. */
+                for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                    row[imgX] += 10.0f + 6.0f * (LatticeValue(t_Seed, octave, imgY, imgX) - 0.5f);
+                }
+                break;
+            }
+            }
+
+            std::vector<Color8u>& pixels = image.GetImageMatrix().GetRow(imgY);
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                pixels[imgX] = static_cast<Color8u>(std::clamp(std::lround(row[imgX]), 0L, 255L));
+            }
+        }
+
+        return image;
+    }
+
+    std::string SyntheticImage::KindName(Kind t_Kind)
+    {
+        switch (t_Kind) {
+        case Kind::GRADIENT:
+            return "Gradient";
+        case Kind::NOISE:
+            return "Noise";
+        case Kind::NATURAL:
+            return "Natural";
+        }
+
+        return "Unknown";
+    }
+
+    float SyntheticImage::LatticeValue(uint64_t t_Seed, uint32_t t_Octave, uint32_t t_Y, uint32_t t_X)
+    {
+        const uint64_t hash = Mix(Mix(t_Seed ^ (static_cast<uint64_t>(t_Octave) << 56)) ^ ((static_cast<uint64_t>(t_Y) << 32) | t_X));
+        return static_cast<float>(hash >> 40) / static_cast<float>(1 << 24);
+    }
+
+    void SyntheticImage::AddValueNoiseRow(std::vector<float>& t_Row, uint32_t t_Y, uint64_t t_Seed, uint32_t t_Octave, uint32_t t_CellSize, float t_Amplitude)
+    {
+        const uint32_t latticeY = t_Y / t_CellSize;
+        const float fracY = static_cast<float>(t_Y % t_CellSize) / t_CellSize;
+        /* Smoothstep hides the lattice. */
+        const float weightY = fracY * fracY * (3.0f - 2.0f * fracY);
+
+        /* Lattice row, interpolated vertically once per lattice column. */
+        const uint32_t latticeWidth = static_cast<uint32_t>(t_Row.size()) / t_CellSize + 2;
+        std::vector<float> lattice(latticeWidth);
+        for (uint32_t latticeX = 0; latticeX < latticeWidth; ++latticeX) {
+            const float top = LatticeValue(t_Seed, t_Octave, latticeY, latticeX);
+            const float bottom = LatticeValue(t_Seed, t_Octave, latticeY + 1, latticeX);
+            lattice[latticeX] = top + (bottom - top) * weightY;
+        }
+
+        for (uint32_t imgX = 0; imgX < t_Row.size(); ++imgX) {
+            const uint32_t latticeX = imgX / t_CellSize;
+            const float fracX = static_cast<float>(imgX % t_CellSize) / t_CellSize;
+            const float weightX = fracX * fracX * (3.0f - 2.0f * fracX);
+
+            t_Row[imgX] += t_Amplitude * (lattice[latticeX] + (lattice[latticeX + 1] - lattice[latticeX]) * weightX);
+        }
+    }
+}
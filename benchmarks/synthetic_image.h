@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image/bmp_image.h"
+
+namespace rdh::bench {
+    /**
+     * @brief Deterministic generator of grayscale test images of any (even) size.
+     * The same kind, size and seed always produce the same image: pixels are derived from an integer hash
+     * of their coordinates, not from std distributions, whose results differ between standard libraries.
+    */
+    class SyntheticImage {
+    public:
+        enum class Kind {
+            /* Smooth linear gradient in a seed-dependent direction. Almost every block is RLC-compressible. */
+            GRADIENT,
+            /* Fine-grained value noise mixed with white noise. Almost no block is RLC-compressible. */
+            NOISE,
+            /* Fractal (1/f) value noise with a little of sensor-like noise, resembles photographs. */
+            NATURAL
+        };
+
+        /**
+         * @brief Generates image.
+         * @param t_Kind kind of the image.
+         * @param t_Height height of the image (should be even).
+         * @param t_Width width of the image (should be even).
+         * @param t_Seed seed.
+         * @return generated image.
+        */
+        static BmpImage Generate(Kind t_Kind, uint32_t t_Height, uint32_t t_Width, uint64_t t_Seed);
+
+        /**
+         * @brief Name of the kind, to be used in the benchmark names (e.g. "Natural").
+        */
+        static std::string KindName(Kind t_Kind);
+
+    private:
+        /**
+         * @brief Stateless 64-bit hash (splitmix64 finalizer).
+        */
+        static constexpr uint64_t Mix(uint64_t t_Value)
+        {
+            t_Value += 0x9E3779B97F4A7C15ULL;
+            t_Value = (t_Value ^ (t_Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            t_Value = (t_Value ^ (t_Value >> 27)) * 0x94D049BB133111EBULL;
+            return t_Value ^ (t_Value >> 31);
+        }
+
+        /**
+         * @brief Uniform value in [0, 1) for the lattice point (t_Y, t_X) of the octave t_Octave.
+        */
+        static float LatticeValue(uint64_t t_Seed, uint32_t t_Octave, uint32_t t_Y, uint32_t t_X);
+
+        /**
+         * @brief Adds row t_Y of the bilinearly interpolated value noise with the lattice step t_CellSize,
+         * multiplied by t_Amplitude, to t_Row. Images are generated row by row, so that even the biggest ones
+         * don't need a floating-point copy.
+        */
+        static void AddValueNoiseRow(std::vector<float>& t_Row, uint32_t t_Y, uint64_t t_Seed, uint32_t t_Octave, uint32_t t_CellSize, float t_Amplitude);
+    };
+}
@@ -0,0 +1,114 @@
+/**
+ * Counting replacements of the global operator new/delete. Not a part of the library: it's linked into
+ * the test executable, and into rdh and rdh_benchmark with ENABLE_ALLOCATION_STATS, see MemoryStats.
+ * Sized operator delete is replaced as well, because compilers warn (-Wsized-deallocation), if only the unsized one is.
+ * Array and nothrow forms aren't replaced, because their default versions call the ones below.
+ */
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+#include "memory_stats.h"
+
+namespace {
+    std::size_t UsableSize(void* t_Ptr, [[maybe_unused]] std::size_t t_Alignment)
+    {
+#if defined(_WIN32)
+        return (t_Alignment == 0) ? _msize(t_Ptr) : _aligned_msize(t_Ptr, t_Alignment, 0);
+#elif defined(__APPLE__)
+        return malloc_size(t_Ptr);
+#else
+        return malloc_usable_size(t_Ptr);
+#endif
+    }
+
+    void* Allocate(std::size_t t_Size, std::size_t t_Alignment)
+    {
+        /* Zero-size allocations should return unique pointers. */
+        if (t_Size == 0) {
+            t_Size = 1;
+        }
+
+        for (;;) {
+            void* ptr{ nullptr };
+            if (t_Alignment == 0) {
+                ptr = std::malloc(t_Size);
+            }
+            else {
+#if defined(_WIN32)
+                ptr = _aligned_malloc(t_Size, t_Alignment);
+#else
+                if (posix_memalign(&ptr, t_Alignment, t_Size) != 0) {
+                    ptr = nullptr;
+                }
+#endif
+            }
+
+            if (ptr != nullptr) {
+                rdh::MemoryStats::RecordAllocation(UsableSize(ptr, t_Alignment));
+                return ptr;
+            }
+
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void Deallocate(void* t_Ptr, std::size_t t_Alignment) noexcept
+    {
+        if (t_Ptr == nullptr) {
+            return;
+        }
+
+        rdh::MemoryStats::RecordDeallocation(UsableSize(t_Ptr, t_Alignment));
+#if defined(_WIN32)
+        if (t_Alignment != 0) {
+            _aligned_free(t_Ptr);
+            return;
+        }
+#endif
+        std::free(t_Ptr);
+    }
+
+    const bool s_HooksInstalled = (rdh::MemoryStats::OnHooksInstalled(), true);
+}
+
+void* operator new(std::size_t t_Size)
+{
+    return Allocate(t_Size, 0);
+}
+
+void* operator new(std::size_t t_Size, std::align_val_t t_Alignment)
+{
+    return Allocate(t_Size, static_cast<std::size_t>(t_Alignment));
+}
+
+void operator delete(void* t_Ptr) noexcept
+{
+    Deallocate(t_Ptr, 0);
+}
+
+void operator delete(void* t_Ptr, std::align_val_t t_Alignment) noexcept
+{
+    Deallocate(t_Ptr, static_cast<std::size_t>(t_Alignment));
+}
+
+void operator delete(void* t_Ptr, std::size_t) noexcept
+{
+    Deallocate(t_Ptr, 0);
+}
+
+void operator delete(void* t_Ptr, std::size_t, std::align_val_t t_Alignment) noexcept
+{
+    Deallocate(t_Ptr, static_cast<std::size_t>(t_Alignment));
+}
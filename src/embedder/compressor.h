@@ -1,15 +1,83 @@
 #pragma once 
 
+#include <array>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "embedder/rlc.h"
 #include "embedder/embedder.h"
-#include "embedder/huffman.h"
+#include "embedder/rlc_huffman_code.h"
 
 namespace rdh {
     class RlcCompressor {
     public:
+        /**
+         * @brief RLC-encodes differences between the top-left pixel and the other pixels of the block (without allocations).
+         * The trailing (0, 0) symbol is thrown away, so a block of equal pixels has no symbols at all.
+         * @param t_Pixel1 Value of the upper-left pixel
+         * @param t_Pixel2 Value of the upper-right pixel
+         * @param t_Pixel3 Value of the lower-left pixel
+         * @param t_Pixel4 Value of the lower-right pixel
+         * @param t_Symbols where to save the symbols
+         * @return number of the saved symbols
+        */
+        static uint32_t EncodeRlcSymbols(Color8u t_Pixel1, Color8u t_Pixel2, Color8u t_Pixel3, Color8u t_Pixel4, std::array<RlcHuffmanCode::Symbol, 3>& t_Symbols)
+        {
+            /**
+             * Difference can be a negative number!
+             */
+            const std::array<Color16s, 3> deltas{
+                static_cast<Color16s>((Color16s)t_Pixel2 - (Color16s)t_Pixel1),
+                static_cast<Color16s>((Color16s)t_Pixel3 - (Color16s)t_Pixel1),
+                static_cast<Color16s>((Color16s)t_Pixel4 - (Color16s)t_Pixel1)
+            };
+
+            if (deltas[0] == 0 && deltas[1] == 0 && deltas[2] == 0) {
+                return 0;
+            }
+
+            /* Same as RLC::RlcEncode, the last difference is always emitted. */
+            uint32_t symbolsCount{ 0 };
+            uint16_t zerosCount{ 0 };
+            for (uint32_t pos = 0; pos < deltas.size(); ++pos) {
+                if (deltas[pos] == 0 && pos != deltas.size() - 1) {
+                    zerosCount++;
+                    continue;
+                }
+
+                t_Symbols[symbolsCount++] = RlcHuffmanCode::Symbol(zerosCount, deltas[pos]);
+                zerosCount = 0;
+            }
+
+            if (t_Symbols[symbolsCount - 1] == RlcHuffmanCode::Symbol(0, 0)) {
+                symbolsCount--;
+            }
+
+            return symbolsCount;
+        }
+
+        /**
+         * @brief Same as Compress, but doesn't throw, if some of the RLC symbols don't have a Huffman code
+         * (which is possible with per-image codes). Such blocks can't be compressed.
+         * @param t_Pixel1 Value of the upper-left pixel
+         * @param t_Pixel2 Value of the upper-right pixel
+         * @param t_Pixel3 Value of the lower-left pixel
+         * @param t_Pixel4 Value of the lower-right pixel
+         * @param t_HuffmanCoder Huffman coder object to use
+         * @param t_Compressed where to save the encoded bitstream
+         * @return false, if the block can't be encoded using t_HuffmanCoder
+        */
+        static bool TryCompress(Color8u t_Pixel1, Color8u t_Pixel2, Color8u t_Pixel3, Color8u t_Pixel4, const RlcHuffmanCode& t_HuffmanCoder, std::string& t_Compressed)
+        {
+            std::array<RlcHuffmanCode::Symbol, 3> symbols;
+            const uint32_t symbolsCount = EncodeRlcSymbols(t_Pixel1, t_Pixel2, t_Pixel3, t_Pixel4, symbols);
+
+            /* Special case. All differences are equal to zero. In this scenario, huffman keyword length is 0. */
+            t_Compressed.clear();
+            return t_HuffmanCoder.TryEncode(std::span<const RlcHuffmanCode::Symbol>(symbols.data(), symbolsCount), t_Compressed);
+        }
+
         /**
          * @brief Method that compresses given pixel data using RLC encoding + Huffman.
          * @param t_Pixel1 Value of the upper-left pixel
@@ -19,7 +87,7 @@ namespace rdh {
          * @param t_HuffmanCoder Huffman coder object to use
          * @return std::string that represents encoded data in a form of a bitstream
         */
-        static std::string Compress(Color8u t_Pixel1, Color8u t_Pixel2, Color8u t_Pixel3, Color8u t_Pixel4, Huffman<std::pair<uint16_t, Color16s>, pair_hash>& t_HuffmanCoder)
+        static std::string Compress(Color8u t_Pixel1, Color8u t_Pixel2, Color8u t_Pixel3, Color8u t_Pixel4, const RlcHuffmanCode& t_HuffmanCoder)
         {
             std::vector<std::pair<uint16_t, Color16s>> rlcEncoded;
             std::string encoded;
@@ -72,7 +140,7 @@ namespace rdh {
             return std::move(encoded);
         }
 
-        static std::vector<Color8u> Decompress(Color8u t_Pixel1, const std::string& t_RlcEncoded, Huffman<std::pair<uint16_t, Color16s>, pair_hash>& t_HuffmanCoder)
+        static std::vector<Color8u> Decompress(Color8u t_Pixel1, const std::string& t_RlcEncoded, const RlcHuffmanCode& t_HuffmanCoder)
         {
             std::vector<Color8u> decompressed{ t_Pixel1 };
 
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <thread>
+
 #include "types.h"
 #include "utils.h"
+#include "embedder/rlc_huffman_code.h"
 
 namespace rdh {
     namespace consts {
@@ -9,7 +14,7 @@ namespace rdh {
             /**
              * @brief Default frequencies table for Huffman encoder to use
             */
-            const std::unordered_map<std::pair<uint16_t, Color16s>, uint32_t, pair_hash> c_DefaultFrequencies {
+            inline constexpr std::array<std::pair<std::pair<uint16_t, Color16s>, uint32_t>, RlcHuffmanCode::c_AlphabetSize> c_DefaultFrequencies { {
                 { std::pair<uint16_t, Color16s>(0, -255), 1 },
                 { std::pair<uint16_t, Color16s>(0, -254), 1 },
                 { std::pair<uint16_t, Color16s>(0, -253), 1 },
@@ -1543,13 +1548,26 @@ namespace rdh {
                 { std::pair<uint16_t, Color16s>(2, 253), 1 },
                 { std::pair<uint16_t, Color16s>(2, 254), 1 },
                 { std::pair<uint16_t, Color16s>(2, 255), 1 }
-            };
-        }
+            } };
 
-        /**
-         * @brief Default node object
-         */
-        constexpr std::pair<uint16_t, Color8u> c_DefaultNode{ -1, 65535 };
+            /**
+             * @brief Frequencies from c_DefaultFrequencies, indexed by RlcHuffmanCode::SymbolIndex.
+            */
+            constexpr RlcHuffmanCode::Frequencies DefaultFrequenciesTable()
+            {
+                RlcHuffmanCode::Frequencies frequencies{};
+                for (const auto& [symbol, freq] : c_DefaultFrequencies) {
+                    frequencies[RlcHuffmanCode::SymbolIndex(symbol)] = freq;
+                }
+
+                return frequencies;
+            }
+
+            /**
+             * @brief Default canonical Huffman code for RLC symbols. Built at compile time, shared by all of the coders.
+            */
+            inline constexpr RlcHuffmanCode c_DefaultCode{ DefaultFrequenciesTable() };
+        }
     }
 
     /**
@@ -1559,7 +1577,7 @@ namespace rdh {
     {
     public:
         Consts()
-            : m_Threshold{ 14 }, m_LsbLayers{ 1 }, m_Lambda{ 400 }, m_Alpha{ 6 }, m_LsbHashSize{ 3 }
+            : m_Threshold{ 14 }, m_LsbLayers{ 1 }, m_Lambda{ 400 }, m_Alpha{ 6 }, m_LsbHashSize{ 3 }, m_FramedPayload{ false }, m_TileSize{ 0 }, m_AdaptiveHuffman{ false }, m_ThreadsCount{ 0 }
         {
             m_GroupSizeBeforeCompression = (uint32_t)m_Lambda * (s_PixelsInOneBlock * m_LsbLayers - 1);
             m_RlcEncodedMaxSize = utils::math::CeilLog2(m_Threshold);
@@ -1611,27 +1629,89 @@ namespace rdh {
             m_LsbHashSize = t_LsbHashSize;
         }
 
+        void UpdateFramedPayload(bool t_FramedPayload)
+        {
+            /* Set a new value for a variable */
+            m_FramedPayload = t_FramedPayload;
+        }
+
+        void UpdateTileSize(uint16_t t_TileSize)
+        {
+            /* Set a new value for a variable */
+            m_TileSize = t_TileSize;
+        }
+
+        void UpdateAdaptiveHuffman(bool t_AdaptiveHuffman)
+        {
+            /* Set a new value for a variable */
+            m_AdaptiveHuffman = t_AdaptiveHuffman;
+        }
+
+        void UpdateThreadsCount(uint16_t t_ThreadsCount)
+        {
+            /* Set a new value for a variable */
+            m_ThreadsCount = t_ThreadsCount;
+        }
+
         static Consts& Instance()
         {
             static Consts INSTANCE;
-            return INSTANCE;
+            return (s_ThreadInstance != nullptr) ? *s_ThreadInstance : INSTANCE;
         }
 
+        /**
+         * @brief While alive, makes Instance() return another constants object in the current thread.
+         * Allows evaluating different parameter sets concurrently.
+         */
+        class ThreadOverride
+        {
+        public:
+            explicit ThreadOverride(Consts& t_Consts)
+                : m_Previous{ s_ThreadInstance }
+            {
+                s_ThreadInstance = &t_Consts;
+            }
+
+            ~ThreadOverride()
+            {
+                s_ThreadInstance = m_Previous;
+            }
+
+            ThreadOverride(const ThreadOverride&) = delete;
+            ThreadOverride& operator=(const ThreadOverride&) = delete;
+
+        private:
+            Consts* m_Previous;
+        };
+
         /* All needed getters. */
         uint16_t GetThreshold() const { return m_Threshold; }
         uint16_t GetLsbLayers() const { return m_LsbLayers; }
         uint16_t GetLambda() const { return m_Lambda; }
         uint16_t GetAlpha() const { return m_Alpha; }
         uint16_t GetLsbHashSize() const { return m_LsbHashSize; }
+        bool IsPayloadFramed() const { return m_FramedPayload; }
+        uint16_t GetTileSize() const { return m_TileSize; }
+        bool IsHuffmanAdaptive() const { return m_AdaptiveHuffman; }
+        uint32_t GetThreadsCount() const { return (m_ThreadsCount != 0) ? m_ThreadsCount : std::max<uint32_t>(std::thread::hardware_concurrency(), 1); }
         uint32_t GetGroupSizeBeforeCompression() const { return m_GroupSizeBeforeCompression; }
         uint32_t GetRlcEncodedMaxSize() const { return m_RlcEncodedMaxSize; }
         uint32_t GetGroupSizeAfterCompression() const { return m_GroupSizeAfterCompression; }
         uint16_t GetPixelsInOneBlock() const { return s_PixelsInOneBlock; }
+        uint16_t GetPayloadLengthSize() const { return s_PayloadLengthSize; }
+        uint16_t GetPayloadChecksumSize() const { return s_PayloadChecksumSize; }
+        uint16_t GetHuffmanTableLengthSize() const { return s_HuffmanTableLengthSize; }
+        uint16_t GetMaxAdaptiveCodeLength() const { return s_MaxAdaptiveCodeLength; }
         uint16_t GetAvgRlcEncodedLength() const { return s_AvgRlcEncodedLength; }
         float GetRlcEncodedBlocksRatioAvg() const { return s_RlcEncodedBlocksRatioAvg; }
         float GetLsbEncodedBlocksRatioAvg() const { return s_LsbEncodedBlocksRatioAvg; }
 
     private:
+        /**
+         * @brief Constants object, that overrides the global one in the current thread.
+         */
+        static inline thread_local Consts* s_ThreadInstance{ nullptr };
+
         /**
          * @brief Default threshold for block classification
          */
@@ -1676,6 +1756,30 @@ namespace rdh {
          */
         uint32_t m_GroupSizeAfterCompression;
 
+        /**
+         * @brief If set, user data is prepended with its length and checksum, so that
+         * the extractor can stop at the real end of the payload instead of returning the padding too.
+         */
+        bool m_FramedPayload;
+
+        /**
+         * @brief If not zero, image is split into square tiles of this size (in pixels), and each tile
+         * is embedded independently: with its own bitstream, permutation and framed payload chunk.
+         */
+        uint16_t m_TileSize;
+
+        /**
+         * @brief If set, RLC-compressed blocks are encoded using Huffman code, built for the current image.
+         * The code is serialized at the beginning of the bitstream (before the lengths of the RLC-compressed blocks).
+         */
+        bool m_AdaptiveHuffman;
+
+        /**
+         * @brief Maximum number of threads, that tiles, recovery bands and parameter candidates are processed with.
+         * 0 means all of the hardware threads.
+         */
+        uint16_t m_ThreadsCount;
+
         /**
          * @brief Number of pixels in one block.
          */
@@ -1687,6 +1791,26 @@ namespace rdh {
          */
         static const uint16_t s_AvgRlcEncodedLength{ 11 };
 
+        /**
+         * @brief Size of the payload length (in bytes) field of the framed payload header.
+         */
+        static const uint16_t s_PayloadLengthSize{ 32 };
+
+        /**
+         * @brief Size of the payload CRC-32 field of the framed payload header.
+         */
+        static const uint16_t s_PayloadChecksumSize{ 32 };
+
+        /**
+         * @brief Size of the field with the serialized per-image Huffman code length (0 means, that the default code is used).
+         */
+        static const uint16_t s_HuffmanTableLengthSize{ 16 };
+
+        /**
+         * @brief Maximum code length of the per-image Huffman code.
+         */
+        static const uint16_t s_MaxAdaptiveCodeLength{ RlcHuffmanCode::c_MaxSerializedCodeLength };
+
         /**
         * @brief Average percentage of blocks that are encoded using RLC based algorithm.
         */
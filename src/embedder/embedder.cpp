@@ -1,29 +1,430 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <bitset>
 #include <cmath>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <random>
+#include <thread>
 
 #include "embedder/embedder.h"
 #include "embedder/compressor.h"
-#include "embedder/huffman.h"
+#include "embedder/group_compressor-impl.h"
+#include "embedder/rlc_huffman_code.h"
 #include "embedder/consts.h"
+#include "image/image_quality.h"
+#include "phase_scope.h"
 #include "utils.h"
 
 #include <boost/log/trivial.hpp>
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>
 
 namespace rdh {
-    BmpImage& Embedder::Embed(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits)
+    double EmbeddingDistortion::GetMSE() const
     {
-        /* This is here only to allow matrix reinitialization while running benchmarks. */
-        bool reinitRandomMatrixForHashCalculation{ true };
+        return (m_PixelsCount == 0) ? 0.0 : (double)m_SquaredErrorSum / (double)m_PixelsCount;
+    }
+
+    double EmbeddingDistortion::GetPSNR() const
+    {
+        return ImageQuality::MSEToPSNR(GetMSE());
+    }
+
+    BmpImage PreparedCarrier::Embed(const std::vector<uint8_t>& t_Data, std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion) const
+    {
+        BmpImage markedImage(m_PreparedImage);
+        Embedder::PackBitStream(markedImage, *this, t_Data, t_Distortion);
+
+        return markedImage;
+    }
+
+    BmpImage& Embedder::Embed(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits,
+        std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion)
+    {
+        if (Consts::Instance().GetTileSize() != 0) {
+            return EmbedTiled(t_EncryptedImage, t_Data, t_DataEmbeddingKey, t_MaxEmbeddingRate, t_MaxUserDataBits, t_Distortion);
+        }
+
+        PreparedCarrier carrier;
+        PrepareInPlace(t_EncryptedImage, t_DataEmbeddingKey, carrier);
+
+        if (t_MaxEmbeddingRate != std::nullopt) {
+            t_MaxEmbeddingRate->get() = carrier.m_MaxEmbeddingRate;
+        }
 
+        if (t_MaxUserDataBits != std::nullopt) {
+            t_MaxUserDataBits->get() = carrier.m_MaxUserDataBits;
+        }
+
+        if (carrier.m_MaxEmbeddingRate < 0.0f) {
+            throw std::invalid_argument(
+                "Incorrect parameters are set for data embedder! "
+                "Consider using default parameters. Or find more appropriate values."
+            );
+        }
+
+        return PackBitStream(t_EncryptedImage, carrier, t_Data, t_Distortion);
+    }
+
+    PreparedCarrier Embedder::Prepare(const BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, const Consts& t_Params)
+    {
+        /* Prepare the carrier using t_Params, without touching global constants. */
+        Consts params = t_Params;
+        Consts::ThreadOverride paramsOverride(params);
+
+        PreparedCarrier carrier;
+        carrier.m_PreparedImage = BmpImage(t_EncryptedImage);
+        PrepareInPlace(carrier.m_PreparedImage, t_DataEmbeddingKey, carrier);
+
+        if (carrier.m_MaxEmbeddingRate < 0.0f) {
+            throw std::invalid_argument(
+                "Incorrect parameters are set for data embedder! "
+                "Consider using default parameters. Or find more appropriate values."
+            );
+        }
+
+        return carrier;
+    }
+
+    BmpImage& Embedder::EmbedTiled(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits,
+        std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion)
+    {
         Consts& constsRef = Consts::Instance();
 
-        /* Create Huffman-coder object, which will be used to encode RLC sequences */
-        Huffman<std::pair<uint16_t, Color16s>, pair_hash> huffmanCoder(consts::c_DefaultNode);
+        const std::vector<ContainerTile> tiles = SplitIntoTiles(t_EncryptedImage, constsRef.GetTileSize());
+        const Consts tileParams = TileParams(constsRef);
 
-        /* Set default frequencies (found using statistical approach) */
-        huffmanCoder.SetFrequencies(consts::huffman::c_DefaultFrequencies);
+        /**
+         * Chunk of each tile depends on the capacities of all of the previous tiles, so all of the tiles are prepared first.
+         * Prepared tile differs from the tile of t_EncryptedImage only by the location map bits, so its copy isn't kept:
+         * only the side information and the capacity are, and the location map is applied again right before packing.
+        */
+        std::vector<std::unique_ptr<PreparedCarrier>> tilesCarriers(tiles.size());
+        std::vector<int64_t> tilesMaxUserDataBits(tiles.size());
+        std::vector<double> tilesMaxEmbeddingRate(tiles.size());
+        ForEachTile(tiles.size(), [&](uint32_t t_TileIdx) {
+            tilesCarriers[t_TileIdx] = std::make_unique<PreparedCarrier>(Prepare(CropTile(t_EncryptedImage, tiles[t_TileIdx]), DeriveTileKey(t_DataEmbeddingKey, t_TileIdx), tileParams));
+            tilesCarriers[t_TileIdx]->m_PreparedImage = BmpImage(0, 0);
+
+            tilesMaxUserDataBits[t_TileIdx] = tilesCarriers[t_TileIdx]->m_MaxUserDataBits;
+            tilesMaxEmbeddingRate[t_TileIdx] = tilesCarriers[t_TileIdx]->m_MaxEmbeddingRate;
+        });
+
+        /* Capacity of the whole container can exceed 32 bits. */
+        const uint32_t payloadHeaderSize = tileParams.GetPayloadLengthSize() + tileParams.GetPayloadChecksumSize();
+        std::vector<uint64_t> tilesCapacity(tiles.size());
+        uint64_t totalCapacity{ 0 };
+        double weightedEmbeddingRate{ 0.0 };
+
+        for (uint32_t tileIdx = 0; tileIdx < tiles.size(); ++tileIdx) {
+            if (tilesMaxUserDataBits[tileIdx] < static_cast<int64_t>(payloadHeaderSize)) {
+                throw std::invalid_argument("Tile can't hold the payload header! Consider using bigger tiles, or another parameters.");
+            }
+
+            tilesCapacity[tileIdx] = (tilesMaxUserDataBits[tileIdx] - payloadHeaderSize) / 8;
+            totalCapacity += tilesCapacity[tileIdx];
+            weightedEmbeddingRate += tilesMaxEmbeddingRate[tileIdx] * tiles[tileIdx].m_Height * tiles[tileIdx].m_Width;
+        }
+
+        BOOST_LOG_TRIVIAL(info) << "Tiles: " << tiles.size() << ". Maximum bytes of user-data to embed: " << totalCapacity;
+
+        if (t_MaxEmbeddingRate != std::nullopt) {
+            t_MaxEmbeddingRate->get() = weightedEmbeddingRate / ((double)t_EncryptedImage.GetHeight() * (double)t_EncryptedImage.GetWidth());
+        }
+
+        if (t_MaxUserDataBits != std::nullopt) {
+            t_MaxUserDataBits->get() = static_cast<uint32_t>(std::min<uint64_t>(8 * totalCapacity, std::numeric_limits<uint32_t>::max()));
+        }
+
+        if (t_Data.size() > totalCapacity) {
+            throw std::invalid_argument("User data size exceeds the maximum possible size!");
+        }
+
+        /* Payload chunks fill the tiles in order. */
+        std::vector<uint64_t> chunksBegin(tiles.size() + 1, 0);
+        for (uint32_t tileIdx = 0; tileIdx < tiles.size(); ++tileIdx) {
+            chunksBegin[tileIdx + 1] = chunksBegin[tileIdx] + std::min<uint64_t>(tilesCapacity[tileIdx], t_Data.size() - chunksBegin[tileIdx]);
+        }
+
+        /* Squared errors of the tiles just add up. */
+        std::vector<EmbeddingDistortion> tilesDistortion(tiles.size());
+
+        ForEachTile(tiles.size(), [&](uint32_t t_TileIdx) {
+            const PreparedCarrier& carrier = *tilesCarriers[t_TileIdx];
+
+            /* Set the location map bits, as PrepareInPlace does. */
+            BmpImage tileImage = CropTile(t_EncryptedImage, tiles[t_TileIdx]);
+            uint32_t blockIdx{ 0 };
+            for (uint32_t imgY = 0; imgY < tileImage.GetHeight(); imgY += 2) {
+                for (uint32_t imgX = 0; imgX < tileImage.GetWidth(); imgX += 2, ++blockIdx) {
+                    tileImage.SetPixel(imgY, imgX, utils::ClearLastNBits(tileImage.GetPixel(imgY, imgX), 1) | (carrier.m_LocationMap[blockIdx] ? 1 : 0));
+                }
+            }
+
+            const std::vector<uint8_t> chunk(t_Data.begin() + chunksBegin[t_TileIdx], t_Data.begin() + chunksBegin[t_TileIdx + 1]);
+            PasteTile(t_EncryptedImage, PackBitStream(tileImage, carrier, chunk, tilesDistortion[t_TileIdx]), tiles[t_TileIdx]);
+
+            tilesCarriers[t_TileIdx].reset();
+        });
+
+        if (t_Distortion != std::nullopt) {
+            t_Distortion->get() = EmbeddingDistortion{};
+            for (const auto& tileDistortion : tilesDistortion) {
+                t_Distortion->get().m_SquaredErrorSum += tileDistortion.m_SquaredErrorSum;
+                t_Distortion->get().m_PixelsCount += tileDistortion.m_PixelsCount;
+            }
+        }
+
+        return t_EncryptedImage;
+    }
+
+    std::vector<Embedder::ContainerTile> Embedder::SplitIntoTiles(const BmpImage& t_Image, uint32_t t_TileSize)
+    {
+        if (t_TileSize == 0 || t_TileSize % 2 != 0) {
+            throw std::invalid_argument("Tile size should be positive and divisible by 2!");
+        }
+
+        std::vector<ContainerTile> tiles;
+        for (uint32_t tileY = 0; tileY < t_Image.GetHeight(); tileY += t_TileSize) {
+            for (uint32_t tileX = 0; tileX < t_Image.GetWidth(); tileX += t_TileSize) {
+                tiles.push_back({ tileY, tileX, std::min(t_TileSize, t_Image.GetHeight() - tileY), std::min(t_TileSize, t_Image.GetWidth() - tileX) });
+            }
+        }
+
+        return tiles;
+    }
+
+    std::vector<uint8_t> Embedder::DeriveTileKey(const std::vector<uint8_t>& t_DataEmbeddingKey, uint32_t t_TileIdx)
+    {
+        std::vector<uint8_t> tileKey(t_DataEmbeddingKey);
+
+        for (uint32_t bytePos = 0; bytePos < 4; ++bytePos) {
+            tileKey.push_back(static_cast<uint8_t>(t_TileIdx >> (8 * bytePos)));
+        }
+
+        return tileKey;
+    }
+
+    Consts Embedder::TileParams(const Consts& t_Params)
+    {
+        Consts tileParams = t_Params;
+        tileParams.UpdateTileSize(0);
+        tileParams.UpdateFramedPayload(true);
+
+        return tileParams;
+    }
+
+    BmpImage Embedder::CropTile(BmpImage& t_Image, const ContainerTile& t_Tile)
+    {
+        return t_Image.Crop(t_Tile.m_Y, t_Tile.m_Y + t_Tile.m_Height - 1, t_Tile.m_X, t_Tile.m_X + t_Tile.m_Width - 1);
+    }
+
+    void Embedder::PasteTile(BmpImage& t_Image, const BmpImage& t_TileImage, const ContainerTile& t_Tile)
+    {
+        for (uint32_t tileY = 0; tileY < t_Tile.m_Height; ++tileY) {
+            for (uint32_t tileX = 0; tileX < t_Tile.m_Width; ++tileX) {
+                t_Image.SetPixel(t_Tile.m_Y + tileY, t_Tile.m_X + tileX, t_TileImage.GetPixel(tileY, tileX));
+            }
+        }
+    }
+
+    void Embedder::ForEachTile(uint32_t t_TilesCount, const std::function<void(uint32_t)>& t_Worker)
+    {
+        /* Workers don't inherit the thread override of the caller, so it's installed in each of them. */
+        Consts& params = Consts::Instance();
+        const uint32_t threadsCount = std::min<uint32_t>(params.GetThreadsCount(), t_TilesCount);
+
+        std::atomic<uint32_t> nextTileIdx{ 0 };
+        std::exception_ptr firstException;
+        std::mutex exceptionMutex;
+
+        const auto worker = [&]() {
+            Consts::ThreadOverride paramsOverride(params);
+
+            for (uint32_t tileIdx = nextTileIdx++; tileIdx < t_TilesCount; tileIdx = nextTileIdx++) {
+                try {
+                    t_Worker(tileIdx);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!firstException) {
+                        firstException = std::current_exception();
+                    }
+
+                    /* Skip the remaining tiles. */
+                    nextTileIdx = t_TilesCount;
+                }
+            }
+        };
+
+        if (threadsCount <= 1) {
+            worker();
+        }
+        else {
+            std::vector<std::thread> threadpool;
+            for (uint32_t threadIdx = 0; threadIdx < threadsCount; ++threadIdx) {
+                threadpool.emplace_back(worker);
+            }
+
+            for (auto& th : threadpool) {
+                th.join();
+            }
+        }
+
+        if (firstException) {
+            std::rethrow_exception(firstException);
+        }
+    }
+
+    RlcHuffmanCode Embedder::SelectHuffmanCode(const BmpImage& t_EncryptedImage, std::string& t_HuffmanTableBitStream)
+    {
+        Consts& constsRef = Consts::Instance();
+
+        const RlcHuffmanCode& defaultCoder = consts::huffman::c_DefaultCode;
+
+        const uint32_t totalBlocks{
+            static_cast<uint32_t>(static_cast<std::size_t>(t_EncryptedImage.GetHeight()) * static_cast<std::size_t>(t_EncryptedImage.GetWidth()) / 4)
+        };
+
+        /* Calls t_Callback(symbols, symbolsCount) for the RLC symbols of each block. */
+        const auto forEachBlock = [&t_EncryptedImage](const auto& t_Callback) {
+            std::array<RlcHuffmanCode::Symbol, 3> symbols;
+            for (uint32_t imgY = 0; imgY < t_EncryptedImage.GetHeight(); imgY += 2) {
+                for (uint32_t imgX = 0; imgX < t_EncryptedImage.GetWidth(); imgX += 2) {
+                    const uint32_t symbolsCount = RlcCompressor::EncodeRlcSymbols(
+                        t_EncryptedImage.GetPixel(imgY, imgX),
+                        t_EncryptedImage.GetPixel(imgY, imgX + 1),
+                        t_EncryptedImage.GetPixel(imgY + 1, imgX),
+                        t_EncryptedImage.GetPixel(imgY + 1, imgX + 1),
+                        symbols
+                    );
+                    t_Callback(symbols, symbolsCount);
+                }
+            }
+        };
+
+        /* Size of the block, compressed using t_Coder. Blocks, that can't be compressed, get the threshold size. */
+        const auto compressedSize = [&constsRef](const RlcHuffmanCode& t_Coder, const std::array<RlcHuffmanCode::Symbol, 3>& t_Symbols, uint32_t t_SymbolsCount) {
+            uint32_t size{ 0 };
+            for (uint32_t symbolIdx = 0; symbolIdx < t_SymbolsCount; ++symbolIdx) {
+                const uint32_t codeLength = t_Coder.GetCodeLength(t_Symbols[symbolIdx]);
+                if (codeLength == 0) {
+                    return static_cast<uint32_t>(constsRef.GetThreshold());
+                }
+                size += codeLength;
+            }
+            return size;
+        };
+
+        /* The same formula, as the one used for the maximum user data size, excluding the code table. */
+        const auto userDataBits = [&constsRef, totalBlocks](uint32_t t_OmegaOneBlocks, uint64_t t_RlcEncodedBits) {
+            const uint32_t xi = (totalBlocks - t_OmegaOneBlocks) / constsRef.GetLambda();
+            return 24 * static_cast<int64_t>(t_OmegaOneBlocks) - static_cast<int64_t>(t_OmegaOneBlocks) * constsRef.GetRlcEncodedMaxSize() -
+                static_cast<int64_t>(t_RlcEncodedBits) + static_cast<int64_t>(xi) * (constsRef.GetAlpha() - constsRef.GetLsbHashSize()) - totalBlocks;
+        };
+
+        /**
+         * Single pass over the image: find out, how much data can be embedded using the default code, and collect
+         * frequencies of the symbols for two candidate codes: over the blocks, that are RLC-compressible with
+         * the default code, and over all of the blocks (some blocks, that the default code can't compress
+         * below the threshold, become compressible with a code built for this image).
+         */
+        RlcHuffmanCode::Frequencies compressibleFrequencies{};
+        RlcHuffmanCode::Frequencies allFrequencies{};
+        uint32_t defaultOmegaOneBlocks{ 0 };
+        uint64_t defaultRlcEncodedBits{ 0 };
+        forEachBlock([&](const std::array<RlcHuffmanCode::Symbol, 3>& t_Symbols, uint32_t t_SymbolsCount) {
+            const uint32_t size = compressedSize(defaultCoder, t_Symbols, t_SymbolsCount);
+            const bool isCompressible = size < constsRef.GetThreshold();
+
+            for (uint32_t symbolIdx = 0; symbolIdx < t_SymbolsCount; ++symbolIdx) {
+                const std::size_t frequencyIdx = RlcHuffmanCode::SymbolIndex(t_Symbols[symbolIdx]);
+                allFrequencies[frequencyIdx]++;
+                compressibleFrequencies[frequencyIdx] += isCompressible ? 1 : 0;
+            }
+
+            if (isCompressible) {
+                defaultOmegaOneBlocks++;
+                defaultRlcEncodedBits += size;
+            }
+        });
+
+        const std::array<RlcHuffmanCode, 2> adaptiveCoders{
+            RlcHuffmanCode(RlcHuffmanCode::LimitCodeLengths(RlcHuffmanCode::CalculateCodeLengths(compressibleFrequencies), constsRef.GetMaxAdaptiveCodeLength())),
+            RlcHuffmanCode(RlcHuffmanCode::LimitCodeLengths(RlcHuffmanCode::CalculateCodeLengths(allFrequencies), constsRef.GetMaxAdaptiveCodeLength()))
+        };
+
+        std::array<uint32_t, 2> adaptiveOmegaOneBlocks{};
+        std::array<uint64_t, 2> adaptiveRlcEncodedBits{};
+        forEachBlock([&](const std::array<RlcHuffmanCode::Symbol, 3>& t_Symbols, uint32_t t_SymbolsCount) {
+            for (uint32_t coderIdx = 0; coderIdx < adaptiveCoders.size(); ++coderIdx) {
+                const uint32_t size = compressedSize(adaptiveCoders[coderIdx], t_Symbols, t_SymbolsCount);
+                if (size < constsRef.GetThreshold()) {
+                    adaptiveOmegaOneBlocks[coderIdx]++;
+                    adaptiveRlcEncodedBits[coderIdx] += size;
+                }
+            }
+        });
+
+        /* Pick the code, that allows to embed the most data. The default one, unless some adaptive code is better. */
+        int64_t bestUserDataBits = userDataBits(defaultOmegaOneBlocks, defaultRlcEncodedBits);
+        std::optional<uint32_t> bestCoderIdx;
+        std::string bestSerializedCode;
+
+        for (uint32_t coderIdx = 0; coderIdx < adaptiveCoders.size(); ++coderIdx) {
+            std::string serializedCode = adaptiveCoders[coderIdx].Serialize();
+            const int64_t adaptiveUserDataBits = userDataBits(adaptiveOmegaOneBlocks[coderIdx], adaptiveRlcEncodedBits[coderIdx]) - static_cast<int64_t>(serializedCode.size());
+
+            const bool isAdaptiveBetter = serializedCode.size() < (1ULL << constsRef.GetHuffmanTableLengthSize()) && adaptiveUserDataBits > bestUserDataBits;
+            if (isAdaptiveBetter) {
+                bestUserDataBits = adaptiveUserDataBits;
+                bestCoderIdx = coderIdx;
+                bestSerializedCode = std::move(serializedCode);
+            }
+        }
+
+        /* Serialized code is prefixed with its length. Zero length means, that the default code is used. */
+        t_HuffmanTableBitStream.clear();
+        boost::to_string(boost::dynamic_bitset<>(constsRef.GetHuffmanTableLengthSize(), bestSerializedCode.size()), t_HuffmanTableBitStream);
+
+        if (!bestCoderIdx) {
+            return defaultCoder;
+        }
+
+        t_HuffmanTableBitStream.append(bestSerializedCode);
+
+        return adaptiveCoders[*bestCoderIdx];
+    }
+
+    void Embedder::PrepareInPlace(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, PreparedCarrier& t_Carrier)
+    {
+        DispatchEmbeddingParams(Consts::Instance(), [&](auto t_Params) {
+            PrepareInPlaceKernel<decltype(t_Params)>(t_EncryptedImage, t_DataEmbeddingKey, t_Carrier);
+        });
+    }
+
+    template <class Params>
+    void Embedder::PrepareInPlaceKernel(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, PreparedCarrier& t_Carrier)
+    {
+        Consts& constsRef = Consts::Instance();
+
+        /**
+         * Default Huffman code for RLC sequences (built at compile time from frequencies, found using statistical approach),
+         * or the code built for this image, which is saved at the beginning of the bitstream. In the article it's absent.
+         */
+        std::string huffmanTableBitStream{ "" };
+        std::optional<RlcHuffmanCode> adaptiveHuffmanCoder;
+        if (constsRef.IsHuffmanAdaptive()) {
+            PhaseScope phase("Embed.SelectHuffmanCode");
+            adaptiveHuffmanCoder = SelectHuffmanCode(t_EncryptedImage, huffmanTableBitStream);
+        }
+        const RlcHuffmanCode& huffmanCoder = adaptiveHuffmanCoder ? *adaptiveHuffmanCoder : consts::huffman::c_DefaultCode;
 
         /* In the article it's referred as R. */
         uint32_t omegaOneBlocks{ 0 };
@@ -68,40 +469,26 @@ namespace rdh {
             static_cast<std::size_t>((constsRef.GetGroupSizeBeforeCompression() - constsRef.GetAlpha()) * utils::math::Floor((float)totalBlocks * (float)constsRef.GetLsbEncodedBlocksRatioAvg() / (float)constsRef.GetLambda()))
         );
 
-        /* Vector of groups. In the article Group is referred as G_i. */
-        Group lsbCompressedGroup = Group::Zero(constsRef.GetGroupSizeBeforeCompression(), 1);
-        
-        assert(lsbCompressedGroup.rows() == constsRef.GetGroupSizeBeforeCompression());
-        assert(lsbCompressedGroup.cols() == 1);
-        assert(lsbCompressedGroup.isZero(0));
-
-        /* Used to keep track of current group size. */
-        uint32_t currGroupSize{ 0 };
-
-        /* In the article it's referred as \psi. */
-        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> psi(constsRef.GetGroupSizeAfterCompression(), constsRef.GetGroupSizeBeforeCompression());
-
-        /* In the article it's referred as Z. Size of this matrix is P \times \alpha. */
-        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> pseudoRandomMat(constsRef.GetGroupSizeAfterCompression(), constsRef.GetAlpha());
-        PreparePseudoRandomMatrix(pseudoRandomMat, t_DataEmbeddingKey);
-
-        /* Create binary matrix as described in the article */
-        psi << Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>::Identity(constsRef.GetGroupSizeAfterCompression(), constsRef.GetGroupSizeAfterCompression()), pseudoRandomMat;
+        /* Groups of LSBs (in the article Group is referred as G_i) and their compression. */
+        GroupCompressor<Params> groupCompressor(constsRef, t_DataEmbeddingKey);
 
         /* Iterate over 2x2 blocks to compress them. */
+        PhaseScope compressPhase("Embed.CompressBlocks");
         for (uint32_t imgY = 0; imgY < t_EncryptedImage.GetHeight(); imgY += 2) {
             for (uint32_t imgX = 0; imgX < t_EncryptedImage.GetWidth(); imgX += 2) {
                 /**
                  * Get RLC-encoded representation of a block to determine if it can be 
                  * compressed using RLC-based algorithm, or we should use LSB-based one.
                  */
-                std::string rlcCompressed = RlcCompressor::Compress(
+                std::string rlcCompressed;
+                const bool isRlcCompressible = RlcCompressor::TryCompress(
                     t_EncryptedImage.GetPixel(imgY, imgX),
                     t_EncryptedImage.GetPixel(imgY, imgX + 1),
                     t_EncryptedImage.GetPixel(imgY + 1, imgX),
                     t_EncryptedImage.GetPixel(imgY + 1, imgX + 1), 
-                    huffmanCoder
-                );
+                    huffmanCoder,
+                    rlcCompressed
+                ) && rlcCompressed.size() < constsRef.GetThreshold();
 
                 /* Save lsb of the top-left pixel in a block */
                 topLeftPixelsLsbBitStream += (t_EncryptedImage.GetPixel(imgY, imgX) & 1) ? "1" : "0";
@@ -112,7 +499,7 @@ namespace rdh {
                  * Also don't forget to append new value to the lengthsBitStream, and to update byte in the 
                  * locationMap.
                  */
-                if (rlcCompressed.size() < constsRef.GetThreshold()) {
+                if (isRlcCompressible) {
                     /**
                      * Set lsb of top-left pixel. This bit is used to determine
                      * which approach (lsb/rlc) was used to encode the block.
@@ -144,26 +531,10 @@ namespace rdh {
                             uint8_t curPixel{ t_EncryptedImage.GetPixel(imgY + yAdd, imgX + xAdd) };
                             /* For the top-left pixel, we ignore it's first LSB */
                             uint32_t bitPos = ((yAdd == 0 && xAdd == 0) ? 1 : 0);
-                            for (; bitPos < constsRef.GetLsbLayers(); bitPos++) {
-                                lsbCompressedGroup(currGroupSize++, 0) = utils::math::GetNthBit(curPixel, bitPos);
-
-                                /* If we've exceed group size - create a new one. Also don't forget to reset currGroupSize. */
-                                if (currGroupSize >= constsRef.GetGroupSizeBeforeCompression()) {
-                                    CompressCurrentGroup(psi, lsbCompressedGroup, lsbEncodedBitStream, hashsesBitStream, t_DataEmbeddingKey, reinitRandomMatrixForHashCalculation);
-                                    reinitRandomMatrixForHashCalculation = false;
-
-                                    assert(currGroupSize == constsRef.GetGroupSizeBeforeCompression());
-
-                                    /* Reset group. */
-                                    lsbCompressedGroup.setZero();
-
-                                    /* Because Eigen is weird, lets just double check, if everything is done correctly. */
-                                    assert(lsbCompressedGroup.rows() == constsRef.GetGroupSizeBeforeCompression());
-                                    assert(lsbCompressedGroup.cols() == 1);
-                                    assert(lsbCompressedGroup.isZero(0));
-
-                                    /* Reset group size. */
-                                    currGroupSize = 0;
+                            for (; bitPos < Params::GetLsbLayers(constsRef); bitPos++) {
+                                /* If we've filled the group - compress it, and start a new one. */
+                                if (groupCompressor.Append(utils::math::GetNthBit(curPixel, bitPos))) {
+                                    groupCompressor.Compress(lsbEncodedBitStream, hashsesBitStream);
                                 }
                             }
                         }
@@ -171,6 +542,7 @@ namespace rdh {
                 }
             }
         }
+        compressPhase.End();
 
 #if DEBUG_STATS == 1
         BOOST_LOG_TRIVIAL(info) << "Total blocks: " << totalBlocks;
@@ -185,7 +557,8 @@ namespace rdh {
                 ((double)constsRef.GetAlpha() - (double)constsRef.GetLsbHashSize()) -
                 (double)omegaOneBlocks * std::ceilf(std::log2f(constsRef.GetThreshold())) -
                 (double)rlcEncodedBitStream.size() -
-                (double)totalBlocks
+                (double)totalBlocks -
+                (double)huffmanTableBitStream.size()
             ) / (
                 (double)t_EncryptedImage.GetHeight() * (double)t_EncryptedImage.GetWidth()
             );
@@ -194,53 +567,82 @@ namespace rdh {
 
         uint32_t xi = utils::math::Floor((float)(totalBlocks - omegaOneBlocks) / (float)constsRef.GetLambda());
         int32_t maxUserDataSize = 24 * omegaOneBlocks + xi * constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1)
-            - (lengthsBitStream.size() + rlcEncodedBitStream.size() + lsbEncodedBitStream.size() + hashsesBitStream.size() + topLeftPixelsLsbBitStream.size());
+            - (huffmanTableBitStream.size() + lengthsBitStream.size() + rlcEncodedBitStream.size() + lsbEncodedBitStream.size() + hashsesBitStream.size() + topLeftPixelsLsbBitStream.size());
 
         BOOST_LOG_TRIVIAL(info) << "Maximum bits of user-data to embed: " << maxUserDataSize;
 
-        if (t_MaxEmbeddingRate != std::nullopt) {
-            t_MaxEmbeddingRate->get() = tMax;
-        }
+        assert(lengthsBitStream.size() == omegaOneBlocks * constsRef.GetRlcEncodedMaxSize());
+        assert(lsbEncodedBitStream.size() == xi * (constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1) - constsRef.GetAlpha()));
+        assert(hashsesBitStream.size() == constsRef.GetLsbHashSize() * xi);
+        assert(topLeftPixelsLsbBitStream.size() == totalBlocks);
 
-        if (t_MaxUserDataBits != std::nullopt) {
-            t_MaxUserDataBits->get() = maxUserDataSize;
-        }
+        /* Everything, that doesn't depend on user data, is saved in the carrier. */
+        t_Carrier.m_SideInfoBitStream.reserve(
+            huffmanTableBitStream.size() + lengthsBitStream.size() + rlcEncodedBitStream.size() + lsbEncodedBitStream.size() + hashsesBitStream.size() + topLeftPixelsLsbBitStream.size()
+        );
+        t_Carrier.m_SideInfoBitStream.append(huffmanTableBitStream).append(lengthsBitStream).append(rlcEncodedBitStream).append(lsbEncodedBitStream)
+            .append(hashsesBitStream).append(topLeftPixelsLsbBitStream);
 
-        if (tMax < 0.0f) {
-            throw std::invalid_argument(
-                "Incorrect parameters are set for data embedder! "
-                "Consider using default parameters. Or find more appropriate values."
-            );
+        t_Carrier.m_LocationMap.reserve(totalBlocks);
+        for (uint32_t imgY = 0; imgY < t_EncryptedImage.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_EncryptedImage.GetWidth(); imgX += 2) {
+                t_Carrier.m_LocationMap.push_back(t_EncryptedImage.GetPixel(imgY, imgX) & 1);
+            }
         }
 
-        if (t_Data.size() * 8 > maxUserDataSize) {
+        t_Carrier.m_DataEmbeddingKey = t_DataEmbeddingKey;
+        t_Carrier.m_Params = constsRef;
+        t_Carrier.m_OmegaOneBlocks = omegaOneBlocks;
+        t_Carrier.m_Xi = xi;
+        t_Carrier.m_MaxUserDataBits = maxUserDataSize;
+        t_Carrier.m_MaxEmbeddingRate = tMax;
+    }
+
+    BmpImage& Embedder::PackBitStream(BmpImage& t_EncryptedImage, const PreparedCarrier& t_Carrier, const std::vector<uint8_t>& t_Data,
+        std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion)
+    {
+        const Consts& constsRef = t_Carrier.m_Params;
+
+        const uint32_t omegaOneBlocks = t_Carrier.m_OmegaOneBlocks;
+        const uint32_t xi = t_Carrier.m_Xi;
+        const int32_t maxUserDataSize = t_Carrier.m_MaxUserDataBits;
+
+        /* Framed payload starts with its length and checksum. */
+        const uint32_t payloadHeaderSize = constsRef.IsPayloadFramed() ? constsRef.GetPayloadLengthSize() + constsRef.GetPayloadChecksumSize() : 0;
+
+        if (static_cast<int64_t>(t_Data.size()) * 8 + payloadHeaderSize > maxUserDataSize) {
             throw std::invalid_argument("User data size exceeds the maximum possible size!");
         }
 
         /* Concatenate everything into a single BitStream */
-        std::string userDataBitStream = utils::BytesToBinaryString(t_Data);
+        std::string userDataBitStream{ "" };
+        userDataBitStream.reserve(payloadHeaderSize + t_Data.size() * 8);
 
-        assert(lengthsBitStream.size() == omegaOneBlocks * constsRef.GetRlcEncodedMaxSize());
-        assert(lsbEncodedBitStream.size() == xi * (constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1) - constsRef.GetAlpha()));
-        assert(hashsesBitStream.size() == constsRef.GetLsbHashSize() * xi);
-        assert(topLeftPixelsLsbBitStream.size() == totalBlocks);
+        if (constsRef.IsPayloadFramed()) {
+            userDataBitStream.append(std::bitset<32>(static_cast<uint32_t>(t_Data.size())).to_string());
+            userDataBitStream.append(std::bitset<32>(utils::CalculateCRC32(t_Data)).to_string());
+        }
+
+        userDataBitStream.append(utils::BytesToBinaryString(t_Data));
 
         assert(userDataBitStream.size() % 8 == 0);
 
-        std::string assembledBitStream = 
-            lengthsBitStream + rlcEncodedBitStream + lsbEncodedBitStream + 
-            hashsesBitStream + topLeftPixelsLsbBitStream + userDataBitStream + std::string(maxUserDataSize - userDataBitStream.size(), '0');
+        std::string assembledBitStream{ "" };
+        assembledBitStream.reserve(t_Carrier.m_SideInfoBitStream.size() + maxUserDataSize);
+        assembledBitStream.append(t_Carrier.m_SideInfoBitStream).append(userDataBitStream).append(maxUserDataSize - userDataBitStream.size(), '0');
         
         assert(assembledBitStream.size() == 24 * omegaOneBlocks + xi * constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1));
         
         std::array<uint32_t, 5> hash;
 
         /* Use sha1 of a data-hiding key as a seed for PRNG */
-        utils::CalculateSHA1(t_DataEmbeddingKey, hash);
+        utils::CalculateSHA1(t_Carrier.m_DataEmbeddingKey, hash);
         std::seed_seq seq(hash.begin(), hash.end());
         
         /* Shuffle BitStream, before embedding */
+        PhaseScope shufflePhase("Embed.Shuffle");
         utils::ShuffleFisherYates(seq, assembledBitStream);
+        shufflePhase.End();
 
         auto sliceBegin = assembledBitStream.begin();
         auto sliceEnd = assembledBitStream.begin();
@@ -249,9 +651,36 @@ namespace rdh {
         uint32_t totalBitsWrittenRlc{ 0 };
         uint32_t totalBitsWrittenLsb{ 0 };
 
+        /**
+         * Distortion tracking. Pixels of the block are saved before they are overwritten. Top-left pixels already have
+         * the location map bit set, so their original LSBs are taken from F (the last part of the side information).
+         */
+        const uint32_t blocksInRow = t_EncryptedImage.GetWidth() / 2;
+        const char* topLeftPixelsLsbs = t_Carrier.m_SideInfoBitStream.data() + t_Carrier.m_SideInfoBitStream.size() - t_Carrier.m_LocationMap.size();
+        std::array<int32_t, 4> blockBeforeEmbedding{};
+        uint64_t squaredErrorSum{ 0 };
+
+        const auto accumulateDistortion = [&](uint32_t t_Y, uint32_t t_X) {
+            for (uint32_t pxIdx = 0; pxIdx < 4; ++pxIdx) {
+                const int32_t difference = static_cast<int32_t>(t_EncryptedImage.GetPixel(t_Y + pxIdx / 2, t_X + pxIdx % 2)) - blockBeforeEmbedding[pxIdx];
+                squaredErrorSum += static_cast<uint64_t>(difference * difference);
+            }
+        };
+
         /* Last step. Pack all data into the image. */
+        PhaseScope writePhase("Embed.WriteBlocks");
         for (uint32_t imgY = 0; imgY < t_EncryptedImage.GetHeight(); imgY += 2) {
             for (uint32_t imgX = 0; imgX < t_EncryptedImage.GetWidth(); imgX += 2) {
+                if (t_Distortion != std::nullopt) {
+                    const uint32_t blockIdx = (imgY / 2) * blocksInRow + imgX / 2;
+                    blockBeforeEmbedding = {
+                        (t_EncryptedImage.GetPixel(imgY, imgX) & ~1) | ((topLeftPixelsLsbs[blockIdx] == '1') ? 1 : 0),
+                        t_EncryptedImage.GetPixel(imgY, imgX + 1),
+                        t_EncryptedImage.GetPixel(imgY + 1, imgX),
+                        t_EncryptedImage.GetPixel(imgY + 1, imgX + 1)
+                    };
+                }
+
                 /* What type of block we are currently looking at? */
                 if (t_EncryptedImage.GetPixel(imgY, imgX) & 1) {
                     assert(sliceBegin == sliceEnd);
@@ -287,6 +716,11 @@ namespace rdh {
                     
                     /* Check, if we've filled all of the allowed LSB-encoded blocks with data */
                     if (totalBitsWrittenLsb >= xi * constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1)) {
+                        /* Only the location map bit was changed. */
+                        if (t_Distortion != std::nullopt) {
+                            accumulateDistortion(imgY, imgX);
+                        }
+
                         continue;
                     }
 
@@ -344,8 +778,18 @@ namespace rdh {
 
                     utils::Advance(sliceBegin, assembledBitStream.end(), constsRef.GetLsbLayers());
                 }
+
+                if (t_Distortion != std::nullopt) {
+                    accumulateDistortion(imgY, imgX);
+                }
             }
         }
+        writePhase.End();
+
+        if (t_Distortion != std::nullopt) {
+            t_Distortion->get().m_SquaredErrorSum = squaredErrorSum;
+            t_Distortion->get().m_PixelsCount = static_cast<uint64_t>(t_EncryptedImage.GetHeight()) * t_EncryptedImage.GetWidth();
+        }
 
         assert(sliceBegin == assembledBitStream.end());
 
@@ -356,6 +800,242 @@ namespace rdh {
         return t_EncryptedImage;
     }
 
+    BmpImage& Embedder::UpdatePayload(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, uint32_t t_Offset, const std::vector<uint8_t>& t_NewBytes)
+    {
+        Consts& constsRef = Consts::Instance();
+
+        /* Each tile has its own key, permutation and framed chunk, so the single-container layout doesn't apply. */
+        if (constsRef.GetTileSize() != 0) {
+            throw std::invalid_argument("Payload of the tile-partitioned container can't be updated in place!");
+        }
+
+        if (t_NewBytes.empty()) {
+            return t_MarkedEncryptedImage;
+        }
+
+        /* In the article it's referred as L. */
+        uint32_t totalBlocks{
+            static_cast<uint32_t>(static_cast<std::size_t>(t_MarkedEncryptedImage.GetHeight()) * static_cast<std::size_t>(t_MarkedEncryptedImage.GetWidth()) / 4)
+        };
+
+        /* In the article it's referred as R. */
+        uint32_t omegaOneBlocks{ 0 };
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
+                omegaOneBlocks += t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1;
+            }
+        }
+
+        uint32_t xi = utils::math::Floor((float)(totalBlocks - omegaOneBlocks) / (float)constsRef.GetLambda());
+        uint32_t totalBits = 24 * omegaOneBlocks + xi * constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1);
+
+        /**
+         * Shuffle stream positions the same way, as the bitstream was shuffled while embedding.
+         * Then shuffledPositions[i] is the position inside of the assembled bitstream of the i-th shuffled bit.
+         */
+        std::vector<uint32_t> shuffledPositions(totalBits);
+        std::iota(shuffledPositions.begin(), shuffledPositions.end(), 0);
+
+        std::array<uint32_t, 5> hash;
+        utils::CalculateSHA1(t_DataEmbeddingKey, hash);
+        std::seed_seq seq(hash.begin(), hash.end());
+        utils::ShuffleFisherYates(seq, shuffledPositions);
+
+        /**
+         * Positions inside of the shuffled bitstream of the assembled bits [begin, end) of each of t_Ranges (concatenated).
+         * The inverse permutation isn't kept, only the needed positions are collected in a single pass.
+         */
+        const auto collectStreamPositions = [&](const std::vector<std::pair<uint64_t, uint64_t>>& t_Ranges) {
+            std::vector<uint64_t> rangesOffset;
+            uint64_t totalPositions{ 0 };
+            for (const auto& [begin, end] : t_Ranges) {
+                rangesOffset.push_back(totalPositions);
+                totalPositions += end - begin;
+            }
+
+            std::vector<uint32_t> streamPositions(totalPositions);
+            for (uint32_t shuffledPos = 0; shuffledPos < totalBits; ++shuffledPos) {
+                const uint32_t assembledPos = shuffledPositions[shuffledPos];
+
+                for (uint32_t rangeIdx = 0; rangeIdx < t_Ranges.size(); ++rangeIdx) {
+                    if (assembledPos >= t_Ranges[rangeIdx].first && assembledPos < t_Ranges[rangeIdx].second) {
+                        streamPositions[rangesOffset[rangeIdx] + assembledPos - t_Ranges[rangeIdx].first] = shuffledPos;
+                    }
+                }
+            }
+
+            return streamPositions;
+        };
+
+        /* Reads assembled bits [t_Begin, t_End) from the image. */
+        const auto readAssembledBits = [&](uint64_t t_Begin, uint64_t t_End) {
+            if (t_End > totalBits) {
+                throw std::invalid_argument("Embedded bitstream is too short! Wrong key or parameters?");
+            }
+
+            const std::vector<StreamBitLocation> locations = LocateStreamBits(t_MarkedEncryptedImage, omegaOneBlocks, collectStreamPositions({ { t_Begin, t_End } }));
+
+            std::string bits;
+            bits.reserve(locations.size());
+            for (const auto& location : locations) {
+                bits += utils::math::GetNthBit(t_MarkedEncryptedImage.GetPixel(location.m_Y, location.m_X), location.m_BitPos) ? '1' : '0';
+            }
+
+            return bits;
+        };
+
+        /* Per-image Huffman code is skipped, only its length is needed. */
+        uint64_t lengthsBegin{ 0 };
+        if (constsRef.IsHuffmanAdaptive()) {
+            lengthsBegin = constsRef.GetHuffmanTableLengthSize() +
+                std::stoul(readAssembledBits(0, constsRef.GetHuffmanTableLengthSize()), nullptr, 2);
+        }
+
+        /* Lengths of the RLC-compressed blocks define, where the user data starts. */
+        const std::string lengthsBitStream = readAssembledBits(lengthsBegin, lengthsBegin + static_cast<uint64_t>(omegaOneBlocks) * constsRef.GetRlcEncodedMaxSize());
+
+        uint32_t rlcEncodedBitStreamSize{ 0 };
+        for (uint32_t blockIdx = 0; blockIdx < omegaOneBlocks; ++blockIdx) {
+            const uint32_t length = std::stoul(lengthsBitStream.substr(blockIdx * constsRef.GetRlcEncodedMaxSize(), constsRef.GetRlcEncodedMaxSize()), nullptr, 2);
+            if (length >= constsRef.GetThreshold()) {
+                throw std::invalid_argument("Inconsistent RLC-compressed blocks lengths! Wrong key or parameters?");
+            }
+            rlcEncodedBitStreamSize += length;
+        }
+
+        /* Offsets are computed in 64 bits, so that a large t_Offset can't wrap around into the embedded data. */
+        const uint64_t userDataBegin = lengthsBegin + lengthsBitStream.size() + rlcEncodedBitStreamSize +
+            static_cast<uint64_t>(xi) * (constsRef.GetGroupSizeAfterCompression() + constsRef.GetLsbHashSize()) + totalBlocks;
+
+        /* Assembled bits to rewrite and their new values. */
+        uint64_t updateBegin = userDataBegin + 8 * static_cast<uint64_t>(t_Offset);
+        std::string updateBitStream = utils::BytesToBinaryString(t_NewBytes);
+
+        std::optional<std::string> checksumBitStream;
+
+        if (constsRef.IsPayloadFramed()) {
+            const uint32_t headerSize = constsRef.GetPayloadLengthSize() + constsRef.GetPayloadChecksumSize();
+            const std::string header = readAssembledBits(userDataBegin, userDataBegin + headerSize);
+
+            const uint64_t payloadBytes = std::bitset<32>(header.substr(0, constsRef.GetPayloadLengthSize())).to_ulong();
+            const uint32_t payloadChecksum = static_cast<uint32_t>(std::bitset<32>(header.substr(constsRef.GetPayloadLengthSize())).to_ulong());
+
+            if (static_cast<uint64_t>(t_Offset) + t_NewBytes.size() > payloadBytes) {
+                throw std::invalid_argument("Updated bytes exceed the framed payload size!");
+            }
+
+            /**
+             * Checksum of the whole payload is verified before anything is rewritten, so that a wrong key or parameters are
+             * rejected. So updating a framed payload reads all of it back: O(payload), not O(updated bytes).
+             */
+            const uint64_t payloadBegin = userDataBegin + headerSize;
+            const std::string payloadBitStream = readAssembledBits(payloadBegin, payloadBegin + 8 * payloadBytes);
+
+            std::vector<uint8_t> payload(payloadBytes);
+            utils::PackBits(payloadBitStream, payload.data());
+
+            if (utils::CalculateCRC32(payload) != payloadChecksum) {
+                throw std::invalid_argument("Framed payload checksum mismatch! Wrong key or parameters?");
+            }
+
+            std::copy(t_NewBytes.begin(), t_NewBytes.end(), payload.begin() + t_Offset);
+            checksumBitStream = std::bitset<32>(utils::CalculateCRC32(payload)).to_string();
+
+            updateBegin += headerSize;
+        }
+        else if (userDataBegin > totalBits || static_cast<uint64_t>(t_Offset) + t_NewBytes.size() > (totalBits - userDataBegin) / 8) {
+            throw std::invalid_argument("Updated bytes exceed the maximum user data size!");
+        }
+
+        /* Rewrite pixel bits, that hold the updated bits (and the checksum). */
+        std::vector<std::pair<uint64_t, uint64_t>> updatedRanges{ { updateBegin, updateBegin + updateBitStream.size() } };
+        if (checksumBitStream) {
+            const uint64_t checksumBegin = userDataBegin + constsRef.GetPayloadLengthSize();
+            updatedRanges.emplace_back(checksumBegin, checksumBegin + checksumBitStream->size());
+            updateBitStream.append(*checksumBitStream);
+        }
+
+        const std::vector<StreamBitLocation> locations = LocateStreamBits(t_MarkedEncryptedImage, omegaOneBlocks, collectStreamPositions(updatedRanges));
+        for (uint32_t bitIdx = 0; bitIdx < locations.size(); ++bitIdx) {
+            const auto& location = locations[bitIdx];
+            t_MarkedEncryptedImage.SetPixel(location.m_Y, location.m_X, utils::math::SetNthBitToX(
+                t_MarkedEncryptedImage.GetPixel(location.m_Y, location.m_X), location.m_BitPos, updateBitStream[bitIdx] == '1'
+            ));
+        }
+
+        return t_MarkedEncryptedImage;
+    }
+
+    std::vector<Embedder::StreamBitLocation> Embedder::LocateStreamBits(const BmpImage& t_MarkedEncryptedImage, uint32_t t_OmegaOneBlocks, const std::vector<uint32_t>& t_StreamPositions)
+    {
+        Consts& constsRef = Consts::Instance();
+
+        std::vector<StreamBitLocation> locations(t_StreamPositions.size());
+
+        /* Visit positions in increasing order, so that the image is traversed only once. */
+        std::vector<uint32_t> order(t_StreamPositions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t t_Lhs, uint32_t t_Rhs) {
+            return t_StreamPositions[t_Lhs] < t_StreamPositions[t_Rhs];
+        });
+
+        const uint32_t totalBlocks{
+            static_cast<uint32_t>(static_cast<std::size_t>(t_MarkedEncryptedImage.GetHeight()) * static_cast<std::size_t>(t_MarkedEncryptedImage.GetWidth()) / 4)
+        };
+
+        const uint32_t lsbLayers = constsRef.GetLsbLayers();
+        const uint32_t xi = utils::math::Floor((float)(totalBlocks - t_OmegaOneBlocks) / (float)constsRef.GetLambda());
+        const uint32_t totalBitsFromLsbEncodedGroups = xi * constsRef.GetLambda() * (4 * lsbLayers - 1);
+
+        /* Position of the first bit of the current block inside of the shuffled bitstream. */
+        uint32_t blockBegin{ 0 };
+        uint32_t bitsFromLsbEncodedGroups{ 0 };
+        auto orderIter = order.begin();
+
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight() && orderIter != order.end(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth() && orderIter != order.end(); imgX += 2) {
+                const bool isRlcEncoded = t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1;
+
+                /* Same layout, as in the packing loop of Embed. */
+                uint32_t blockBits{ 0 };
+                if (isRlcEncoded) {
+                    blockBits = 24;
+                }
+                else if (bitsFromLsbEncodedGroups < totalBitsFromLsbEncodedGroups) {
+                    blockBits = 4 * lsbLayers - 1;
+                    bitsFromLsbEncodedGroups += blockBits;
+                }
+
+                for (; orderIter != order.end() && t_StreamPositions[*orderIter] < blockBegin + blockBits; ++orderIter) {
+                    const uint32_t bitInBlock = t_StreamPositions[*orderIter] - blockBegin;
+                    StreamBitLocation& location = locations[*orderIter];
+
+                    if (isRlcEncoded) {
+                        /* Top-right, down-left and down-right pixels, most significant bit first. */
+                        const uint32_t pxIdx = 1 + bitInBlock / 8;
+                        location = { imgY + pxIdx / 2, imgX + pxIdx % 2, static_cast<uint8_t>(7 - bitInBlock % 8) };
+                    }
+                    else if (bitInBlock < lsbLayers - 1) {
+                        /* Top-left pixel, its first LSB is the location map bit. */
+                        location = { imgY, imgX, static_cast<uint8_t>(lsbLayers - 1 - bitInBlock) };
+                    }
+                    else {
+                        const uint32_t pxIdx = 1 + (bitInBlock - (lsbLayers - 1)) / lsbLayers;
+                        location = { imgY + pxIdx / 2, imgX + pxIdx % 2, static_cast<uint8_t>(lsbLayers - 1 - (bitInBlock - (lsbLayers - 1)) % lsbLayers) };
+                    }
+                }
+
+                blockBegin += blockBits;
+            }
+        }
+
+        if (orderIter != order.end()) {
+            throw std::invalid_argument("Stream position is outside of the embedded bitstream!");
+        }
+
+        return locations;
+    }
+
     void Embedder::PreparePseudoRandomMatrix(Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>& t_Mat, const std::vector<uint8_t>& t_DataEmbeddingKey)
     {
         std::array<uint32_t, 5> hash;
@@ -376,7 +1056,7 @@ namespace rdh {
     std::string Embedder::HashLsbBlock(const Group& t_CurGroup, const std::vector<uint8_t>& t_DataEmbeddingKey, bool t_ReinitRandomMatrix)
     {
         std::string hash{ "" };
-        static Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> randomMatrix(Consts::Instance().GetLsbHashSize(), Consts::Instance().GetGroupSizeBeforeCompression());
+        static thread_local Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> randomMatrix(Consts::Instance().GetLsbHashSize(), Consts::Instance().GetGroupSizeBeforeCompression());
 
         if (t_ReinitRandomMatrix) {
             randomMatrix = Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>(Consts::Instance().GetLsbHashSize(), Consts::Instance().GetGroupSizeBeforeCompression());
@@ -2,15 +2,110 @@
 
 #include <vector>
 #include <bitset>
+#include <functional>
+#include <optional>
 
 #include "types.h"
 #include "image/bmp_image.h"
 #include "embedder/consts.h"
-#include "extractor/extractor.h"
+#include "embedder/embedding_params.h"
 
 #include "Eigen/Dense"
 
 namespace rdh {
+    namespace bench {
+        /* Kernel microbenchmarks (benchmarks/bench_kernels.cpp). */
+        class Kernels;
+    }
+
+    /**
+     * @brief Distortion of the marked encrypted image relative to the encrypted image before embedding.
+     * Accumulated while the pixels are written, so no separate pass over the images is needed.
+    */
+    struct EmbeddingDistortion {
+        /**
+         * @brief Sum of squared differences of all of the pixels.
+        */
+        uint64_t m_SquaredErrorSum{ 0 };
+
+        /**
+         * @brief Number of pixels in the image.
+        */
+        uint64_t m_PixelsCount{ 0 };
+
+        /**
+         * @brief Mean squared error (the same value, as ImageQuality::CalculateMSE gives for the images).
+        */
+        double GetMSE() const;
+
+        /**
+         * @brief PSNR (the same value, as ImageQuality::CalculatePSNR gives for the images).
+        */
+        double GetPSNR() const;
+    };
+
+    /**
+     * @brief Encrypted image, that is already classified and compressed (see Embedder::Prepare).
+     * Holds everything, that doesn't depend on user data, so that many payloads
+     * can be embedded into the same carrier, doing only payload assembly and packing.
+    */
+    class PreparedCarrier {
+    public:
+        /**
+         * @brief Embeds data into a copy of the prepared image. The carrier itself is not modified.
+         * @param t_Data Data to embed
+         * @param t_Distortion [out] distortion of the returned image relative to the encrypted image, that was prepared (optional).
+         * @return New encrypted image with embedded data into it.
+        */
+        BmpImage Embed(const std::vector<uint8_t>& t_Data, std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion = std::nullopt) const;
+
+        /**
+         * @brief Location map (if value is 1 - block is compressed using rlc, otherwise - using lsb).
+        */
+        const std::vector<bool>& GetLocationMap() const { return m_LocationMap; }
+
+        /**
+         * @brief Side information bitstream {\Re || C || \Lambda || H || F }, before shuffling.
+        */
+        const std::string& GetSideInfoBitStream() const { return m_SideInfoBitStream; }
+
+        /**
+         * @brief Parameters, that were used to prepare the carrier.
+        */
+        const Consts& GetParams() const { return m_Params; }
+
+        uint32_t GetMaxUserDataBits() const { return m_MaxUserDataBits; }
+        double GetMaxEmbeddingRate() const { return m_MaxEmbeddingRate; }
+
+    private:
+        PreparedCarrier() = default;
+
+        /**
+         * @brief Encrypted image with location map bits set. Empty, if the carrier was prepared in place.
+        */
+        BmpImage m_PreparedImage{ 0, 0 };
+
+        std::string m_SideInfoBitStream;
+        std::vector<bool> m_LocationMap;
+        std::vector<uint8_t> m_DataEmbeddingKey;
+        Consts m_Params;
+
+        /**
+         * @brief Number of blocks encoded using RLC-based algorithm. In the article it's referred as R.
+        */
+        uint32_t m_OmegaOneBlocks{ 0 };
+
+        /**
+         * @brief Number of LSB-compressed groups. In the article it's referred as \xi.
+        */
+        uint32_t m_Xi{ 0 };
+
+        int32_t m_MaxUserDataBits{ 0 };
+        double m_MaxEmbeddingRate{ 0.0 };
+
+        friend class Embedder;
+    };
+
     class Embedder {
     public:
         using Group = Eigen::Matrix<uint8_t, Eigen::Dynamic, 1>;
@@ -18,15 +113,164 @@ namespace rdh {
         /**
          * @brief Embeds data into image t_PlainImage
          * @param t_EncryptedEmptyImage Encrypted image where additional data will be embedded
-         * @param t_Data Data to embed
+         * @param t_Data Data to embed (prepended with its length and CRC-32, if Consts::IsPayloadFramed is set)
          * @param t_DataEmbeddingKey key to use to embed data
          * @param t_MaxEmbeddingRate std::optional to use with benchmarks
          * @param t_MaxUserDataBits std::optional to use with benchmarks
+         * @param t_Distortion [out] distortion of the marked image relative to t_EncryptedImage before embedding (optional).
+         * Squared errors are accumulated during pixel writes, so it's cheaper, than comparing the images afterwards.
          * @return Encrypted image with embedded data into it (Edited t_EncryptedImage).
+         * If Consts::GetTileSize is not zero, image is embedded as a tile-partitioned container.
+        */
+
+        static BmpImage& Embed(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits,
+            std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion = std::nullopt);
+
+        /**
+         * @brief Classifies blocks of t_EncryptedImage and compresses them, without embedding any data.
+         * Use PreparedCarrier::Embed to embed payloads into the prepared image.
+         * @param t_EncryptedImage Encrypted image to prepare (is not modified).
+         * @param t_DataEmbeddingKey key to use to embed data
+         * @param t_Params parameters to use (global ones by default).
+         * @return Immutable prepared carrier.
         */
+        static PreparedCarrier Prepare(const BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, const Consts& t_Params = Consts::Instance());
 
-        static BmpImage& Embed(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits);
+        /**
+         * @brief Overwrites part of the already embedded user data in place. Each bit of the
+         * shuffled bitstream is stored in a fixed pixel bit, so only the pixel bits,
+         * that hold the updated bytes, are rewritten (and the checksum bits, if the payload is framed).
+         * Image is not classified, and groups are not compressed again. Framed payload is read back
+         * completely to verify its checksum, before it's updated.
+         * @param t_MarkedEncryptedImage Image with embedded data (Edited in place).
+         * @param t_DataEmbeddingKey key, that was used to embed data.
+         * @param t_Offset offset (in bytes) of the first byte to update inside of the user data.
+         * @param t_NewBytes new bytes of the user data.
+         * @return Updated image (Edited t_MarkedEncryptedImage).
+         * @throw std::invalid_argument if the update doesn't fit into the payload, the key/parameters are wrong,
+         * or the image is a tile-partitioned container (Consts::GetTileSize is not zero).
+        */
+        static BmpImage& UpdatePayload(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, uint32_t t_Offset, const std::vector<uint8_t>& t_NewBytes);
     private:
+        /**
+         * @brief Tile of the tile-partitioned container (see Consts::GetTileSize).
+        */
+        struct ContainerTile {
+            uint32_t m_Y;
+            uint32_t m_X;
+            uint32_t m_Height;
+            uint32_t m_Width;
+        };
+
+        /**
+         * @brief Embeds data into the tile-partitioned container. Tiles are prepared and packed concurrently,
+         * each one with its own key (see DeriveTileKey) and framed payload chunk. Chunks fill the tiles in order.
+         * Parameters are the same, as for Embed.
+        */
+        static BmpImage& EmbedTiled(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_Data, const std::vector<uint8_t>& t_DataEmbeddingKey, std::optional<std::reference_wrapper<double>> t_MaxEmbeddingRate, std::optional<std::reference_wrapper<uint32_t>> t_MaxUserDataBits,
+            std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion);
+
+        /**
+         * @brief Splits image into tiles of size t_TileSize x t_TileSize in raster order. Tiles on the edges can be smaller.
+         * @param t_Image image to split.
+         * @param t_TileSize tile size (should be even).
+         * @return tiles of the image.
+        */
+        static std::vector<ContainerTile> SplitIntoTiles(const BmpImage& t_Image, uint32_t t_TileSize);
+
+        /**
+         * @brief Derives data embedding key of a tile, so that each tile gets its own permutation and matrices.
+         * @param t_DataEmbeddingKey data embedding key of the whole image.
+         * @param t_TileIdx index of the tile.
+         * @return data embedding key of the tile.
+        */
+        static std::vector<uint8_t> DeriveTileKey(const std::vector<uint8_t>& t_DataEmbeddingKey, uint32_t t_TileIdx);
+
+        /**
+         * @brief Parameters, that are used to embed/extract a single tile: the same as t_Params, but not tiled and with framed payload.
+        */
+        static Consts TileParams(const Consts& t_Params);
+
+        /**
+         * @brief Copies tile t_Tile out of t_Image.
+        */
+        static BmpImage CropTile(BmpImage& t_Image, const ContainerTile& t_Tile);
+
+        /**
+         * @brief Copies t_TileImage back into t_Image at the position of t_Tile.
+        */
+        static void PasteTile(BmpImage& t_Image, const BmpImage& t_TileImage, const ContainerTile& t_Tile);
+
+        /**
+         * @brief Calls t_Worker(tileIdx) for each of t_TilesCount tiles using all of the available threads.
+         * Each worker sees the same Consts::Instance() as the caller.
+         * The first exception thrown by a worker is rethrown after all of the threads are joined.
+        */
+        static void ForEachTile(uint32_t t_TilesCount, const std::function<void(uint32_t)>& t_Worker);
+
+        /**
+         * @brief Classifies and compresses blocks of t_EncryptedImage, sets location map bits in it,
+         * and saves everything, that doesn't depend on user data, into t_Carrier.
+         * @param t_EncryptedImage Encrypted image to prepare (Edited in place).
+         * @param t_DataEmbeddingKey key to use to embed data
+         * @param t_Carrier carrier to fill.
+        */
+        static void PrepareInPlace(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, PreparedCarrier& t_Carrier);
+
+        /**
+         * @brief PrepareInPlace kernel for the parameters Params (see DispatchEmbeddingParams).
+        */
+        template <class Params>
+        static void PrepareInPlaceKernel(BmpImage& t_EncryptedImage, const std::vector<uint8_t>& t_DataEmbeddingKey, PreparedCarrier& t_Carrier);
+
+        /**
+         * @brief Accumulates LSBs of \omega_2 blocks into groups, compresses full groups and calculates their hashes.
+         * Specialized version keeps groups in fixed-size bitsets, and because \psi = [I | Z], only
+         * XORs in the columns of Z selected by the last \alpha bits. DynamicEmbeddingParams version
+         * uses Eigen matrices (CompressCurrentGroup).
+        */
+        template <class Params>
+        class GroupCompressor;
+
+        /**
+         * @brief Builds length-limited canonical Huffman code from the RLC symbols of the image blocks, and picks it,
+         * if it allows to embed more data than the default code (taking into account the size of the serialized code).
+         * @param t_EncryptedImage Image to build the code for.
+         * @param t_HuffmanTableBitStream [out] Serialized code, prefixed with its length (only the zero length for the default code).
+         * @return Chosen code.
+        */
+        static RlcHuffmanCode SelectHuffmanCode(const BmpImage& t_EncryptedImage, std::string& t_HuffmanTableBitStream);
+
+        /**
+         * @brief Assembles and shuffles the final bitstream, and packs it into the prepared image.
+         * @param t_EncryptedImage Image, that was prepared using t_Carrier (Edited in place).
+         * @param t_Carrier prepared carrier.
+         * @param t_Data Data to embed
+         * @param t_Distortion [out] if set, squared error of every written pixel is accumulated against its value before
+         * PrepareInPlace (the original LSBs of the top-left pixels are taken from the F part of the side information).
+         * @return Encrypted image with embedded data into it (Edited t_EncryptedImage).
+        */
+        static BmpImage& PackBitStream(BmpImage& t_EncryptedImage, const PreparedCarrier& t_Carrier, const std::vector<uint8_t>& t_Data,
+            std::optional<std::reference_wrapper<EmbeddingDistortion>> t_Distortion = std::nullopt);
+
+        /**
+         * @brief Pixel bit, where a bit of the shuffled bitstream is stored.
+        */
+        struct StreamBitLocation {
+            uint32_t m_Y;
+            uint32_t m_X;
+            uint8_t m_BitPos;
+        };
+
+        /**
+         * @brief Finds pixel bits, where the bits of the shuffled bitstream are stored.
+         * @param t_MarkedEncryptedImage Image with embedded data.
+         * @param t_OmegaOneBlocks number of the RLC-compressed blocks of the image (counted once by the caller).
+         * @param t_StreamPositions positions inside of the shuffled bitstream.
+         * @return location for each of the t_StreamPositions (in the same order).
+        */
+        static std::vector<StreamBitLocation> LocateStreamBits(const BmpImage& t_MarkedEncryptedImage, uint32_t t_OmegaOneBlocks, const std::vector<uint32_t>& t_StreamPositions);
+
         /**
          * @brief Fills matrix using data key, and PRNG.
          * @param t_Mat matrix to fill.
@@ -57,5 +301,7 @@ namespace rdh {
         static void CompressCurrentGroup(const Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>& t_Psi, const Group& t_LsbEncodedGroup, std::string& t_LsbEncodedBitStream, std::string& t_HashsesBitStream, const std::vector<uint8_t>& t_DataEmbeddingKey, bool t_ReinitRandomMatrix);
 
         friend class Extractor;
+        friend class PreparedCarrier;
+        friend class bench::Kernels;
     };
 }
\ No newline at end of file
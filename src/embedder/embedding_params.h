@@ -0,0 +1,102 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "types.h"
+#include "utils.h"
+#include "embedder/consts.h"
+
+namespace rdh {
+    /**
+     * @brief Embedding parameters, that are known at compile time. Kernels instantiated with them
+     * get constant group sizes (fixed-size bit buffers) and constant LSB-layers loops (unrolled by the compiler).
+     * Getters take Consts only to have the same interface as DynamicEmbeddingParams.
+     * @tparam Threshold threshold for blocks classification.
+     * @tparam LsbLayers number of lsb layers. In the article it's referred as u.
+     * @tparam Lambda blocks group size. In the article it's referred as \lambda.
+     * @tparam Alpha number of bits, that can be embedded into each group. In the article it's referred as \alpha.
+     * @tparam LsbHashSize hash size for LSB-encoded groups. In the article it's referred as \beta.
+    */
+    template <uint16_t Threshold, uint16_t LsbLayers, uint16_t Lambda, uint16_t Alpha, uint16_t LsbHashSize>
+    struct EmbeddingParams {
+        static constexpr bool c_IsSpecialized{ true };
+
+        static constexpr uint16_t c_LsbLayers{ LsbLayers };
+        static constexpr uint16_t c_Alpha{ Alpha };
+        static constexpr uint16_t c_LsbHashSize{ LsbHashSize };
+        static constexpr uint32_t c_GroupSizeBeforeCompression{ static_cast<uint32_t>(Lambda) * (4 * static_cast<uint32_t>(LsbLayers) - 1) };
+        static constexpr uint32_t c_GroupSizeAfterCompression{ c_GroupSizeBeforeCompression - Alpha };
+
+        static_assert(LsbLayers >= 1 && LsbLayers <= 8, "Lsb layers should be in range [1, 8]");
+        static_assert(Alpha < c_GroupSizeBeforeCompression, "Alpha should be less than group size");
+
+        static constexpr uint16_t GetThreshold(const Consts&) { return Threshold; }
+        static constexpr uint16_t GetLsbLayers(const Consts&) { return LsbLayers; }
+        static constexpr uint16_t GetLambda(const Consts&) { return Lambda; }
+        static constexpr uint16_t GetAlpha(const Consts&) { return Alpha; }
+        static constexpr uint16_t GetLsbHashSize(const Consts&) { return LsbHashSize; }
+        static constexpr uint32_t GetGroupSizeBeforeCompression(const Consts&) { return c_GroupSizeBeforeCompression; }
+        static constexpr uint32_t GetGroupSizeAfterCompression(const Consts&) { return c_GroupSizeAfterCompression; }
+
+        /**
+         * @brief Checks, if runtime parameters t_Consts are the same, as these ones.
+        */
+        static bool Matches(const Consts& t_Consts)
+        {
+            return t_Consts.GetThreshold() == Threshold && t_Consts.GetLsbLayers() == LsbLayers &&
+                t_Consts.GetLambda() == Lambda && t_Consts.GetAlpha() == Alpha && t_Consts.GetLsbHashSize() == LsbHashSize;
+        }
+    };
+
+    /**
+     * @brief Generic fallback: parameters are read from Consts at runtime.
+    */
+    struct DynamicEmbeddingParams {
+        static constexpr bool c_IsSpecialized{ false };
+
+        static uint16_t GetThreshold(const Consts& t_Consts) { return t_Consts.GetThreshold(); }
+        static uint16_t GetLsbLayers(const Consts& t_Consts) { return t_Consts.GetLsbLayers(); }
+        static uint16_t GetLambda(const Consts& t_Consts) { return t_Consts.GetLambda(); }
+        static uint16_t GetAlpha(const Consts& t_Consts) { return t_Consts.GetAlpha(); }
+        static uint16_t GetLsbHashSize(const Consts& t_Consts) { return t_Consts.GetLsbHashSize(); }
+        static uint32_t GetGroupSizeBeforeCompression(const Consts& t_Consts) { return t_Consts.GetGroupSizeBeforeCompression(); }
+        static uint32_t GetGroupSizeAfterCompression(const Consts& t_Consts) { return t_Consts.GetGroupSizeAfterCompression(); }
+
+        static bool Matches(const Consts&) { return true; }
+    };
+
+    /**
+     * @brief Parameter sets, for which specialized kernels are compiled: the default one, and its
+     * variants with more LSB layers. Every preset adds one more instantiation of each kernel.
+    */
+    using EmbeddingPresets = std::tuple<
+        EmbeddingParams<14, 1, 400, 6, 3>,
+        EmbeddingParams<14, 2, 400, 6, 3>,
+        EmbeddingParams<14, 3, 400, 6, 3>
+    >;
+
+    /**
+     * @brief Calls t_Visitor(Params{}), where Params is the first preset, that matches t_Consts,
+     * or DynamicEmbeddingParams, if there is no such preset.
+     * @param t_Consts runtime parameters.
+     * @param t_Visitor generic callable.
+    */
+    template <std::size_t PresetIdx = 0, class Visitor>
+    void DispatchEmbeddingParams(const Consts& t_Consts, Visitor&& t_Visitor)
+    {
+        if constexpr (PresetIdx < std::tuple_size_v<EmbeddingPresets>) {
+            using Params = std::tuple_element_t<PresetIdx, EmbeddingPresets>;
+
+            if (Params::Matches(t_Consts)) {
+                t_Visitor(Params{});
+                return;
+            }
+
+            DispatchEmbeddingParams<PresetIdx + 1>(t_Consts, std::forward<Visitor>(t_Visitor));
+        }
+        else {
+            t_Visitor(DynamicEmbeddingParams{});
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include "embedder/embedder.h"
+#include "embedder/embedding_params.h"
+
+/**
+ * Definitions of Embedder::GroupCompressor. They are kept out of embedder.h, because only the embedder
+ * and the kernel benchmarks instantiate them.
+ */
+namespace rdh {
+    template <class Params>
+    class Embedder::GroupCompressor {
+    public:
+        GroupCompressor(const Consts&, const std::vector<uint8_t>& t_DataEmbeddingKey)
+        {
+            /* The same pseudo-random matrices, as the ones used by CompressCurrentGroup and HashLsbBlock. */
+            Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> pseudoRandomMat(c_P, c_Alpha);
+            PreparePseudoRandomMatrix(pseudoRandomMat, t_DataEmbeddingKey);
+
+            for (uint32_t colIdx = 0; colIdx < c_Alpha; ++colIdx) {
+                for (uint32_t rowIdx = 0; rowIdx < c_P; ++rowIdx) {
+                    m_PsiColumns[colIdx][rowIdx] = pseudoRandomMat(rowIdx, colIdx) & 1;
+                }
+            }
+
+            Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> hashMatrix(c_Beta, c_Q);
+            PreparePseudoRandomMatrix(hashMatrix, t_DataEmbeddingKey);
+
+            for (uint32_t rowIdx = 0; rowIdx < c_Beta; ++rowIdx) {
+                for (uint32_t colIdx = 0; colIdx < c_Q; ++colIdx) {
+                    if (colIdx < c_P) {
+                        m_HashRowsHead[rowIdx][colIdx] = hashMatrix(rowIdx, colIdx) & 1;
+                    }
+                    else if (hashMatrix(rowIdx, colIdx) & 1) {
+                        m_HashRowsTail[rowIdx] |= 1ULL << (colIdx - c_P);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Appends bit to the current group.
+         * @return true, if the group is full and should be compressed.
+        */
+        bool Append(uint8_t t_Bit)
+        {
+            if (m_GroupSize < c_P) {
+                m_Head[m_GroupSize] = t_Bit;
+            }
+            else {
+                m_Tail |= static_cast<uint64_t>(t_Bit) << (m_GroupSize - c_P);
+            }
+
+            return ++m_GroupSize == c_Q;
+        }
+
+        /**
+         * @brief Appends compressed group and its hash to the bitstreams, and starts a new group.
+        */
+        void Compress(std::string& t_LsbEncodedBitStream, std::string& t_HashsesBitStream)
+        {
+            /* \psi * G = G_{head} + Z * G_{tail}, where G_{tail} consists of the last \alpha bits. */
+            std::bitset<c_P> compressed = m_Head;
+            for (uint32_t colIdx = 0; colIdx < c_Alpha; ++colIdx) {
+                if ((m_Tail >> colIdx) & 1) {
+                    compressed ^= m_PsiColumns[colIdx];
+                }
+            }
+
+            for (uint32_t rowIdx = 0; rowIdx < c_P; ++rowIdx) {
+                t_LsbEncodedBitStream += compressed[rowIdx] ? '1' : '0';
+            }
+
+            for (uint32_t rowIdx = 0; rowIdx < c_Beta; ++rowIdx) {
+                const std::size_t ones = (m_HashRowsHead[rowIdx] & m_Head).count() + std::popcount(m_HashRowsTail[rowIdx] & m_Tail);
+                t_HashsesBitStream += (ones & 1) ? '1' : '0';
+            }
+
+            m_Head.reset();
+            m_Tail = 0;
+            m_GroupSize = 0;
+        }
+
+    private:
+        static constexpr uint32_t c_Q{ Params::c_GroupSizeBeforeCompression };
+        static constexpr uint32_t c_P{ Params::c_GroupSizeAfterCompression };
+        static constexpr uint32_t c_Alpha{ Params::c_Alpha };
+        static constexpr uint32_t c_Beta{ Params::c_LsbHashSize };
+
+        static_assert(c_Alpha <= 64, "Alpha is too big to keep the last group bits in a single word");
+
+        /* First P bits of the current group. */
+        std::bitset<c_P> m_Head;
+        /* Last \alpha bits of the current group. */
+        uint64_t m_Tail{ 0 };
+        uint32_t m_GroupSize{ 0 };
+
+        /* Columns of Z (pseudo-random part of \psi). */
+        std::array<std::bitset<c_P>, c_Alpha> m_PsiColumns;
+        /* Rows of the hash matrix, split the same way, as the group. */
+        std::array<std::bitset<c_P>, c_Beta> m_HashRowsHead;
+        std::array<uint64_t, c_Beta> m_HashRowsTail{};
+    };
+
+    template <>
+    class Embedder::GroupCompressor<DynamicEmbeddingParams> {
+    public:
+        GroupCompressor(const Consts& t_Consts, const std::vector<uint8_t>& t_DataEmbeddingKey)
+            : m_DataEmbeddingKey{ t_DataEmbeddingKey }, 
+            m_Group{ Group::Zero(t_Consts.GetGroupSizeBeforeCompression(), 1) },
+            m_Psi(t_Consts.GetGroupSizeAfterCompression(), t_Consts.GetGroupSizeBeforeCompression())
+        {
+            assert(m_Group.rows() == t_Consts.GetGroupSizeBeforeCompression());
+            assert(m_Group.cols() == 1);
+            assert(m_Group.isZero(0));
+
+            /* In the article it's referred as Z. Size of this matrix is P \times \alpha. */
+            Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> pseudoRandomMat(t_Consts.GetGroupSizeAfterCompression(), t_Consts.GetAlpha());
+            PreparePseudoRandomMatrix(pseudoRandomMat, t_DataEmbeddingKey);
+
+            /* Create binary matrix as described in the article */
+            m_Psi << Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>::Identity(t_Consts.GetGroupSizeAfterCompression(), t_Consts.GetGroupSizeAfterCompression()), pseudoRandomMat;
+        }
+
+        bool Append(uint8_t t_Bit)
+        {
+            m_Group(m_GroupSize++, 0) = t_Bit;
+
+            return m_GroupSize >= m_Group.rows();
+        }
+
+        void Compress(std::string& t_LsbEncodedBitStream, std::string& t_HashsesBitStream)
+        {
+            CompressCurrentGroup(m_Psi, m_Group, t_LsbEncodedBitStream, t_HashsesBitStream, m_DataEmbeddingKey, m_ReinitRandomMatrixForHashCalculation);
+            m_ReinitRandomMatrixForHashCalculation = false;
+
+            /* Reset group. */
+            m_Group.setZero();
+
+            /* Because Eigen is weird, lets just double check, if everything is done correctly. */
+            assert(m_Group.cols() == 1);
+            assert(m_Group.isZero(0));
+
+            /* Reset group size. */
+            m_GroupSize = 0;
+        }
+
+    private:
+        const std::vector<uint8_t>& m_DataEmbeddingKey;
+
+        /* Current group. In the article Group is referred as G_i. */
+        Group m_Group;
+        /* Used to keep track of current group size. */
+        uint32_t m_GroupSize{ 0 };
+
+        /* In the article it's referred as \psi. */
+        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> m_Psi;
+
+        /* This is here only to allow matrix reinitialization while running benchmarks. */
+        bool m_ReinitRandomMatrixForHashCalculation{ true };
+    };
+}
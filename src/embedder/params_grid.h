@@ -0,0 +1,18 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace rdh {
+    namespace consts {
+        namespace grid {
+            /**
+             * @brief Values of the embedding parameters, that are searched by the discover mode and swept by the benchmarks.
+            */
+            inline constexpr std::array<uint16_t, 12> c_Thresholds{ 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24 };
+            inline constexpr std::array<uint16_t, 3> c_Alphas{ 4, 5, 6 };
+            inline constexpr std::array<uint16_t, 7> c_Lambdas{ 60, 80, 100, 150, 200, 300, 400 };
+            inline constexpr std::array<uint16_t, 3> c_LsbLayers{ 1, 2, 3 };
+        }
+    }
+}
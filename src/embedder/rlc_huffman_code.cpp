@@ -0,0 +1,144 @@
+#include "embedder/rlc_huffman_code.h"
+
+#include <bit>
+#include <cassert>
+
+namespace rdh {
+    std::string RlcHuffmanCode::Serialize() const
+    {
+        std::string serialized;
+
+        uint32_t previousIdx{ 0 };
+        for (uint32_t symbolIdx = 0; symbolIdx < c_AlphabetSize; ++symbolIdx) {
+            if (m_Lengths[symbolIdx] == 0) {
+                continue;
+            }
+
+            if (m_Lengths[symbolIdx] > c_MaxSerializedCodeLength) {
+                throw std::invalid_argument("Huffman code length is too big to be serialized!");
+            }
+
+            /* Gap is at least 1, the first gap is counted from -1. */
+            const uint32_t gap = symbolIdx + 1 - previousIdx;
+            const uint32_t gapWidth = std::bit_width(gap);
+            serialized.append(gapWidth - 1, '0');
+            for (int32_t bitPos = gapWidth - 1; bitPos >= 0; --bitPos) {
+                serialized += ((gap >> bitPos) & 1) ? '1' : '0';
+            }
+
+            for (int32_t bitPos = c_SerializedLengthSize - 1; bitPos >= 0; --bitPos) {
+                serialized += ((m_Lengths[symbolIdx] >> bitPos) & 1) ? '1' : '0';
+            }
+
+            previousIdx = symbolIdx + 1;
+        }
+
+        return serialized;
+    }
+
+    RlcHuffmanCode RlcHuffmanCode::Deserialize(const std::string& t_Serialized)
+    {
+        CodeLengths codeLengths{};
+
+        std::size_t bitPos{ 0 };
+        const auto readBits = [&](uint32_t t_BitsCount) {
+            if (t_Serialized.size() - bitPos < t_BitsCount) {
+                throw std::invalid_argument("Serialized Huffman code is truncated!");
+            }
+
+            uint32_t value{ 0 };
+            for (uint32_t bitIdx = 0; bitIdx < t_BitsCount; ++bitIdx) {
+                value = (value << 1) | ((t_Serialized[bitPos++] == '1') ? 1 : 0);
+            }
+            return value;
+        };
+
+        uint32_t previousIdx{ 0 };
+        while (bitPos < t_Serialized.size()) {
+            uint32_t gapWidth{ 1 };
+            while (readBits(1) == 0) {
+                if (++gapWidth > std::bit_width(c_AlphabetSize)) {
+                    throw std::invalid_argument("Serialized Huffman code is malformed!");
+                }
+            }
+
+            const uint32_t gap = (1U << (gapWidth - 1)) | readBits(gapWidth - 1);
+            const uint32_t symbolIdx = previousIdx + gap - 1;
+            if (symbolIdx >= c_AlphabetSize) {
+                throw std::invalid_argument("Serialized Huffman code is malformed!");
+            }
+
+            codeLengths[symbolIdx] = static_cast<uint8_t>(readBits(c_SerializedLengthSize));
+            if (codeLengths[symbolIdx] == 0) {
+                throw std::invalid_argument("Serialized Huffman code is malformed!");
+            }
+
+            previousIdx = symbolIdx + 1;
+        }
+
+        return RlcHuffmanCode(codeLengths);
+    }
+
+    bool RlcHuffmanCode::TryEncode(std::span<const Symbol> t_ToEncode, std::string& t_Encoded) const
+    {
+        for (const auto& symbol : t_ToEncode) {
+            assert((symbol != Symbol(0, 0)));
+            assert((symbol != Symbol(2, 0)));
+
+            if (symbol.first > c_MaxRunLength || symbol.second < -255 || symbol.second > 255) {
+                throw std::invalid_argument("RLC symbol is out of the Huffman code alphabet!");
+            }
+
+            const uint32_t symbolIdx = SymbolIndex(symbol);
+            if (m_Lengths[symbolIdx] == 0) {
+                return false;
+            }
+
+            for (int32_t bitPos = m_Lengths[symbolIdx] - 1; bitPos >= 0; --bitPos) {
+                t_Encoded += ((m_Codes[symbolIdx] >> bitPos) & 1) ? '1' : '0';
+            }
+        }
+
+        return true;
+    }
+
+    std::string RlcHuffmanCode::Encode(const std::vector<Symbol>& t_ToEncode) const
+    {
+        std::string encoded;
+        encoded.reserve(t_ToEncode.size() * 8);
+
+        if (!TryEncode(t_ToEncode, encoded)) {
+            throw std::invalid_argument("RLC symbol doesn't have a Huffman code!");
+        }
+
+        return encoded;
+    }
+
+    std::vector<RlcHuffmanCode::Symbol> RlcHuffmanCode::Decode(const std::string& t_ToDecode) const
+    {
+        std::vector<Symbol> decoded;
+
+        uint32_t code{ 0 };
+        uint32_t length{ 0 };
+        for (char bit : t_ToDecode) {
+            code = (code << 1) | ((bit == '1') ? 1 : 0);
+            length++;
+
+            /* Codes of this length are [m_FirstCode, m_FirstCode + m_LengthCount). Longer codes continue with larger prefixes. */
+            if (code - m_FirstCode[length] < m_LengthCount[length]) {
+                decoded.push_back(IndexSymbol(m_SortedSymbols[m_FirstIndex[length] + code - m_FirstCode[length]]));
+                code = 0;
+                length = 0;
+            }
+            else if (length == c_MaxCodeLength) {
+                throw std::invalid_argument("Error, while decoding Huffman-encoded sequence! Invalid code.");
+            }
+        }
+
+        if (length != 0) {
+            throw std::invalid_argument("Error, while decoding Huffman-encoded sequence! Sequence ends in the middle of a code.");
+        }
+
+        return decoded;
+    }
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace rdh {
+    /**
+     * @brief Canonical Huffman code for RLC symbols (run length, difference).
+     *
+     * Code lengths are calculated from symbols frequencies, and then codes are assigned in canonical order:
+     * by length, and by symbol index for equal lengths. Ties while building the tree are broken by symbol index
+     * too, so the code depends only on the frequencies. Everything is constexpr, so the default code
+     * (see consts::huffman::c_DefaultCode) is built at compile time.
+     */
+    class RlcHuffmanCode {
+    public:
+        using Symbol = std::pair<uint16_t, Color16s>;
+
+        /**
+         * @brief Run lengths are in range [0, c_MaxRunLength], differences are in range [-255, 255].
+        */
+        static constexpr uint32_t c_MaxRunLength{ 2 };
+        static constexpr uint32_t c_AlphabetSize{ (c_MaxRunLength + 1) * 511 };
+
+        /**
+         * @brief Codes are kept in a single word.
+        */
+        static constexpr uint32_t c_MaxCodeLength{ 32 };
+
+        /**
+         * @brief Serialized code lengths are stored using this number of bits, so serialized codes
+         * should be length-limited to c_MaxSerializedCodeLength (see LimitCodeLengths).
+        */
+        static constexpr uint32_t c_SerializedLengthSize{ 4 };
+        static constexpr uint32_t c_MaxSerializedCodeLength{ (1U << c_SerializedLengthSize) - 1 };
+
+        using Frequencies = std::array<uint32_t, c_AlphabetSize>;
+        using CodeLengths = std::array<uint8_t, c_AlphabetSize>;
+
+        constexpr RlcHuffmanCode() = default;
+
+        /**
+         * @brief Builds code from frequencies of the symbols. Symbols with zero frequency don't get a code.
+         * @param t_Frequencies frequency of each symbol (see SymbolIndex).
+        */
+        constexpr explicit RlcHuffmanCode(const Frequencies& t_Frequencies)
+            : RlcHuffmanCode(CalculateCodeLengths(t_Frequencies))
+        {}
+
+        /**
+         * @brief Builds canonical code from code lengths.
+         * @param t_CodeLengths code length of each symbol (see SymbolIndex), 0 for symbols without code.
+         * @throw std::invalid_argument if lengths don't describe a prefix code.
+        */
+        constexpr explicit RlcHuffmanCode(const CodeLengths& t_CodeLengths)
+            : m_Lengths{ t_CodeLengths }
+        {
+            for (uint32_t symbolIdx = 0; symbolIdx < c_AlphabetSize; ++symbolIdx) {
+                if (m_Lengths[symbolIdx] > c_MaxCodeLength) {
+                    throw std::invalid_argument("Huffman code length is too big!");
+                }
+                m_LengthCount[m_Lengths[symbolIdx]]++;
+            }
+            m_LengthCount[0] = 0;
+
+            /* Symbols sorted by code length, and by index for equal lengths. */
+            for (uint32_t length = 1; length <= c_MaxCodeLength; ++length) {
+                m_FirstIndex[length + 1] = m_FirstIndex[length] + m_LengthCount[length];
+            }
+
+            std::array<uint32_t, c_MaxCodeLength + 2> nextIndex{ m_FirstIndex };
+            for (uint32_t symbolIdx = 0; symbolIdx < c_AlphabetSize; ++symbolIdx) {
+                if (m_Lengths[symbolIdx] != 0) {
+                    m_SortedSymbols[nextIndex[m_Lengths[symbolIdx]]++] = static_cast<uint16_t>(symbolIdx);
+                }
+            }
+
+            /* Codes of the same length are consecutive numbers. */
+            uint64_t code{ 0 };
+            for (uint32_t length = 1; length <= c_MaxCodeLength; ++length) {
+                m_FirstCode[length] = static_cast<uint32_t>(code);
+                code += m_LengthCount[length];
+
+                if (code > (1ULL << length)) {
+                    throw std::invalid_argument("Huffman code lengths don't describe a prefix code!");
+                }
+
+                for (uint32_t sortedIdx = m_FirstIndex[length]; sortedIdx < m_FirstIndex[length + 1]; ++sortedIdx) {
+                    m_Codes[m_SortedSymbols[sortedIdx]] = m_FirstCode[length] + (sortedIdx - m_FirstIndex[length]);
+                }
+
+                code <<= 1;
+            }
+        }
+
+        /**
+         * @brief Index of the symbol inside of the frequencies and code lengths tables.
+        */
+        static constexpr uint32_t SymbolIndex(const Symbol& t_Symbol)
+        {
+            return static_cast<uint32_t>(t_Symbol.first) * 511 + static_cast<uint32_t>(t_Symbol.second + 255);
+        }
+
+        /**
+         * @brief Symbol with index t_SymbolIdx.
+        */
+        static constexpr Symbol IndexSymbol(uint32_t t_SymbolIdx)
+        {
+            return Symbol(static_cast<uint16_t>(t_SymbolIdx / 511), static_cast<Color16s>(static_cast<int32_t>(t_SymbolIdx % 511) - 255));
+        }
+
+        /**
+         * @brief Calculates Huffman code lengths. Nodes are merged using two sorted queues (leaves and
+         * already merged nodes), on equal weights leaves are taken first.
+         * @param t_Frequencies frequency of each symbol (see SymbolIndex).
+         * @return code length of each symbol (0 for symbols with zero frequency).
+        */
+        static constexpr CodeLengths CalculateCodeLengths(const Frequencies& t_Frequencies)
+        {
+            CodeLengths codeLengths{};
+
+            /* Symbols with non-zero frequency sorted by frequency, and by index for equal frequencies. */
+            std::array<uint16_t, c_AlphabetSize> leaves{};
+            uint32_t leavesCount{ 0 };
+            for (uint32_t symbolIdx = 0; symbolIdx < c_AlphabetSize; ++symbolIdx) {
+                if (t_Frequencies[symbolIdx] != 0) {
+                    leaves[leavesCount++] = static_cast<uint16_t>(symbolIdx);
+                }
+            }
+
+            std::sort(leaves.begin(), leaves.begin() + leavesCount, [&t_Frequencies](uint16_t t_Left, uint16_t t_Right) {
+                return t_Frequencies[t_Left] < t_Frequencies[t_Right] || (t_Frequencies[t_Left] == t_Frequencies[t_Right] && t_Left < t_Right);
+            });
+
+            if (leavesCount == 0) {
+                return codeLengths;
+            }
+
+            if (leavesCount == 1) {
+                codeLengths[leaves[0]] = 1;
+                return codeLengths;
+            }
+
+            /**
+             * Node i < leavesCount is the i-th leaf, node leavesCount + j is the j-th merged node.
+             * Merged nodes are created in non-decreasing order of weights, so they form the second sorted queue.
+             */
+            std::array<uint64_t, c_AlphabetSize> mergedWeights{};
+            std::array<uint32_t, 2 * c_AlphabetSize> parents{};
+            uint32_t leafPos{ 0 };
+            uint32_t mergedPos{ 0 };
+
+            auto popLightest = [&](uint32_t t_MergedCount) -> std::pair<uint32_t, uint64_t> {
+                if (leafPos < leavesCount && (mergedPos >= t_MergedCount || t_Frequencies[leaves[leafPos]] <= mergedWeights[mergedPos])) {
+                    const uint32_t node = leafPos++;
+                    return { node, t_Frequencies[leaves[node]] };
+                }
+
+                const uint32_t node = leavesCount + mergedPos;
+                return { node, mergedWeights[mergedPos++] };
+            };
+
+            for (uint32_t mergedCount = 0; mergedCount < leavesCount - 1; ++mergedCount) {
+                const auto [leftNode, leftWeight] = popLightest(mergedCount);
+                const auto [rightNode, rightWeight] = popLightest(mergedCount);
+
+                mergedWeights[mergedCount] = leftWeight + rightWeight;
+                parents[leftNode] = leavesCount + mergedCount;
+                parents[rightNode] = leavesCount + mergedCount;
+            }
+
+            /* The last merged node is the root. Parents are always created after their children. */
+            std::array<uint8_t, c_AlphabetSize> mergedDepths{};
+            for (int32_t mergedIdx = static_cast<int32_t>(leavesCount) - 3; mergedIdx >= 0; --mergedIdx) {
+                mergedDepths[mergedIdx] = mergedDepths[parents[leavesCount + mergedIdx] - leavesCount] + 1;
+            }
+
+            for (uint32_t leafIdx = 0; leafIdx < leavesCount; ++leafIdx) {
+                codeLengths[leaves[leafIdx]] = mergedDepths[parents[leafIdx] - leavesCount] + 1;
+            }
+
+            return codeLengths;
+        }
+
+        /**
+         * @brief Limits code lengths to t_MaxLength. Codes, that are too long, are moved up the tree, and
+         * the shortest of the remaining codes are moved down to keep the code complete (JPEG, Annex K.3).
+         * After that lengths are reassigned to symbols in the original order (shorter codes first).
+         * @param t_CodeLengths code lengths of a complete code (see CalculateCodeLengths).
+         * @param t_MaxLength maximum code length.
+         * @return length-limited code lengths.
+         * @throw std::invalid_argument if there are more than 2^t_MaxLength symbols.
+        */
+        static constexpr CodeLengths LimitCodeLengths(const CodeLengths& t_CodeLengths, uint32_t t_MaxLength)
+        {
+            std::array<uint32_t, 256> lengthCount{};
+            std::array<uint16_t, c_AlphabetSize> symbols{};
+            uint32_t symbolsCount{ 0 };
+            uint32_t maxLength{ 0 };
+
+            for (uint32_t symbolIdx = 0; symbolIdx < c_AlphabetSize; ++symbolIdx) {
+                if (t_CodeLengths[symbolIdx] != 0) {
+                    lengthCount[t_CodeLengths[symbolIdx]]++;
+                    symbols[symbolsCount++] = static_cast<uint16_t>(symbolIdx);
+                    maxLength = std::max<uint32_t>(maxLength, t_CodeLengths[symbolIdx]);
+                }
+            }
+
+            if (t_MaxLength == 0 || t_MaxLength >= 32 || symbolsCount > (1U << t_MaxLength)) {
+                throw std::invalid_argument("Code lengths can't be limited to the requested length!");
+            }
+
+            for (uint32_t length = maxLength; length > t_MaxLength; --length) {
+                while (lengthCount[length] > 0) {
+                    /* Two sibling leaves at this length: one replaces their parent, another one becomes a sibling of the shorter leaf. */
+                    uint32_t shorterLength = length - 2;
+                    while (shorterLength > 0 && lengthCount[shorterLength] == 0) {
+                        shorterLength--;
+                    }
+
+                    if (shorterLength == 0) {
+                        throw std::invalid_argument("Code lengths don't describe a complete prefix code!");
+                    }
+
+                    lengthCount[length] -= 2;
+                    lengthCount[length - 1] += 1;
+                    lengthCount[shorterLength + 1] += 2;
+                    lengthCount[shorterLength] -= 1;
+                }
+            }
+
+            std::sort(symbols.begin(), symbols.begin() + symbolsCount, [&t_CodeLengths](uint16_t t_Left, uint16_t t_Right) {
+                return t_CodeLengths[t_Left] < t_CodeLengths[t_Right] || (t_CodeLengths[t_Left] == t_CodeLengths[t_Right] && t_Left < t_Right);
+            });
+
+            CodeLengths limitedLengths{};
+            uint32_t length{ 1 };
+            for (uint32_t sortedIdx = 0; sortedIdx < symbolsCount; ++sortedIdx) {
+                while (lengthCount[length] == 0) {
+                    length++;
+                }
+                limitedLengths[symbols[sortedIdx]] = static_cast<uint8_t>(length);
+                lengthCount[length]--;
+            }
+
+            return limitedLengths;
+        }
+
+        /**
+         * @brief Serializes code lengths: for each symbol with a code, the gap from the previous such symbol
+         * (Elias gamma code), followed by its code length (c_SerializedLengthSize bits).
+         * @return "bit" string with the serialized code.
+         * @throw std::invalid_argument if some code is longer than c_MaxSerializedCodeLength.
+        */
+        std::string Serialize() const;
+
+        /**
+         * @brief Restores code, serialized using Serialize.
+         * @param t_Serialized "bit" string with the serialized code.
+         * @return restored code.
+         * @throw std::invalid_argument if t_Serialized is malformed.
+        */
+        static RlcHuffmanCode Deserialize(const std::string& t_Serialized);
+
+        /**
+         * @brief Encodes RLC symbols, if all of them have a code.
+         * @param t_ToEncode symbols to encode.
+         * @param t_Encoded where to append encoded "bit" string.
+         * @return false, if one of the symbols doesn't have a code (t_Encoded is left partially appended).
+        */
+        bool TryEncode(std::span<const Symbol> t_ToEncode, std::string& t_Encoded) const;
+
+        /**
+         * @brief Encodes RLC symbols.
+         * @param t_ToEncode symbols to encode.
+         * @return Encoded "bit" string.
+         * @throw std::invalid_argument if one of the symbols doesn't have a code.
+        */
+        std::string Encode(const std::vector<Symbol>& t_ToEncode) const;
+
+        /**
+         * @brief Decodes "bit" string into RLC symbols.
+         * @param t_ToDecode Huffman-encoded "bit" string.
+         * @return decoded symbols.
+         * @throw std::invalid_argument if the string ends in the middle of a code.
+        */
+        std::vector<Symbol> Decode(const std::string& t_ToDecode) const;
+
+        constexpr uint8_t GetCodeLength(const Symbol& t_Symbol) const { return m_Lengths[SymbolIndex(t_Symbol)]; }
+        constexpr uint32_t GetCode(const Symbol& t_Symbol) const { return m_Codes[SymbolIndex(t_Symbol)]; }
+        constexpr const CodeLengths& GetCodeLengths() const { return m_Lengths; }
+
+    private:
+        /**
+         * @brief Code of each symbol (its m_Lengths[i] least significant bits, MSB first).
+        */
+        std::array<uint32_t, c_AlphabetSize> m_Codes{};
+
+        /**
+         * @brief Code length of each symbol (0 if symbol doesn't have a code).
+        */
+        CodeLengths m_Lengths{};
+
+        /**
+         * @brief Decoding tables: number of codes of each length, the first code of each length,
+         * and its index in m_SortedSymbols.
+        */
+        std::array<uint32_t, c_MaxCodeLength + 2> m_LengthCount{};
+        std::array<uint32_t, c_MaxCodeLength + 2> m_FirstCode{};
+        std::array<uint32_t, c_MaxCodeLength + 2> m_FirstIndex{};
+
+        /**
+         * @brief Symbols sorted in canonical order.
+        */
+        std::array<uint16_t, c_AlphabetSize> m_SortedSymbols{};
+    };
+}
@@ -0,0 +1,209 @@
+#include "extractor/candidate_search.h"
+
+#include <bit>
+#include <stdexcept>
+
+#include "embedder/compressor.h"
+#include "utils.h"
+
+namespace rdh {
+    CandidateSearch::CandidateSearch(const BinaryMatrix& t_Psi, const BinaryMatrix& t_HashMatrix, uint16_t t_LsbLayers, uint16_t t_Threshold)
+        : m_GroupSize{ static_cast<uint32_t>(t_Psi.cols()) }, m_BitsPerBlock{ 4 * static_cast<uint32_t>(t_LsbLayers) - 1 },
+        m_LsbLayers{ t_LsbLayers }, m_Threshold{ t_Threshold }
+    {
+        if (t_HashMatrix.rows() > 64) {
+            throw std::invalid_argument("Hash size can't be bigger than 64 bits!");
+        }
+
+        if (t_Psi.rows() >= 32) {
+            throw std::invalid_argument("Alpha is too big to iterate over all group candidates!");
+        }
+
+        assert(t_HashMatrix.cols() == t_Psi.cols());
+        assert(m_GroupSize % m_BitsPerBlock == 0);
+
+        m_BlocksInGroup = m_GroupSize / m_BitsPerBlock;
+
+        for (uint32_t rowIdx = 0; rowIdx < t_HashMatrix.rows(); ++rowIdx) {
+            m_HashRows.emplace_back(PackRow(t_HashMatrix.row(rowIdx)));
+        }
+
+        /**
+         * Candidate index is converted to the row vector starting from its most significant bit,
+         * so the i-th bit of the index selects (\alpha - 1 - i)-th row of psi.
+         */
+        for (int32_t rowIdx = static_cast<int32_t>(t_Psi.rows()) - 1; rowIdx >= 0; --rowIdx) {
+            PackedBits packedRow = PackRow(t_Psi.row(rowIdx));
+            PackedBits changedBlocks((m_BlocksInGroup + 63) / 64, 0);
+
+            for (uint32_t bitPos = 0; bitPos < m_GroupSize; ++bitPos) {
+                if ((packedRow[bitPos / 64] >> (bitPos % 64)) & 1) {
+                    const uint32_t blockIdx = bitPos / m_BitsPerBlock;
+                    changedBlocks[blockIdx / 64] |= 1ULL << (blockIdx % 64);
+                }
+            }
+
+            m_PsiRowsSyndromes.push_back(Syndrome(packedRow));
+            m_PsiRows.emplace_back(std::move(packedRow));
+            m_PsiRowsBlocks.emplace_back(std::move(changedBlocks));
+        }
+    }
+
+    bool CandidateSearch::Recover(
+        const std::string& t_CompressedGroup,
+        const std::string& t_GroupHash,
+        std::span<PackedBlock> t_EncryptedBlocks,
+        const RlcHuffmanCode& t_HuffmanCoder,
+        Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>& t_RestoredGroup
+    )
+    {
+        const uint32_t alpha = static_cast<uint32_t>(m_PsiRows.size());
+
+        if (t_CompressedGroup.size() + alpha != m_GroupSize || t_GroupHash.size() != m_HashRows.size()) {
+            throw std::invalid_argument("Error, while recovering LSB-compressed group! Group or hash has incorrect size.");
+        }
+
+        if (t_EncryptedBlocks.size() != m_BlocksInGroup) {
+            throw std::invalid_argument("Error, while recovering LSB-compressed group! Incorrect number of blocks in the group.");
+        }
+
+        /* The first candidate is the compressed group followed by \alpha zeroes. */
+        PackedBits candidate((m_GroupSize + 63) / 64, 0);
+        for (uint32_t bitPos = 0; bitPos < t_CompressedGroup.size(); ++bitPos) {
+            if (t_CompressedGroup[bitPos] == '1') {
+                candidate[bitPos / 64] |= 1ULL << (bitPos % 64);
+            }
+        }
+
+        uint64_t groupHash{ 0 };
+        for (uint32_t bitPos = 0; bitPos < t_GroupHash.size(); ++bitPos) {
+            if (t_GroupHash[bitPos] == '1') {
+                groupHash |= 1ULL << bitPos;
+            }
+        }
+
+        uint64_t candidateHash = Syndrome(candidate);
+
+        /* Blocks, whose compressibility should be recalculated. Initially - all of them. */
+        PackedBits dirtyBlocks((m_BlocksInGroup + 63) / 64, ~0ULL);
+        if (m_BlocksInGroup % 64 != 0) {
+            dirtyBlocks.back() = (1ULL << (m_BlocksInGroup % 64)) - 1;
+        }
+
+        /* Blocks of the current candidate, that can be compressed using RLC-based algorithm. */
+        std::vector<uint8_t> compressibleBlocks(m_BlocksInGroup, 0);
+        uint32_t compressibleBlocksCount{ 0 };
+        std::string compressed;
+        compressed.reserve(RlcHuffmanCode::c_MaxCodeLength * 3);
+
+        bool found{ false };
+        uint32_t foundIndex{ 0 };
+        PackedBits foundCandidate;
+
+        uint32_t candidateIndex{ 0 };
+        for (uint64_t step = 0; step < (1ULL << alpha); ++step) {
+            /* Move to the next candidate in Gray-code order: exactly one index bit changes. */
+            if (step != 0) {
+                const uint32_t changedBit = std::countr_zero(step);
+                candidateIndex ^= 1U << changedBit;
+
+                for (uint32_t wordIdx = 0; wordIdx < candidate.size(); ++wordIdx) {
+                    candidate[wordIdx] ^= m_PsiRows[changedBit][wordIdx];
+                }
+                for (uint32_t wordIdx = 0; wordIdx < dirtyBlocks.size(); ++wordIdx) {
+                    dirtyBlocks[wordIdx] |= m_PsiRowsBlocks[changedBit][wordIdx];
+                }
+                candidateHash ^= m_PsiRowsSyndromes[changedBit];
+            }
+
+            /* Cheap check first. */
+            if (candidateHash != groupHash) {
+                continue;
+            }
+
+            /* Exhaustive search picks the first matching candidate, so only smaller indices are interesting. */
+            if (found && candidateIndex > foundIndex) {
+                continue;
+            }
+
+            /* Recalculate compressibility of the changed blocks. */
+            for (uint32_t wordIdx = 0; wordIdx < dirtyBlocks.size(); ++wordIdx) {
+                while (dirtyBlocks[wordIdx] != 0) {
+                    const uint32_t blockIdx = wordIdx * 64 + std::countr_zero(dirtyBlocks[wordIdx]);
+                    dirtyBlocks[wordIdx] &= dirtyBlocks[wordIdx] - 1;
+
+                    const uint8_t isCompressible = IsRlcCompressible(candidate, blockIdx, t_EncryptedBlocks[blockIdx], t_HuffmanCoder, compressed);
+                    compressibleBlocksCount = compressibleBlocksCount - compressibleBlocks[blockIdx] + isCompressible;
+                    compressibleBlocks[blockIdx] = isCompressible;
+                }
+            }
+
+            if (compressibleBlocksCount == 0) {
+                found = true;
+                foundIndex = candidateIndex;
+                foundCandidate = candidate;
+
+                /* Nothing can precede the first candidate. */
+                if (foundIndex == 0) {
+                    break;
+                }
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+
+        t_RestoredGroup.resize(1, m_GroupSize);
+        for (uint32_t bitPos = 0; bitPos < m_GroupSize; ++bitPos) {
+            t_RestoredGroup(0, bitPos) = (foundCandidate[bitPos / 64] >> (bitPos % 64)) & 1;
+        }
+
+        return true;
+    }
+
+    CandidateSearch::PackedBits CandidateSearch::PackRow(const Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>& t_Row)
+    {
+        PackedBits packed((t_Row.cols() + 63) / 64, 0);
+
+        for (uint32_t bitPos = 0; bitPos < t_Row.cols(); ++bitPos) {
+            if (t_Row(0, bitPos) & 1) {
+                packed[bitPos / 64] |= 1ULL << (bitPos % 64);
+            }
+        }
+
+        return packed;
+    }
+
+    uint64_t CandidateSearch::Syndrome(const PackedBits& t_Group) const
+    {
+        uint64_t syndrome{ 0 };
+
+        for (uint32_t rowIdx = 0; rowIdx < m_HashRows.size(); ++rowIdx) {
+            uint32_t ones{ 0 };
+            for (uint32_t wordIdx = 0; wordIdx < t_Group.size(); ++wordIdx) {
+                ones += std::popcount(m_HashRows[rowIdx][wordIdx] & t_Group[wordIdx]);
+            }
+            syndrome |= static_cast<uint64_t>(ones & 1) << rowIdx;
+        }
+
+        return syndrome;
+    }
+
+    bool CandidateSearch::IsRlcCompressible(const PackedBits& t_Candidate, uint32_t t_BlockIdx, PackedBlock& t_Block, const RlcHuffmanCode& t_HuffmanCoder, std::string& t_Compressed) const
+    {
+        uint32_t bitPos = t_BlockIdx * m_BitsPerBlock;
+
+        /* Arrange candidate bits back into the block. For the top-left pixel, we ignore it's first LSB. */
+        for (uint32_t pxIdx = 0; pxIdx < 4; ++pxIdx) {
+            for (uint32_t currLsbPos = (pxIdx == 0) ? 1 : 0; currLsbPos < m_LsbLayers; ++currLsbPos, ++bitPos) {
+                t_Block = utils::math::SetNthBitToX(t_Block, 8 * pxIdx + currLsbPos, (t_Candidate[bitPos / 64] >> (bitPos % 64)) & 1);
+            }
+        }
+
+        /* Blocks, whose symbols don't have a code, can't be compressed. */
+        return RlcCompressor::TryCompress(
+            GetBlockPixel(t_Block, 0), GetBlockPixel(t_Block, 1), GetBlockPixel(t_Block, 2), GetBlockPixel(t_Block, 3), t_HuffmanCoder, t_Compressed
+        ) && t_Compressed.size() < m_Threshold;
+    }
+}
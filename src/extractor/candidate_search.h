@@ -0,0 +1,142 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <span>
+
+#include "types.h"
+#include "embedder/rlc_huffman_code.h"
+
+#include "Eigen/Dense"
+
+namespace rdh {
+    /**
+     * @brief Recovers original LSBs of the LSB-compressed groups.
+     *
+     * Every group candidate is the compressed group with appended zeroes, XOR-ed with
+     * some linear combination of the psi rows. Candidates are visited in Gray-code order,
+     * so that the next candidate differs from the previous one by exactly one psi row.
+     * Hash of a candidate is linear too, so it is updated with a single XOR as well.
+     * RLC-compressed size is recalculated only for candidates with the correct hash,
+     * and only for the blocks, that were changed since the last recalculation.
+     */
+    class CandidateSearch {
+    public:
+        using BinaryMatrix = Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>;
+
+        /**
+         * @brief 2x2 pixels block packed into a single word. Byte i holds pixel i:
+         *     0   1
+         * 0 | 0 | 1 |
+         * 1 | 2 | 3 |
+         */
+        using PackedBlock = uint32_t;
+
+        /**
+         * @brief Packs 2x2 pixels block into a single word.
+        */
+        static constexpr PackedBlock PackBlock(Color8u t_Pixel1, Color8u t_Pixel2, Color8u t_Pixel3, Color8u t_Pixel4)
+        {
+            return static_cast<PackedBlock>(t_Pixel1) | (static_cast<PackedBlock>(t_Pixel2) << 8) |
+                (static_cast<PackedBlock>(t_Pixel3) << 16) | (static_cast<PackedBlock>(t_Pixel4) << 24);
+        }
+
+        /**
+         * @brief Returns pixel t_PxIdx of a packed block.
+        */
+        static constexpr Color8u GetBlockPixel(PackedBlock t_Block, uint32_t t_PxIdx)
+        {
+            return static_cast<Color8u>(t_Block >> (8 * t_PxIdx));
+        }
+
+        /**
+         * @brief Prepares packed psi and hash matrices for the search.
+         * @param t_Psi matrix of size \alpha \times Q, that is used to generate group candidates.
+         * @param t_HashMatrix pseudo-random matrix of size \beta \times Q, that is used to calculate group hash.
+         * @param t_LsbLayers number of lsb layers, that were used while embedding.
+         * @param t_Threshold threshold for blocks classification.
+        */
+        CandidateSearch(const BinaryMatrix& t_Psi, const BinaryMatrix& t_HashMatrix, uint16_t t_LsbLayers, uint16_t t_Threshold);
+
+        /**
+         * @brief Finds the group candidate with the smallest index (the same one, that
+         * exhaustive search in index order would pick), whose hash is equal to t_GroupHash
+         * and all of whose blocks can't be compressed using RLC-based algorithm.
+         * @param[in] t_CompressedGroup LSB-compressed group bitstream (P bits).
+         * @param[in] t_GroupHash hash of the original group (\beta bits).
+         * @param[in,out] t_EncryptedBlocks contiguous 2x2 blocks of the group. Their LSBs are overwritten during the search.
+         * @param[in] t_HuffmanCoder Huffman coder object to use.
+         * @param[out] t_RestoredGroup restored group (Q bits).
+         * @return true if the group was restored, false otherwise.
+        */
+        bool Recover(
+            const std::string& t_CompressedGroup,
+            const std::string& t_GroupHash,
+            std::span<PackedBlock> t_EncryptedBlocks,
+            const RlcHuffmanCode& t_HuffmanCoder,
+            Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>& t_RestoredGroup
+        );
+
+    private:
+        using PackedBits = std::vector<uint64_t>;
+
+        /**
+         * @brief Packs binary row vector into 64-bit words.
+         * @param t_Row binary row to pack.
+         * @return packed row.
+        */
+        static PackedBits PackRow(const Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>& t_Row);
+
+        /**
+         * @brief Calculates hash (syndrome) of a packed group. Bit i is a parity of the i-th hash matrix row times group.
+         * @param t_Group packed group.
+         * @return hash, packed into a single word.
+        */
+        uint64_t Syndrome(const PackedBits& t_Group) const;
+
+        /**
+         * @brief Writes candidate bits of the block t_BlockIdx into its pixels and checks its RLC-compressed size.
+         * t_Compressed is a scratch buffer, reused between the blocks to avoid allocations.
+         * @return true, if the block can be compressed using RLC-based algorithm (the candidate is not valid).
+        */
+        bool IsRlcCompressible(const PackedBits& t_Candidate, uint32_t t_BlockIdx, PackedBlock& t_Block, const RlcHuffmanCode& t_HuffmanCoder, std::string& t_Compressed) const;
+
+        /**
+         * @brief Packed psi rows. m_PsiRows[i] corresponds to the i-th bit of the candidate index.
+        */
+        std::vector<PackedBits> m_PsiRows;
+
+        /**
+         * @brief Precalculated hash of each m_PsiRows entry.
+        */
+        std::vector<uint64_t> m_PsiRowsSyndromes;
+
+        /**
+         * @brief For each m_PsiRows entry, bitset of the blocks, that are changed by it.
+        */
+        std::vector<PackedBits> m_PsiRowsBlocks;
+
+        /**
+         * @brief Packed hash matrix rows.
+        */
+        std::vector<PackedBits> m_HashRows;
+
+        /**
+         * @brief Number of bits in each group. In the article it's referred as Q.
+        */
+        uint32_t m_GroupSize;
+
+        /**
+         * @brief Number of bits, that each block contributes to a group.
+        */
+        uint32_t m_BitsPerBlock;
+
+        /**
+         * @brief Number of blocks in a group.
+        */
+        uint32_t m_BlocksInGroup;
+
+        uint16_t m_LsbLayers;
+        uint16_t m_Threshold;
+    };
+}
@@ -1,9 +1,20 @@
 #include "extractor/extractor.h"
 
-#include "embedder/huffman.h"
+#include "embedder/rlc_huffman_code.h"
 #include "embedder/compressor.h"
 #include "embedder/embedder.h"
+#include "extractor/candidate_search.h"
 #include "image/image_quality.h"
+#include "phase_scope.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
 
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>
 #include <boost/log/trivial.hpp>
@@ -15,240 +26,269 @@ namespace rdh {
         std::vector<uint8_t>& t_EncryptionKey
     ) 
     {
-        /* Get reference to a consts object. */
-        Consts& constsRef = Consts::Instance();
+        /* Number of 2x2 blocks rows */
+        const uint32_t blocksHeight = t_MarkedEncryptedImage.GetHeight() / 2;
 
-        uint32_t keyCursor = 0;
-        /** 
-         * First direct decryption pass. 
-         * Decrypts top-left pixel in RLC-compressed blocks.
-         * Decrypts all pixels in LSB-compressed blocks.
+        if (blocksHeight < 2 || t_MarkedEncryptedImage.GetWidth() / 2 < 2) {
+            throw std::invalid_argument("Error, while recovering image! Image should be at least 4x4 pixels.");
+        }
+
+        if (t_EncryptionKey.empty()) {
+            throw std::invalid_argument("Error, while recovering image! Encryption key is empty.");
+        }
+
+        /**
+         * Image is split into horizontal tiles, one per thread. Recovery is done in two steps:
+         * 1. Decrypt top-left pixels and recover down-right pixels of each tile (and of its halo rows).
+         *    Only reads the image, so tiles can safely read rows of their neighbours.
+         * 2. Interpolate top-right and down-left pixels of each tile and write the tile back into the image.
+         *    Each tile writes only its own rows.
+         * The result is the same as for the direct decryption passes, described in the article:
+         * decrypt, average down-right pixels, fix the borders, interpolate the rest.
          */
-        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
-            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
-                /* What type of block we are currently looking at? */
-                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
-                    /* RLC-compressed block, so decrypt only the first pixel */
-                    Color8u decPixelA = t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+        Consts& params = Consts::Instance();
+        const uint32_t tilesCount = std::clamp<uint32_t>(params.GetThreadsCount(), 1, blocksHeight);
+        const uint32_t tileHeight = (blocksHeight + tilesCount - 1) / tilesCount;
 
-                    /* Update pixel value, and set location map bit */
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, decPixelA | 1);
-                }
-                else {
-                    /* LSB-compressed block, so decrypt all pixels in current block */
-                    Color8u decPixelA = t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
-                    Color8u decPixelB = t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
-                    Color8u decPixelC = t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
-                    Color8u decPixelD = t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
-
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, decPixelA);
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, decPixelB);
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, decPixelC);
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, decPixelD);
-                
-                    /* reset location map pixel */
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, t_MarkedEncryptedImage.GetPixel(imgY, imgX) & ~1);
-                }
+        std::vector<RecoveryTile> tiles;
+        for (uint32_t blockY = 0; blockY < blocksHeight; blockY += tileHeight) {
+            tiles.push_back(RecoveryTile{ blockY, std::min(blockY + tileHeight, blocksHeight), {}, {} });
+        }
 
-                ++keyCursor;
+        const auto forEachTile = [&tiles, &params](const auto& t_Worker) {
+            if (tiles.size() == 1) {
+                t_Worker(tiles.front());
+                return;
+            }
+
+            /* Thread override of the caller isn't inherited by new threads. */
+            std::vector<std::thread> threadpool;
+            for (auto& tile : tiles) {
+                threadpool.emplace_back([&t_Worker, &tile, &params]() {
+                    Consts::ThreadOverride paramsOverride(params);
+                    t_Worker(tile);
+                });
+            }
+
+            for (auto& th : threadpool) {
+                th.join();
+            }
+        };
+
+        forEachTile([&](RecoveryTile& t_Tile) { DecryptTileCorners(t_MarkedEncryptedImage, t_EncryptionKey, t_Tile); });
+        forEachTile([&](RecoveryTile& t_Tile) { RecoverTile(t_MarkedEncryptedImage, t_EncryptionKey, t_Tile); });
+
+        /* Added so that the benchmarks module can use this function without writing any files */
+        if (t_RecoveredImagePath.size() != 0) {
+            t_MarkedEncryptedImage.Save(t_RecoveredImagePath);
+        }
+    }
+
+    BmpImage Extractor::RecoverPreview(
+        const BmpImage& t_MarkedEncryptedImage,
+        const std::string t_PreviewImagePath,
+        const std::vector<uint8_t>& t_EncryptionKey
+    )
+    {
+        if (t_EncryptionKey.empty()) {
+            throw std::invalid_argument("Error, while recovering image preview! Encryption key is empty.");
+        }
+
+        const uint32_t blocksHeight = t_MarkedEncryptedImage.GetHeight() / 2;
+        const uint32_t blocksWidth = t_MarkedEncryptedImage.GetWidth() / 2;
+
+        /* Preview dimensions can be odd, so construct it from the image matrix. */
+        BmpImage previewImage(ImageMatrix<Color8u>(blocksHeight, blocksWidth, 0));
+
+        uint32_t keyCursor = 0;
+        for (uint32_t blockY = 0; blockY < blocksHeight; ++blockY) {
+            for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                const Color8u encPixelA = t_MarkedEncryptedImage.GetPixel(2 * blockY, 2 * blockX);
+                const Color8u decPixelA = encPixelA ^ t_EncryptionKey[keyCursor];
+
+                /* Keep location map bit, as RecoverImage does */
+                previewImage.SetPixel(blockY, blockX, (decPixelA & ~1) | (encPixelA & 1));
+
+                if (++keyCursor == t_EncryptionKey.size()) {
+                    keyCursor = 0;
+                }
             }
         }
 
+        if (t_PreviewImagePath.size() != 0) {
+            previewImage.Save(t_PreviewImagePath);
+        }
+
+        return previewImage;
+    }
+
+    void Extractor::DecryptTileCorners(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, RecoveryTile& t_Tile)
+    {
+        PhaseScope phase("Recover.DecryptCorners");
+
+        const uint32_t blocksHeight = t_MarkedEncryptedImage.GetHeight() / 2;
+        const uint32_t blocksWidth = t_MarkedEncryptedImage.GetWidth() / 2;
+
+        /* Halo rows (clamped to the image) */
+        const uint32_t firstRow = (t_Tile.m_BlockYStart == 0) ? 0 : t_Tile.m_BlockYStart - 1;
+        const uint32_t lastTopLeftRow = std::min(t_Tile.m_BlockYEnd, blocksHeight - 1);
+
+        /* Row 0 of the tile buffers corresponds to the blocks row m_BlockYStart - 1. */
+        t_Tile.m_TopLeft.assign(static_cast<std::size_t>(t_Tile.m_BlockYEnd - t_Tile.m_BlockYStart + 2) * blocksWidth, 0);
+        t_Tile.m_DownRight.assign(static_cast<std::size_t>(t_Tile.m_BlockYEnd - t_Tile.m_BlockYStart + 1) * blocksWidth, 0);
+
         /**
-         * Second direct decryption pass.
-         * Decrypts down-right pixel in RLC-compressed blocks by averaging it's neighbors.
+         * Decrypt top-left pixels. Their LSB is the location map bit: 
+         * 1 - RLC-compressed block, 0 - LSB-compressed block.
          */
-        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
-            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
-                /* What type of block we are currently looking at? */
-                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
-                    /* RLC-compressed block, so decrypt down-right pixel */
-                    uint16_t avgPixelValue{ 0 };
-                    uint8_t avgOfNPixels{ 1 };
-
-                    /* This pixel exists always */
-                    avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+        for (uint32_t blockY = firstRow; blockY <= lastTopLeftRow; ++blockY) {
+            const std::vector<Color8u>& topRow = t_MarkedEncryptedImage.GetImageMatrix().GetRow(2 * blockY);
+            Color8u* topLeft = &t_Tile.m_TopLeft[static_cast<std::size_t>(blockY + 1 - t_Tile.m_BlockYStart) * blocksWidth];
+            uint32_t keyCursor = (static_cast<std::size_t>(blockY) * blocksWidth) % t_EncryptionKey.size();
+
+            for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                const Color8u encPixelA = topRow[2 * blockX];
+                const Color8u decPixelA = encPixelA ^ t_EncryptionKey[keyCursor];
+                topLeft[blockX] = (encPixelA & 1) ? (decPixelA | 1) : (decPixelA & ~1);
+
+                if (++keyCursor == t_EncryptionKey.size()) {
+                    keyCursor = 0;
+                }
+            }
+        }
 
-                    if (imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
-                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
+        /**
+         * Decrypt down-right pixels of LSB-compressed blocks.
+         * For RLC-compressed blocks, average top-left pixels of the current, right, down and down-right blocks.
+         */
+        for (uint32_t blockY = firstRow; blockY < t_Tile.m_BlockYEnd; ++blockY) {
+            const std::vector<Color8u>& bottomRow = t_MarkedEncryptedImage.GetImageMatrix().GetRow(2 * blockY + 1);
+            const Color8u* topLeft = &t_Tile.m_TopLeft[static_cast<std::size_t>(blockY + 1 - t_Tile.m_BlockYStart) * blocksWidth];
+            const Color8u* topLeftDown = (blockY + 1 < blocksHeight) ? topLeft + blocksWidth : nullptr;
+            Color8u* downRight = &t_Tile.m_DownRight[static_cast<std::size_t>(blockY + 1 - t_Tile.m_BlockYStart) * blocksWidth];
+            uint32_t keyCursor = (static_cast<std::size_t>(blockY) * blocksWidth) % t_EncryptionKey.size();
+
+            for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                if (topLeft[blockX] & 1) {
+                    uint16_t avgPixelValue = topLeft[blockX];
+                    uint16_t avgOfNPixels{ 1 };
+
+                    if (blockX + 1 < blocksWidth) {
+                        avgPixelValue += topLeft[blockX + 1];
                         avgOfNPixels++;
                     }
 
-                    if (imgY + 2 < t_MarkedEncryptedImage.GetHeight()) {
-                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
+                    if (topLeftDown != nullptr) {
+                        avgPixelValue += topLeftDown[blockX];
                         avgOfNPixels++;
-                    }
 
-                    if (imgY + 2 < t_MarkedEncryptedImage.GetHeight() && imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
-                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX + 2);
-                        avgOfNPixels++;
+                        if (blockX + 1 < blocksWidth) {
+                            avgPixelValue += topLeftDown[blockX + 1];
+                            avgOfNPixels++;
+                        }
                     }
 
-                    /* Set new average pixel value */
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, avgPixelValue / (uint16_t)avgOfNPixels);
+                    downRight[blockX] = avgPixelValue / avgOfNPixels;
+                }
+                else {
+                    downRight[blockX] = bottomRow[2 * blockX + 1] ^ t_EncryptionKey[keyCursor];
+                }
+
+                if (++keyCursor == t_EncryptionKey.size()) {
+                    keyCursor = 0;
                 }
             }
         }
+    }
 
-        /**
-         * Third direct decryption pass.
-         * Decrypts pixels from RLC-compressed blocks, that are located borders of the image.
-         */
-        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
-            /* First or the last row */
-            if (imgY == 0 || imgY == t_MarkedEncryptedImage.GetHeight() - 2) {
-                for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
-                    /* What type of block we are currently looking at? */
-                    if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
-                        uint16_t avgPixelValue = 0;
-                        uint8_t avgOfNPixels{ 2 };
-
-                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-
-                        /* First row */
-                        if (imgY == 0) {
-                            if (imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
-                                avgOfNPixels++;
-                            }
+    void Extractor::RecoverTile(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, const RecoveryTile& t_Tile)
+    {
+        PhaseScope phase("Recover.Interpolate");
 
-                            /* Set new average pixel value */
-                            t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / avgOfNPixels);
-
-                            /**
-                             * If we are not in the top-left block, calculate average pixel value 
-                             * for the down-left pixel.
-                             */
-                            if (imgX != 0) {
-                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
-                                t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / 4);
-                            }
-                        }
-                        else {
-                            /* Last row */
-                            if (imgX >= 2) {
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
-                                avgOfNPixels++;
-                            }
+        const uint32_t blocksHeight = t_MarkedEncryptedImage.GetHeight() / 2;
+        const uint32_t blocksWidth = t_MarkedEncryptedImage.GetWidth() / 2;
 
-                            /* Set new average pixel value */
-                            t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / (uint16_t)avgOfNPixels);
-
-                            /**
-                             * If we are not in the down-right block, calculate average pixel value
-                             * for the down-right pixel.
-                             */
-                            if (imgX != t_MarkedEncryptedImage.GetWidth() - 2) {
-                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
-                                t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / 4);
-                            }
-                        }
-                    }
+        /* Recovered top-right and down-left pixels of the current blocks row */
+        std::vector<Color8u> topRight(blocksWidth);
+        std::vector<Color8u> downLeft(blocksWidth);
+
+        for (uint32_t blockY = t_Tile.m_BlockYStart; blockY < t_Tile.m_BlockYEnd; ++blockY) {
+            std::vector<Color8u>& topRow = t_MarkedEncryptedImage.GetImageMatrix().GetRow(2 * blockY);
+            std::vector<Color8u>& bottomRow = t_MarkedEncryptedImage.GetImageMatrix().GetRow(2 * blockY + 1);
+
+            /* Pixels of the current blocks row, and of the neighbouring rows (halo rows for the tile borders) */
+            const Color8u* a = &t_Tile.m_TopLeft[static_cast<std::size_t>(blockY + 1 - t_Tile.m_BlockYStart) * blocksWidth];
+            const Color8u* aDown = a + blocksWidth;
+            const Color8u* d = &t_Tile.m_DownRight[static_cast<std::size_t>(blockY + 1 - t_Tile.m_BlockYStart) * blocksWidth];
+            const Color8u* dUp = d - blocksWidth;
+
+            const bool isFirstRow = (blockY == 0);
+            const bool isLastRow = (blockY == blocksHeight - 1);
+
+            /**
+             * Decrypt top-right and down-left pixels of LSB-compressed blocks.
+             * For RLC-compressed blocks keep marked pixels as is: they are interpolated below,
+             * except for the down-left pixel of the top-left block and the top-right pixel of the down-right block.
+             */
+            uint32_t keyCursor = (static_cast<std::size_t>(blockY) * blocksWidth) % t_EncryptionKey.size();
+            for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                const Color8u keyByte = (a[blockX] & 1) ? 0 : t_EncryptionKey[keyCursor];
+                topRight[blockX] = topRow[2 * blockX + 1] ^ keyByte;
+                downLeft[blockX] = bottomRow[2 * blockX] ^ keyByte;
+
+                if (++keyCursor == t_EncryptionKey.size()) {
+                    keyCursor = 0;
                 }
             }
-            else {
-                /* First or the last column */
-                for (uint32_t imgX : std::array<uint32_t, 2>{ 0, t_MarkedEncryptedImage.GetWidth() - 2 }) {
-                    /* What type of block we are currently looking at? */
-                    if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
-                        uint16_t avgPixelValue = 0;
-                        uint8_t avgOfNPixels{ 0 };
-
-                        /* First column */
-                        if (imgX == 0) {
-                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                            avgOfNPixels += 2;
-
-                            if (imgY + 2 < t_MarkedEncryptedImage.GetHeight()) {
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
-                                avgOfNPixels++;
-                            }
 
-                            /* Set new average pixel value */
-                            t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / (uint16_t)avgOfNPixels);
-
-                            /**
-                             * If we are not in the top-left block, calculate average pixel value
-                             * for the top-right pixel.
-                             */
-                            if (imgY != 0) {
-                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
-                                t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / 4);
-                            }
-                        }
-                        else {
-                            /* Last column */
-                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                            avgOfNPixels += 2;
-
-                            if (imgY >= 2) {
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
-                                avgOfNPixels++;
-                            }
+            /* Top-right pixel: average of the top-left, down-right, right top-left and up down-right pixels. */
+            if (!isFirstRow) {
+                for (uint32_t blockX = 0; blockX < blocksWidth - 1; ++blockX) {
+                    const Color8u avgPixelValue = (dUp[blockX] + d[blockX] + a[blockX] + a[blockX + 1]) / 4;
+                    topRight[blockX] = (a[blockX] & 1) ? avgPixelValue : topRight[blockX];
+                }
+            }
 
-                            /* Set new average pixel value */
-                            t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / (uint16_t)avgOfNPixels);
-
-                            /**
-                             * If we are not in the down-right block, calculate average pixel value
-                             * for the down-left pixel.
-                             */
-                            if (imgY != t_MarkedEncryptedImage.GetHeight() - 2) {
-                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
-                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
-                                t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / 4);
-                            }
-                        }
+            /* Down-left pixel: average of the top-left, down-right, down top-left and left down-right pixels. */
+            if (!isLastRow) {
+                for (uint32_t blockX = 1; blockX < blocksWidth; ++blockX) {
+                    const Color8u avgPixelValue = (a[blockX] + aDown[blockX] + d[blockX - 1] + d[blockX]) / 4;
+                    downLeft[blockX] = (a[blockX] & 1) ? avgPixelValue : downLeft[blockX];
+                }
+            }
+
+            /* Image borders */
+            if (isFirstRow) {
+                for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                    if (a[blockX] & 1) {
+                        topRight[blockX] = (blockX + 1 < blocksWidth) ? (a[blockX] + d[blockX] + a[blockX + 1]) / 3 : (a[blockX] + d[blockX]) / 2;
                     }
                 }
             }
-        }
+            else if (!isLastRow && (a[blocksWidth - 1] & 1)) {
+                /* Last column */
+                topRight[blocksWidth - 1] = (a[blocksWidth - 1] + d[blocksWidth - 1] + dUp[blocksWidth - 1]) / 3;
+            }
 
-        /**
-         * Fourth direct decryption pass.
-         * Decrypts remaining pixels.
-         */
-        for (uint32_t imgY = 2; imgY < t_MarkedEncryptedImage.GetHeight() - 2; imgY += 2) {
-            for (uint32_t imgX = 2; imgX < t_MarkedEncryptedImage.GetWidth() - 2; imgX += 2) {
-                /* What type of block we are currently looking at? */
-                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
-                    uint16_t avgPixelValue = (
-                        t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1) +
-                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) +
-                        t_MarkedEncryptedImage.GetPixel(imgY, imgX) +
-                        t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2)
-                    ) / 4;
-
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue);
-
-                    avgPixelValue = (
-                        t_MarkedEncryptedImage.GetPixel(imgY, imgX) +
-                        t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX) +
-                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1) +
-                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
-                    ) / 4;
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue);
+            if (isLastRow) {
+                for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                    if (a[blockX] & 1) {
+                        downLeft[blockX] = (blockX >= 1) ? (a[blockX] + d[blockX] + d[blockX - 1]) / 3 : (a[blockX] + d[blockX]) / 2;
+                    }
                 }
             }
-        }
+            else if (!isFirstRow && (a[0] & 1)) {
+                /* First column */
+                downLeft[0] = (a[0] + d[0] + aDown[0]) / 3;
+            }
 
-        /* Added so that the benchmarks module can use this function without writing any files */
-        if (t_RecoveredImagePath.size() != 0) {
-            t_MarkedEncryptedImage.Save(t_RecoveredImagePath);
+            /* Write recovered blocks row */
+            for (uint32_t blockX = 0; blockX < blocksWidth; ++blockX) {
+                topRow[2 * blockX] = a[blockX];
+                topRow[2 * blockX + 1] = topRight[blockX];
+                bottomRow[2 * blockX] = downLeft[blockX];
+                bottomRow[2 * blockX + 1] = d[blockX];
+            }
         }
     }
 
@@ -260,11 +300,32 @@ namespace rdh {
     {
         std::string userDataBitStream;
         
-        ExtractBitStreams(t_MarkedEncryptedImage, t_DataEmbeddingKey, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, userDataBitStream, std::nullopt);
+        if (Consts::Instance().GetTileSize() != 0) {
+            const std::vector<Embedder::ContainerTile> tiles = Embedder::SplitIntoTiles(t_MarkedEncryptedImage, Consts::Instance().GetTileSize());
+            Consts tileParams = Embedder::TileParams(Consts::Instance());
+
+            /* Each tile holds its own framed chunk of user data. */
+            std::vector<std::string> tilesUserDataBitStreams(tiles.size());
+            Embedder::ForEachTile(tiles.size(), [&](uint32_t t_TileIdx) {
+                Consts::ThreadOverride paramsOverride(tileParams);
+                std::vector<uint8_t> tileKey = Embedder::DeriveTileKey(t_DataEmbeddingKey, t_TileIdx);
+
+                ExtractBitStreams(
+                    Embedder::CropTile(t_MarkedEncryptedImage, tiles[t_TileIdx]), tileKey,
+                    std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, tilesUserDataBitStreams[t_TileIdx], std::nullopt
+                );
+            });
+
+            if (t_ExtractedDataPath.size() != 0) {
+                SaveUserData(t_ExtractedDataPath, tilesUserDataBitStreams);
+            }
+        }
+        else {
+            ExtractBitStreams(t_MarkedEncryptedImage, t_DataEmbeddingKey, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, userDataBitStream, std::nullopt);
 
-        if (t_ExtractedDataPath.size() != 0) {
-            BOOST_LOG_TRIVIAL(info) << "Saving " << std::distance(userDataBitStream.begin(), userDataBitStream.end()) << " bits of embedded user-data";
-            utils::SaveBitstreamToFile<uint8_t>(t_ExtractedDataPath, userDataBitStream.begin(), userDataBitStream.end());
+            if (t_ExtractedDataPath.size() != 0) {
+                SaveUserData(t_ExtractedDataPath, { std::move(userDataBitStream) });
+            }
         }
     }
 
@@ -275,23 +336,94 @@ namespace rdh {
         std::vector<uint8_t>& t_DataEmbeddingKey,
         std::vector<uint8_t>& t_EncryptionKey
     ) 
+    {
+        std::string userDataBitStream;
+
+        if (Consts::Instance().GetTileSize() != 0) {
+            const std::vector<Embedder::ContainerTile> tiles = Embedder::SplitIntoTiles(t_MarkedEncryptedImage, Consts::Instance().GetTileSize());
+            Consts tileParams = Embedder::TileParams(Consts::Instance());
+
+            /* Each tile is recovered independently, only its own rows and columns are modified. */
+            std::vector<std::string> tilesUserDataBitStreams(tiles.size());
+            Embedder::ForEachTile(tiles.size(), [&](uint32_t t_TileIdx) {
+                Consts::ThreadOverride paramsOverride(tileParams);
+                std::vector<uint8_t> tileKey = Embedder::DeriveTileKey(t_DataEmbeddingKey, t_TileIdx);
+                std::vector<uint8_t> tileEncryptionKey = TileEncryptionKey(t_MarkedEncryptedImage, t_EncryptionKey, tiles[t_TileIdx]);
+
+                BmpImage tileImage = Embedder::CropTile(t_MarkedEncryptedImage, tiles[t_TileIdx]);
+                RecoverImageAndExtractBitStream(tileImage, tileKey, tileEncryptionKey, tilesUserDataBitStreams[t_TileIdx]);
+                Embedder::PasteTile(t_MarkedEncryptedImage, tileImage, tiles[t_TileIdx]);
+            });
+
+            if (t_ExtractedDataPath.size() != 0) {
+                SaveUserData(t_ExtractedDataPath, tilesUserDataBitStreams);
+            }
+        }
+        else {
+            RecoverImageAndExtractBitStream(t_MarkedEncryptedImage, t_DataEmbeddingKey, t_EncryptionKey, userDataBitStream);
+
+            if (t_ExtractedDataPath.size() != 0) {
+                SaveUserData(t_ExtractedDataPath, { std::move(userDataBitStream) });
+            }
+        }
+
+        /* Added so that the benchmarks module can use this function without writing any files */
+        if (t_RecoveredImagePath.size() != 0) {
+            t_MarkedEncryptedImage.Save(t_RecoveredImagePath);
+        }
+    }
+
+    void Extractor::SaveUserData(const std::string& t_ExtractedDataPath, const std::vector<std::string>& t_UserDataBitStreams)
+    {
+        std::size_t totalBits{ 0 };
+        for (const auto& userDataBitStream : t_UserDataBitStreams) {
+            totalBits += userDataBitStream.size();
+        }
+
+        BOOST_LOG_TRIVIAL(info) << "Saving " << totalBits << " bits of embedded user-data";
+
+        utils::PackedBitWriter writer(t_ExtractedDataPath);
+        for (const auto& userDataBitStream : t_UserDataBitStreams) {
+            writer.Write(userDataBitStream);
+        }
+        writer.Close();
+    }
+
+    std::vector<uint8_t> Extractor::TileEncryptionKey(const BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, const Embedder::ContainerTile& t_Tile)
+    {
+        /* Blocks of the whole image are encrypted with the key bytes in raster order. */
+        const std::size_t blocksWidth = t_MarkedEncryptedImage.GetWidth() / 2;
+
+        std::vector<uint8_t> tileEncryptionKey;
+        tileEncryptionKey.reserve(static_cast<std::size_t>(t_Tile.m_Height / 2) * (t_Tile.m_Width / 2));
+
+        for (uint32_t blockY = t_Tile.m_Y / 2; blockY < (t_Tile.m_Y + t_Tile.m_Height) / 2; ++blockY) {
+            for (uint32_t blockX = t_Tile.m_X / 2; blockX < (t_Tile.m_X + t_Tile.m_Width) / 2; ++blockX) {
+                tileEncryptionKey.push_back(t_EncryptionKey[(blockY * blocksWidth + blockX) % t_EncryptionKey.size()]);
+            }
+        }
+
+        return tileEncryptionKey;
+    }
+
+    void Extractor::RecoverImageAndExtractBitStream(
+        BmpImage& t_MarkedEncryptedImage,
+        std::vector<uint8_t>& t_DataEmbeddingKey,
+        std::vector<uint8_t>& t_EncryptionKey,
+        std::string& t_UserDataBitStream
+    )
     {
         /* Get reference to a consts object. */
         Consts& constsRef = Consts::Instance();
 
-        /* Total number of 2x2 pixels blocks. In the article it's referred as L. */
-        uint32_t totalBlocks{
-            static_cast<std::size_t>(t_MarkedEncryptedImage.GetHeight()) * static_cast<std::size_t>(t_MarkedEncryptedImage.GetWidth()) / 4
-        };
-
         /* Number of blocks encoded using RLC-based algorithm. In the article it's referred as R. */
         uint32_t omegaOneBlocks{ 0 };
 
-        /* Create Huffman-coder object, which will be used to encode RLC sequences */
-        Huffman<std::pair<uint16_t, Color16s>, pair_hash> huffmanCoder(consts::c_DefaultNode);
-
-        /* Set default frequencies (found using statistical approach) */
-        huffmanCoder.SetFrequencies(consts::huffman::c_DefaultFrequencies);
+        /**
+         * Default Huffman code for RLC sequences (built at compile time from frequencies, found using statistical approach).
+         * Replaced with the per-image code, if it's saved in the bitstream.
+         */
+        RlcHuffmanCode huffmanCoder{ consts::huffman::c_DefaultCode };
 
         /* RLC-compressed blocks lengths */
         std::vector<uint16_t> rlcCompressedBlocksLengths;
@@ -303,11 +435,9 @@ namespace rdh {
         std::vector<std::string> groupsHashes;
         /* Bitstream with LSBs */
         std::string lsbsBitStream;
-        /* User-data bitstream */
-        std::string userDataBitStream;
         /* Binary location map (because we will restore original LSB of the first pixel in each block). */
         std::vector<bool> binaryLocationMap;
-        ExtractBitStreams(t_MarkedEncryptedImage, t_DataEmbeddingKey, rlcCompressedBlocksLengths, rlcCompressedBitStream, lsbCompressedGroups, groupsHashes, lsbsBitStream, userDataBitStream, binaryLocationMap);
+        ExtractBitStreams(t_MarkedEncryptedImage, t_DataEmbeddingKey, huffmanCoder, rlcCompressedBlocksLengths, rlcCompressedBitStream, lsbCompressedGroups, groupsHashes, lsbsBitStream, t_UserDataBitStream, binaryLocationMap);
 
         /* Some sanity checks */
         assert(lsbsBitStream.size() == (t_MarkedEncryptedImage.GetHeight() * t_MarkedEncryptedImage.GetWidth()) / 4);
@@ -317,6 +447,10 @@ namespace rdh {
             throw std::invalid_argument("Error, while decompressing RLC-encoded blocks! The vector with RLC-compressed blocks lengths has zero size!");
         }
 
+        if (!IsHeaderConsistent(rlcCompressedBlocksLengths)) {
+            throw std::invalid_argument("Error, while parsing extracted bitstream! Data embedding key or embedding parameters are incorrect.");
+        }
+
         /* Iterator that keeps track of the current lsb */
         auto lsbsBitStreamIter = lsbsBitStream.begin();
         /* Iterator that keeps track of current rlc-compressed block size */
@@ -332,19 +466,18 @@ namespace rdh {
         /* Used to keep track of the current block index. */
         uint32_t currBlockIdx{ 0 };
 
-        /**
-         * Save all omega_2 blocks as groups.
-         * std::vector<Color8u> - 2x2 pixels block.
-         * std::vector<std::vector<Color8u>> - one group of a blocks.
-         * std::vector<std::vector<std::vector<Color8u>>> - all groups.
-         */ 
-        std::vector<std::vector<std::vector<Color8u>>> omegaTwoEncryptedBlocks{ std::vector<std::vector<Color8u>>() };
-        omegaTwoEncryptedBlocks.reserve(lsbCompressedGroups.size());
+        /* Total number of omega_2 blocks, that were used to form LSB-compressed groups. */
+        const std::size_t groupedBlocksCount = lsbCompressedGroups.size() * static_cast<std::size_t>(constsRef.GetLambda());
 
-        /* Used to keep track of totally collected groups */
-        uint32_t currentGroupNum{ 0 };
+        /**
+         * Save grouped omega_2 blocks contiguously: blocks of the i-th group
+         * are located at [i * lambda, (i + 1) * lambda).
+         */
+        std::vector<CandidateSearch::PackedBlock> omegaTwoEncryptedBlocks;
+        omegaTwoEncryptedBlocks.reserve(groupedBlocksCount);
 
         /* Iterate over all 2x2 px blocks */
+        PhaseScope decompressPhase("Recover.DecompressBlocks");
         for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
             for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
                 if (lsbsBitStreamIter >= lsbsBitStream.end()) {
@@ -390,35 +523,14 @@ namespace rdh {
                     omegaOneBlocks++;
                 }
                 else {
-                    /* Save current omega_2 block for later usage */
-                    /* Check that we haven't exceeded max allowed number of groups */
-                    if (currentGroupNum < lsbCompressedGroups.size()) {
-                        /* If the last group size is less than lambda add current block to the last group */
-                        if (omegaTwoEncryptedBlocks.back().size() < constsRef.GetLambda()) {
-                            omegaTwoEncryptedBlocks.back().emplace_back(
-                                std::vector<uint8_t>{
-                                    t_MarkedEncryptedImage.GetPixel(imgY, imgX),
-                                    t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1),
-                                    t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX),
-                                    t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
-                                }
-                            );
-                        }
-                        else {
-                            assert(omegaTwoEncryptedBlocks.back().size() == constsRef.GetLambda());
-
-                            currentGroupNum++;
-                            if (currentGroupNum != lsbCompressedGroups.size()) {
-                                omegaTwoEncryptedBlocks.emplace_back(std::vector<std::vector<uint8_t>>{
-                                    std::vector<uint8_t>{
-                                        t_MarkedEncryptedImage.GetPixel(imgY, imgX),
-                                        t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1),
-                                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX),
-                                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
-                                    }
-                                });
-                            }
-                        }
+                    /* Save current omega_2 block for later usage, if it belongs to one of the groups */
+                    if (omegaTwoEncryptedBlocks.size() < groupedBlocksCount) {
+                        omegaTwoEncryptedBlocks.push_back(CandidateSearch::PackBlock(
+                            t_MarkedEncryptedImage.GetPixel(imgY, imgX),
+                            t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1),
+                            t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX),
+                            t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
+                        ));
                     }
                 }
 
@@ -428,30 +540,20 @@ namespace rdh {
                 ++keyCursor;
             }
         }
+        decompressPhase.End();
 
-        assert(omegaTwoEncryptedBlocks.size() == lsbCompressedGroups.size());
+        assert(omegaTwoEncryptedBlocks.size() == groupedBlocksCount);
 
         /**
          * Next step. Recover lsbs of LSB-compressed blocks 
          */
-        /* Firstly, create psi matrix */
-        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> psi(constsRef.GetAlpha(), constsRef.GetGroupSizeBeforeCompression());
-
-        /* In the article it's referred as Z'. */
-        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> pseudoRandomMat(constsRef.GetGroupSizeAfterCompression(), constsRef.GetAlpha());
-        /* Get the original pseudo-random matrix, that is used to compress each group. */
-        Embedder::PreparePseudoRandomMatrix(pseudoRandomMat, t_DataEmbeddingKey);
-        /* Transpose this pseudo-random matrix */
-        pseudoRandomMat.transposeInPlace();
+        PhaseScope searchPhase("Recover.SearchGroups");
+        CandidateSearch candidateSearch = CreateCandidateSearch(t_DataEmbeddingKey);
 
-        /* Create binary matrix as described in the article */
-        psi << pseudoRandomMat, Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>::Identity(constsRef.GetAlpha(), constsRef.GetAlpha());
-
-        /* Boolean flag to reinit random matrix only once */
-        bool reinitRandomMatrix{ true };
-
-        /* Last processed omega_2 block */
-        std::pair<uint32_t, uint32_t> lastOmegaTwoBlockCoords{ 0, 0 };
+        /* Wrong key or parameters: fail fast, instead of running the full search for every group. */
+        if (!AreSampledGroupsRecoverable(lsbCompressedGroups, groupsHashes, omegaTwoEncryptedBlocks, candidateSearch, huffmanCoder, c_ProbeSampledGroups)) {
+            throw std::invalid_argument("Error, while recovering LSB-compressed groups! Data embedding key or embedding parameters are incorrect.");
+        }
 
         assert(lsbCompressedGroups.size() == groupsHashes.size());
 
@@ -460,78 +562,47 @@ namespace rdh {
 
         /* For each extracted LSB-compressed group recover it's LSBs */
         for (uint32_t currGroupIdx = 0; currGroupIdx < lsbCompressedGroups.size(); ++currGroupIdx) {
-            /* Group candidates */
-            std::vector<Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>> groupCandidates;
-            groupCandidates.reserve(std::powl(2, constsRef.GetAlpha()));
-
-            /* Generate all possible candidates and try each one. */
-            for (uint32_t currRowVector = 0; currRowVector < std::powl(2, constsRef.GetAlpha()); ++currRowVector) {
-                Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> firstPart(1, lsbCompressedGroups.at(currGroupIdx).size() + constsRef.GetAlpha());
-                firstPart << utils::ConvertBinaryStringToMatrix(lsbCompressedGroups.at(currGroupIdx)), Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>::Zero(1, constsRef.GetAlpha());
-
-                std::string rowVectorStr;
-                boost::to_string(boost::dynamic_bitset<>(constsRef.GetAlpha(), currRowVector), rowVectorStr);
-                Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> rowVector = utils::ConvertBinaryStringToMatrix(rowVectorStr);
-
-                /* Generated current group candidate */
-                Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> rowVectorTimesPsi = (rowVector * psi).unaryExpr([](const uint8_t x) { return x % 2; });
-                Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> currGroupCandidate = (firstPart + rowVectorTimesPsi).unaryExpr([](const uint8_t x) { return x % 2; });
-
-                /**
-                 * Arrange back current group candidate and recalculate RLC-compressed length for each block.
-                 * If any length < s_Threshold, discard current group candidate.
-                 */
-                uint32_t currGroupCandidateBitPos{ 0 };
-                for (std::vector<uint8_t>& encryptedBlock : omegaTwoEncryptedBlocks.at(currGroupIdx)) {
-                    for (uint32_t pxIdx = 0; pxIdx < encryptedBlock.size(); ++pxIdx) {
-                        //for (int32_t currLsbPos = constsRef.GetLsbLayers() - 1; currLsbPos >= (pxIdx == 0) ? 1 : 0; currLsbPos--) {
-                        for (uint32_t currLsbPos = (pxIdx == 0) ? 1 : 0; currLsbPos < constsRef.GetLsbLayers(); currLsbPos++) {
-                            assert(currGroupCandidateBitPos < currGroupCandidate.cols());
-
-                            uint8_t currBit = currGroupCandidate(0, currGroupCandidateBitPos++);
-                            encryptedBlock.at(pxIdx) = utils::math::SetNthBitToX(encryptedBlock.at(pxIdx), currLsbPos, currBit);
-                        }
-                    }
+            Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> restoredGroup;
 
-                    /* Check current block candidate compressed size */
-                    if (RlcCompressor::Compress(encryptedBlock.at(0), encryptedBlock.at(1), encryptedBlock.at(2), encryptedBlock.at(3), huffmanCoder).size() < constsRef.GetThreshold()) {
-                        goto discardGroup;
-                    }
-                }
-
-                assert(currGroupCandidateBitPos == currGroupCandidate.cols());
-
-                /* If the loop above has completed successfully, add group candidate to the vector of candidates */
-                groupCandidates.push_back(currGroupCandidate);
-discardGroup:;
-            }
             /**
-             * For each remaining group candidate calculate its hash, and pick the one
-             * whose hash is equal to the original group hash.
+             * Pick the first group candidate, whose blocks can't be compressed using RLC-based algorithm,
+             * and whose hash is equal to the original group hash.
              */
-            currBlockIdx = 0;
-            for (auto& groupCandidate : groupCandidates) {
-                std::string candidateHash = Embedder::HashLsbBlock(groupCandidate.transpose(), t_DataEmbeddingKey, reinitRandomMatrix);
-                if (reinitRandomMatrix) { reinitRandomMatrix = false; }
-
-                /* We've found correct group candidate */
-                if (candidateHash == groupsHashes.at(currGroupIdx)) {
-                    restoredGroups.emplace_back(std::move(groupCandidate));
-
-                    /* Ignore other possible candidates */
-                    break;
-                }
+            if (candidateSearch.Recover(lsbCompressedGroups.at(currGroupIdx), groupsHashes.at(currGroupIdx), 
+                std::span<CandidateSearch::PackedBlock>(omegaTwoEncryptedBlocks).subspan(currGroupIdx * static_cast<std::size_t>(constsRef.GetLambda()), constsRef.GetLambda()),
+                huffmanCoder, restoredGroup)) {
+                restoredGroups.emplace_back(std::move(restoredGroup));
             }
         }
 
         assert(restoredGroups.size() == lsbCompressedGroups.size());
+        searchPhase.End();
 
         /* Pack recovered groups into the image */
+        PhaseScope packPhase("Recover.PackGroups");
+        DispatchEmbeddingParams(constsRef, [&](auto t_Params) {
+            PackRestoredGroups<decltype(t_Params)>(t_MarkedEncryptedImage, binaryLocationMap, restoredGroups, t_EncryptionKey, keyCursor);
+        });
+    }
+
+    template <class Params>
+    void Extractor::PackRestoredGroups(
+        BmpImage& t_MarkedEncryptedImage,
+        const std::vector<bool>& t_BinaryLocationMap,
+        const std::vector<Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>>& t_RestoredGroups,
+        const std::vector<uint8_t>& t_EncryptionKey,
+        uint32_t t_KeyCursor
+    )
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
         uint32_t currGroupBitIter{ 0 };
         uint32_t currGroupIdx = 0;
+        uint32_t currBlockIdx = 0;
         for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
             for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
-                if (!binaryLocationMap.at(currBlockIdx)) {
+                if (!t_BinaryLocationMap.at(currBlockIdx)) {
                     /* Current block is lsb-encoded */
 
                     /* For each pixel in a group of 4 pixels restore original LSBs */
@@ -539,16 +610,16 @@ discardGroup:;
                         for (uint32_t xAdd = 0; xAdd < 2; ++xAdd) {
                             uint8_t curPixel{ t_MarkedEncryptedImage.GetPixel(imgY + yAdd, imgX + xAdd) };
                             /* For the top-left pixel, we ignore it's first LSB */
-                            for (uint32_t bitPos = (yAdd == 0 && xAdd == 0) ? 1 : 0; bitPos < constsRef.GetLsbLayers(); bitPos++) {
+                            for (uint32_t bitPos = (yAdd == 0 && xAdd == 0) ? 1 : 0; bitPos < Params::GetLsbLayers(constsRef); bitPos++) {
                                 /* we've restored all of the available groups */
-                                if (currGroupIdx >= restoredGroups.size()) {
+                                if (currGroupIdx >= t_RestoredGroups.size()) {
                                     continue;
                                 }
 
                                 t_MarkedEncryptedImage.SetPixel(imgY + yAdd, imgX + xAdd, 
-                                    utils::math::SetNthBitToX(curPixel, bitPos, restoredGroups.at(currGroupIdx)(0, currGroupBitIter++))
+                                    utils::math::SetNthBitToX(curPixel, bitPos, t_RestoredGroups.at(currGroupIdx)(0, currGroupBitIter++))
                                 );
-                                if (currGroupBitIter >= restoredGroups.at(currGroupIdx).cols()) {
+                                if (currGroupBitIter >= t_RestoredGroups.at(currGroupIdx).cols()) {
                                     currGroupIdx++;
                                     currGroupBitIter = 0;
                                 }
@@ -557,61 +628,47 @@ discardGroup:;
                     }
 
                     /* Decrypt each pixel in the current block to it's original value. */
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()]);
-                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()]);
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()]);
-                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()]);
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[t_KeyCursor % t_EncryptionKey.size()]);
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1) ^ t_EncryptionKey[t_KeyCursor % t_EncryptionKey.size()]);
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX) ^ t_EncryptionKey[t_KeyCursor % t_EncryptionKey.size()]);
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) ^ t_EncryptionKey[t_KeyCursor % t_EncryptionKey.size()]);
                 }
 
                 currBlockIdx++;
-                ++keyCursor;
+                ++t_KeyCursor;
             }
         }
-
-        if (t_ExtractedDataPath.size() != 0) {
-            BOOST_LOG_TRIVIAL(info) << "Saving " << std::distance(userDataBitStream.begin(), userDataBitStream.end()) << " bits of embedded user-data";
-            utils::SaveBitstreamToFile<uint8_t>(t_ExtractedDataPath, userDataBitStream.begin(), userDataBitStream.end());
-        }
-
-        /* Added so that the benchmarks module can use this function without writing any files */
-        if (t_RecoveredImagePath.size() != 0) {
-            t_MarkedEncryptedImage.Save(t_RecoveredImagePath);
-        }
     }
 
-    void Extractor::ExtractBitStreams(
-        const BmpImage& t_MarkedEncryptedImage,
-        std::vector<uint8_t>& t_DataEmbeddingKey,
-        std::optional<std::reference_wrapper<std::vector<uint16_t>>> t_RlcCompressedBlocksLengths,
-        std::optional<std::reference_wrapper<std::string>> t_RlcCompressedBitStream,
-        std::optional<std::reference_wrapper<std::vector<std::string>>> t_LsbCompressedGroups,
-        std::optional<std::reference_wrapper<std::vector<std::string>>> t_GroupHashesBitStream,
-        std::optional<std::reference_wrapper<std::string>> t_LsbsBitStream,
-        std::optional<std::reference_wrapper<std::string>> t_UserDataBitStream,
-        std::optional<std::reference_wrapper<std::vector<bool>>> t_BinaryLocationMap
-    )
+    Extractor::RawBitStream Extractor::ExtractRawBitStream(const BmpImage& t_MarkedEncryptedImage)
     {
+        PhaseScope phase("Extract.ReadBits");
+
         /* Get reference to a consts object. */
         Consts& constsRef = Consts::Instance();
 
+        RawBitStream rawBitStream;
+
         /**
          * Total number of 2x2 pixels blocks.
          * In the article it's referred as L.
          */
-        uint32_t totalBlocks{
+        rawBitStream.m_TotalBlocks = static_cast<uint32_t>(
             static_cast<std::size_t>(t_MarkedEncryptedImage.GetHeight()) * static_cast<std::size_t>(t_MarkedEncryptedImage.GetWidth()) / 4
-        };
+        );
+        rawBitStream.m_BinaryLocationMap.reserve(rawBitStream.m_TotalBlocks);
 
         /**
          * Number of blocks encoded using RLC-based algorithm.
          * In the article it's referred as R.
          */
-        uint32_t omegaOneBlocks{ 0 };
+        uint32_t& omegaOneBlocks = rawBitStream.m_OmegaOneBlocks;
+        omegaOneBlocks = 0;
 
         /* Extracted from image bitstream */
-        std::string extractedBitStream{ "" };
+        std::string& extractedBitStream = rawBitStream.m_BitStream;
         extractedBitStream.reserve(
-            static_cast<std::size_t>(24 * totalBlocks * constsRef.GetRlcEncodedBlocksRatioAvg())
+            static_cast<std::size_t>(24 * rawBitStream.m_TotalBlocks * constsRef.GetRlcEncodedBlocksRatioAvg())
         );
 
         /* Used to keep track of current lsb encoded group size (in bits) */
@@ -627,14 +684,12 @@ discardGroup:;
                 }
 
                 /* Update bit in binary-location map */
-                if (t_BinaryLocationMap) {
-                    (*t_BinaryLocationMap).get().push_back(t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1);
-                }
+                rawBitStream.m_BinaryLocationMap.push_back(t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1);
             }
         }
 
         /* Find value of xi, to calculate total number of bits used for data embedding. */
-        uint32_t xi = utils::math::Floor((float)(totalBlocks - omegaOneBlocks) / (float)constsRef.GetLambda());
+        uint32_t xi = utils::math::Floor((float)(rawBitStream.m_TotalBlocks - omegaOneBlocks) / (float)constsRef.GetLambda());
         uint32_t totalBitsFromLsbEncodedGroups = (xi * constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1));
 
         for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
@@ -675,6 +730,334 @@ discardGroup:;
             }
         }
 
+        return rawBitStream;
+    }
+
+    std::vector<std::string> Extractor::ExtractUserDataWithKeys(
+        const RawBitStream& t_RawBitStream,
+        const std::vector<std::vector<uint8_t>>& t_DataEmbeddingKeys
+    )
+    {
+        std::vector<std::string> userDataBitStreams(t_DataEmbeddingKeys.size());
+
+        /* Parameters of the caller, they are installed in each worker */
+        Consts& params = Consts::Instance();
+
+        /* Keys are distributed between workers dynamically, each key is deshuffled and parsed independently */
+        std::atomic<std::size_t> nextKeyIdx{ 0 };
+        const auto worker = [&]() {
+            Consts::ThreadOverride paramsOverride(params);
+
+            for (std::size_t keyIdx = nextKeyIdx++; keyIdx < t_DataEmbeddingKeys.size(); keyIdx = nextKeyIdx++) {
+                try {
+                    ParseBitStreams(t_RawBitStream, t_DataEmbeddingKeys[keyIdx], std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, userDataBitStreams[keyIdx]);
+                }
+                catch (const std::invalid_argument&) {
+                    /* Stream can't be parsed using this key */
+                    userDataBitStreams[keyIdx].clear();
+                }
+            }
+        };
+
+        const std::size_t threadsCount = std::clamp<std::size_t>(params.GetThreadsCount(), 1, std::max<std::size_t>(t_DataEmbeddingKeys.size(), 1));
+        if (threadsCount == 1) {
+            worker();
+        }
+        else {
+            std::vector<std::thread> threadpool;
+            for (std::size_t threadIdx = 0; threadIdx < threadsCount; ++threadIdx) {
+                threadpool.emplace_back(worker);
+            }
+
+            for (auto& th : threadpool) {
+                th.join();
+            }
+        }
+
+        return userDataBitStreams;
+    }
+
+    bool Extractor::ProbeEmbeddingKey(
+        const BmpImage& t_MarkedEncryptedImage,
+        const std::vector<uint8_t>& t_DataEmbeddingKey,
+        uint32_t t_SampledGroups
+    )
+    {
+        return ProbeRawBitStream(t_MarkedEncryptedImage, ExtractRawBitStream(t_MarkedEncryptedImage), t_DataEmbeddingKey, t_SampledGroups);
+    }
+
+    std::optional<Consts> Extractor::DiscoverParameters(
+        const BmpImage& t_MarkedEncryptedImage,
+        const std::vector<uint8_t>& t_DataEmbeddingKey,
+        const std::vector<Consts>& t_CandidateParams
+    )
+    {
+        /**
+         * Raw bitstream depends only on lambda and lsb layers, so it's shared between all of the parameter sets
+         * with the same pair. It's extracted, when the first of these sets is probed, and released after the last one,
+         * so only the streams of the sets, that are being probed, are kept (if the sets with the same pair go one after another).
+         */
+        struct SharedRawBitStream {
+            std::mutex m_Mutex;
+            std::shared_ptr<const RawBitStream> m_RawBitStream;
+            std::atomic<std::size_t> m_PendingParams{ 0 };
+        };
+
+        std::map<std::pair<uint16_t, uint16_t>, SharedRawBitStream> rawBitStreams;
+        for (const auto& candidateParams : t_CandidateParams) {
+            rawBitStreams[{ candidateParams.GetLambda(), candidateParams.GetLsbLayers() }].m_PendingParams++;
+        }
+
+        /* Workers see the same parameters as the caller */
+        Consts& params = Consts::Instance();
+
+        /**
+         * Probe parameter sets in order. Once some set matches, sets after it are skipped,
+         * so the first matching set in the list is reported.
+         */
+        std::atomic<std::size_t> nextParamsIdx{ 0 };
+        std::atomic<std::size_t> matchedParamsIdx{ t_CandidateParams.size() };
+        const auto worker = [&]() {
+            Consts::ThreadOverride paramsOverride(params);
+
+            for (std::size_t idx = nextParamsIdx++; idx < matchedParamsIdx.load(); idx = nextParamsIdx++) {
+                Consts consts = t_CandidateParams[idx];
+                Consts::ThreadOverride constsOverride(consts);
+
+                SharedRawBitStream& sharedRawBitStream = rawBitStreams.at({ consts.GetLambda(), consts.GetLsbLayers() });
+
+                bool isMatched{ false };
+                try {
+                    std::shared_ptr<const RawBitStream> rawBitStream;
+                    {
+                        std::lock_guard<std::mutex> lock(sharedRawBitStream.m_Mutex);
+                        if (!sharedRawBitStream.m_RawBitStream) {
+                            sharedRawBitStream.m_RawBitStream = std::make_shared<const RawBitStream>(ExtractRawBitStream(t_MarkedEncryptedImage));
+                        }
+                        rawBitStream = sharedRawBitStream.m_RawBitStream;
+                    }
+
+                    /**
+                     * Parameter sets with the same bitstream layout can't be told apart by a few groups (small groups
+                     * are recovered easily), so the sets, that pass the cheap probe, are confirmed using all of the groups.
+                     */
+                    isMatched = ProbeRawBitStream(t_MarkedEncryptedImage, *rawBitStream, t_DataEmbeddingKey, c_ProbeSampledGroups) &&
+                        ProbeRawBitStream(t_MarkedEncryptedImage, *rawBitStream, t_DataEmbeddingKey, std::numeric_limits<uint32_t>::max());
+                }
+                catch (const std::exception&) {
+                    /* Parameters are not even valid */
+                    isMatched = false;
+                }
+
+                /* No other set needs this stream */
+                if (--sharedRawBitStream.m_PendingParams == 0) {
+                    std::lock_guard<std::mutex> lock(sharedRawBitStream.m_Mutex);
+                    sharedRawBitStream.m_RawBitStream.reset();
+                }
+
+                if (isMatched) {
+                    std::size_t currentMatchedIdx = matchedParamsIdx.load();
+                    while (idx < currentMatchedIdx && !matchedParamsIdx.compare_exchange_weak(currentMatchedIdx, idx)) {}
+                }
+            }
+        };
+
+        const std::size_t threadsCount = std::clamp<std::size_t>(params.GetThreadsCount(), 1, std::max<std::size_t>(t_CandidateParams.size(), 1));
+        if (threadsCount == 1) {
+            worker();
+        }
+        else {
+            std::vector<std::thread> threadpool;
+            for (std::size_t threadIdx = 0; threadIdx < threadsCount; ++threadIdx) {
+                threadpool.emplace_back(worker);
+            }
+
+            for (auto& th : threadpool) {
+                th.join();
+            }
+        }
+
+        if (matchedParamsIdx.load() == t_CandidateParams.size()) {
+            return std::nullopt;
+        }
+
+        return t_CandidateParams[matchedParamsIdx.load()];
+    }
+
+    bool Extractor::ProbeRawBitStream(
+        const BmpImage& t_MarkedEncryptedImage,
+        const RawBitStream& t_RawBitStream,
+        const std::vector<uint8_t>& t_DataEmbeddingKey,
+        uint32_t t_SampledGroups
+    )
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
+        RlcHuffmanCode huffmanCoder{ consts::huffman::c_DefaultCode };
+        std::vector<uint16_t> rlcCompressedBlocksLengths;
+        std::string rlcCompressedBitStream;
+        std::vector<std::string> lsbCompressedGroups;
+        std::vector<std::string> groupsHashes;
+        std::string lsbsBitStream;
+
+        try {
+            ParseBitStreams(t_RawBitStream, t_DataEmbeddingKey, huffmanCoder, rlcCompressedBlocksLengths, rlcCompressedBitStream, lsbCompressedGroups, groupsHashes, lsbsBitStream, std::nullopt);
+        }
+        catch (const std::invalid_argument&) {
+            /* Bitstream is too short for the parsed header */
+            return false;
+        }
+
+        if (!IsHeaderConsistent(rlcCompressedBlocksLengths)) {
+            return false;
+        }
+
+        /* Collect omega_2 blocks, that belong to the groups */
+        const std::size_t groupedBlocksCount = lsbCompressedGroups.size() * static_cast<std::size_t>(constsRef.GetLambda());
+        std::vector<CandidateSearch::PackedBlock> omegaTwoEncryptedBlocks;
+        omegaTwoEncryptedBlocks.reserve(groupedBlocksCount);
+
+        uint32_t currBlockIdx{ 0 };
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight() && omegaTwoEncryptedBlocks.size() < groupedBlocksCount; imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth() && omegaTwoEncryptedBlocks.size() < groupedBlocksCount; imgX += 2, ++currBlockIdx) {
+                if (!t_RawBitStream.m_BinaryLocationMap[currBlockIdx]) {
+                    /* Top-left pixel with the original LSB restored */
+                    omegaTwoEncryptedBlocks.push_back(CandidateSearch::PackBlock(
+                        utils::ClearLastNBits(t_MarkedEncryptedImage.GetPixel(imgY, imgX), 1) | ((lsbsBitStream[currBlockIdx] == '1') ? 1 : 0),
+                        t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1),
+                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX),
+                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
+                    ));
+                }
+            }
+        }
+
+        CandidateSearch candidateSearch = CreateCandidateSearch(t_DataEmbeddingKey);
+
+        return AreSampledGroupsRecoverable(lsbCompressedGroups, groupsHashes, omegaTwoEncryptedBlocks, candidateSearch, huffmanCoder, t_SampledGroups);
+    }
+
+    CandidateSearch Extractor::CreateCandidateSearch(const std::vector<uint8_t>& t_DataEmbeddingKey)
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
+        /* Firstly, create psi matrix */
+        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> psi(constsRef.GetAlpha(), constsRef.GetGroupSizeBeforeCompression());
+
+        /* In the article it's referred as Z'. */
+        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> pseudoRandomMat(constsRef.GetGroupSizeAfterCompression(), constsRef.GetAlpha());
+        /* Get the original pseudo-random matrix, that is used to compress each group. */
+        Embedder::PreparePseudoRandomMatrix(pseudoRandomMat, t_DataEmbeddingKey);
+        /* Transpose this pseudo-random matrix */
+        pseudoRandomMat.transposeInPlace();
+
+        /* Create binary matrix as described in the article */
+        psi << pseudoRandomMat, Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic>::Identity(constsRef.GetAlpha(), constsRef.GetAlpha());
+
+        /* Pseudo-random matrix, that was used to calculate hash for each group. */
+        Eigen::Matrix<uint8_t, Eigen::Dynamic, Eigen::Dynamic> hashMatrix(constsRef.GetLsbHashSize(), constsRef.GetGroupSizeBeforeCompression());
+        Embedder::PreparePseudoRandomMatrix(hashMatrix, t_DataEmbeddingKey);
+
+        return CandidateSearch(psi, hashMatrix, constsRef.GetLsbLayers(), constsRef.GetThreshold());
+    }
+
+    bool Extractor::IsHeaderConsistent(const std::vector<uint16_t>& t_RlcCompressedBlocksLengths)
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
+        /**
+         * Block is RLC-compressed only if it's compressed size is less than the threshold.
+         * For a wrong key lengths are random, so this check fails almost immediately.
+         */
+        return std::all_of(t_RlcCompressedBlocksLengths.begin(), t_RlcCompressedBlocksLengths.end(), [&constsRef](uint16_t t_Length) {
+            return t_Length < constsRef.GetThreshold();
+        });
+    }
+
+    bool Extractor::AreSampledGroupsRecoverable(
+        const std::vector<std::string>& t_LsbCompressedGroups,
+        const std::vector<std::string>& t_GroupHashesBitStream,
+        std::span<CandidateSearch::PackedBlock> t_OmegaTwoEncryptedBlocks,
+        CandidateSearch& t_CandidateSearch,
+        const RlcHuffmanCode& t_HuffmanCoder,
+        uint32_t t_SampledGroups
+    )
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
+        const std::size_t groupsCount = t_LsbCompressedGroups.size();
+        const std::size_t sampledGroups = std::min<std::size_t>(t_SampledGroups, groupsCount);
+
+        /**
+         * With the correct key the original group is always a valid candidate,
+         * so every group can be recovered.
+         */
+        for (std::size_t sampleIdx = 0; sampleIdx < sampledGroups; ++sampleIdx) {
+            const std::size_t groupIdx = sampleIdx * groupsCount / sampledGroups;
+            Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> restoredGroup;
+
+            if (!t_CandidateSearch.Recover(t_LsbCompressedGroups.at(groupIdx), t_GroupHashesBitStream.at(groupIdx),
+                t_OmegaTwoEncryptedBlocks.subspan(groupIdx * constsRef.GetLambda(), constsRef.GetLambda()),
+                t_HuffmanCoder, restoredGroup)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void Extractor::ExtractBitStreams(
+        const BmpImage& t_MarkedEncryptedImage,
+        std::vector<uint8_t>& t_DataEmbeddingKey,
+        std::optional<std::reference_wrapper<RlcHuffmanCode>> t_HuffmanCoder,
+        std::optional<std::reference_wrapper<std::vector<uint16_t>>> t_RlcCompressedBlocksLengths,
+        std::optional<std::reference_wrapper<std::string>> t_RlcCompressedBitStream,
+        std::optional<std::reference_wrapper<std::vector<std::string>>> t_LsbCompressedGroups,
+        std::optional<std::reference_wrapper<std::vector<std::string>>> t_GroupHashesBitStream,
+        std::optional<std::reference_wrapper<std::string>> t_LsbsBitStream,
+        std::optional<std::reference_wrapper<std::string>> t_UserDataBitStream,
+        std::optional<std::reference_wrapper<std::vector<bool>>> t_BinaryLocationMap
+    )
+    {
+        const RawBitStream rawBitStream = ExtractRawBitStream(t_MarkedEncryptedImage);
+
+        if (t_BinaryLocationMap) {
+            (*t_BinaryLocationMap).get().insert((*t_BinaryLocationMap).get().end(), rawBitStream.m_BinaryLocationMap.begin(), rawBitStream.m_BinaryLocationMap.end());
+        }
+
+        ParseBitStreams(rawBitStream, t_DataEmbeddingKey, t_HuffmanCoder, t_RlcCompressedBlocksLengths, t_RlcCompressedBitStream, t_LsbCompressedGroups, t_GroupHashesBitStream, t_LsbsBitStream, t_UserDataBitStream);
+    }
+
+    void Extractor::ParseBitStreams(
+        const RawBitStream& t_RawBitStream,
+        const std::vector<uint8_t>& t_DataEmbeddingKey,
+        std::optional<std::reference_wrapper<RlcHuffmanCode>> t_HuffmanCoder,
+        std::optional<std::reference_wrapper<std::vector<uint16_t>>> t_RlcCompressedBlocksLengths,
+        std::optional<std::reference_wrapper<std::string>> t_RlcCompressedBitStream,
+        std::optional<std::reference_wrapper<std::vector<std::string>>> t_LsbCompressedGroups,
+        std::optional<std::reference_wrapper<std::vector<std::string>>> t_GroupHashesBitStream,
+        std::optional<std::reference_wrapper<std::string>> t_LsbsBitStream,
+        std::optional<std::reference_wrapper<std::string>> t_UserDataBitStream
+    )
+    {
+        /* Get reference to a consts object. */
+        Consts& constsRef = Consts::Instance();
+
+        /* Number of blocks encoded using RLC-based algorithm. In the article it's referred as R. */
+        const uint32_t omegaOneBlocks = t_RawBitStream.m_OmegaOneBlocks;
+        /* Total number of 2x2 pixels blocks. In the article it's referred as L. */
+        const uint32_t totalBlocks = t_RawBitStream.m_TotalBlocks;
+
+        /* Find value of xi, to calculate total number of lsb-compressed groups. */
+        uint32_t xi = utils::math::Floor((float)(totalBlocks - omegaOneBlocks) / (float)constsRef.GetLambda());
+
+        /* Each key gets its own copy of the shared raw bitstream */
+        std::string extractedBitStream = t_RawBitStream.m_BitStream;
+
         std::array<uint32_t, 5> hash;
 
         /* Use sha1 of a data-hiding key as a seed for PRNG */
@@ -682,11 +1065,13 @@ discardGroup:;
         std::seed_seq seq(hash.begin(), hash.end());
 
         /* Shuffle BitStream, before embedding */
+        PhaseScope deshufflePhase("Extract.Deshuffle");
         utils::DeshuffleFisherYates(seq, extractedBitStream);
+        deshufflePhase.End();
 
         /**
-         * Now, when we have this bitstream: {\Re || C || \Lambda || H || F || S }.
-         * Start a parsing operation.
+         * Now, when we have this bitstream: {\Re || C || \Lambda || H || F || S }
+         * (prepended with the per-image Huffman code, if it's enabled). Start a parsing operation.
          */
 
          /* Total size of C bitstream */
@@ -695,12 +1080,29 @@ discardGroup:;
         auto sliceBegin = extractedBitStream.begin();
         auto sliceEnd = extractedBitStream.begin();
 
+        /* Extract per-image Huffman code. Zero length means, that the default code was used. */
+        if (constsRef.IsHuffmanAdaptive()) {
+            const uint32_t huffmanTableSize = boost::dynamic_bitset<>(
+                std::string(
+                    sliceBegin,
+                    utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetHuffmanTableLengthSize(), true)
+                )
+            ).to_ulong();
+            utils::Advance(sliceBegin, extractedBitStream.end(), constsRef.GetHuffmanTableLengthSize());
+
+            utils::Advance(sliceEnd, extractedBitStream.end(), huffmanTableSize, true);
+            if (t_HuffmanCoder && huffmanTableSize != 0) {
+                (*t_HuffmanCoder).get() = RlcHuffmanCode::Deserialize(std::string(sliceBegin, sliceEnd));
+            }
+            utils::Advance(sliceBegin, extractedBitStream.end(), huffmanTableSize);
+        }
+
         /* Extract lengths information from rlcCompressedBitStream */
         for (uint32_t currentRlcCodedBlock = 0; currentRlcCodedBlock < omegaOneBlocks; currentRlcCodedBlock++) {
             uint16_t currRlcEncodedBlockSize = boost::dynamic_bitset<>(
                 std::string(
                     sliceBegin,
-                    utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetRlcEncodedMaxSize())
+                    utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetRlcEncodedMaxSize(), true)
                 )
             ).to_ulong();
             rlcCompressedBitStreamSize += currRlcEncodedBlockSize;
@@ -713,7 +1115,7 @@ discardGroup:;
         }
 
         /* Extract rlc-compressed bitstream */
-        utils::Advance(sliceEnd, extractedBitStream.end(), rlcCompressedBitStreamSize);
+        utils::Advance(sliceEnd, extractedBitStream.end(), rlcCompressedBitStreamSize, true);
         if (t_RlcCompressedBitStream) {
             (*t_RlcCompressedBitStream).get() = std::string(sliceBegin, sliceEnd);
             assert(rlcCompressedBitStreamSize == (*t_RlcCompressedBitStream).get().size());
@@ -722,7 +1124,7 @@ discardGroup:;
         /* Extract lsb-compressed groups */
         utils::Advance(sliceBegin, extractedBitStream.end(), rlcCompressedBitStreamSize);
         for (uint32_t currentGroup = 0; currentGroup < xi; ++currentGroup) {
-            utils::Advance(sliceEnd, extractedBitStream.end(), (constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1) - constsRef.GetAlpha()));
+            utils::Advance(sliceEnd, extractedBitStream.end(), (constsRef.GetLambda() * (4 * constsRef.GetLsbLayers() - 1) - constsRef.GetAlpha()), true);
 
             if (t_LsbCompressedGroups) {
                 (*t_LsbCompressedGroups).get().emplace_back(sliceBegin, sliceEnd);
@@ -737,7 +1139,7 @@ discardGroup:;
 
         /* Extract bitstream with hashes */
         for (uint32_t currentGroup = 0; currentGroup < xi; ++currentGroup) {
-            utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetLsbHashSize());
+            utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetLsbHashSize(), true);
 
             if (t_GroupHashesBitStream) {
                 (*t_GroupHashesBitStream).get().emplace_back(sliceBegin, sliceEnd);
@@ -751,7 +1153,7 @@ discardGroup:;
         }
 
         /* Extract bitstream with lsbs */
-        utils::Advance(sliceEnd, extractedBitStream.end(), totalBlocks);
+        utils::Advance(sliceEnd, extractedBitStream.end(), totalBlocks, true);
         if (t_LsbsBitStream) {
             (*t_LsbsBitStream).get() = std::string(sliceBegin, sliceEnd);
             assert(totalBlocks == (*t_LsbsBitStream).get().size());
@@ -759,7 +1161,36 @@ discardGroup:;
 
         /* Extract bitstream with user-data */
         utils::Advance(sliceBegin, extractedBitStream.end(), totalBlocks);
-        utils::Advance(sliceEnd, extractedBitStream.end(), std::distance(sliceEnd, extractedBitStream.end()));
+
+        if (!constsRef.IsPayloadFramed()) {
+            utils::Advance(sliceEnd, extractedBitStream.end(), std::distance(sliceEnd, extractedBitStream.end()));
+            if (t_UserDataBitStream) {
+                (*t_UserDataBitStream).get() = std::string(sliceBegin, sliceEnd);
+            }
+            return;
+        }
+
+        /* Framed payload: parse length and checksum, then stop at the real end of the payload. */
+        utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetPayloadLengthSize(), true);
+        const uint64_t payloadBytes = std::bitset<32>(std::string(sliceBegin, sliceEnd)).to_ulong();
+        utils::Advance(sliceBegin, extractedBitStream.end(), constsRef.GetPayloadLengthSize());
+
+        utils::Advance(sliceEnd, extractedBitStream.end(), constsRef.GetPayloadChecksumSize(), true);
+        const uint32_t payloadChecksum = static_cast<uint32_t>(std::bitset<32>(std::string(sliceBegin, sliceEnd)).to_ulong());
+        utils::Advance(sliceBegin, extractedBitStream.end(), constsRef.GetPayloadChecksumSize());
+
+        if (payloadBytes * 8 > static_cast<uint64_t>(std::distance(sliceEnd, extractedBitStream.end()))) {
+            throw std::invalid_argument("Framed payload length exceeds the embedded user-data size! Wrong key or parameters?");
+        }
+        utils::Advance(sliceEnd, extractedBitStream.end(), payloadBytes * 8, true);
+
+        std::vector<uint8_t> payload(payloadBytes);
+        utils::PackBits(std::string_view(extractedBitStream).substr(std::distance(extractedBitStream.begin(), sliceBegin), payloadBytes * 8), payload.data());
+
+        if (utils::CalculateCRC32(payload) != payloadChecksum) {
+            throw std::invalid_argument("Framed payload checksum mismatch! Wrong key or parameters?");
+        }
+
         if (t_UserDataBitStream) {
             (*t_UserDataBitStream).get() = std::string(sliceBegin, sliceEnd);
         }
@@ -3,12 +3,41 @@
 #include "types.h"
 #include "image/bmp_image.h"
 #include "embedder/consts.h"
+#include "embedder/embedder.h"
+#include "extractor/candidate_search.h"
 
 #include "Eigen/Dense"
 
 namespace rdh {
     class Extractor {
     public:
+        /**
+         * @brief Bitstream extracted from marked-encrypted image before deshuffling.
+         * Doesn't depend on the data embedding key, so it can be extracted once
+         * and then parsed using as many keys as needed.
+        */
+        struct RawBitStream {
+            /**
+             * @brief Shuffled bitstream {\Re || C || \Lambda || H || F || S }.
+            */
+            std::string m_BitStream;
+
+            /**
+             * @brief Location map (if value is 1 - block is compressed using rlc, otherwise - using lsb).
+            */
+            std::vector<bool> m_BinaryLocationMap;
+
+            /**
+             * @brief Number of blocks encoded using RLC-based algorithm. In the article it's referred as R.
+            */
+            uint32_t m_OmegaOneBlocks{ 0 };
+
+            /**
+             * @brief Total number of 2x2 pixels blocks. In the article it's referred as L.
+            */
+            uint32_t m_TotalBlocks{ 0 };
+        };
+
         /**
          * @brief Recovers image using image encryption key.
          * @param t_MarkedEncryptedImage Image to recover from.
@@ -21,10 +50,27 @@ namespace rdh {
             std::vector<uint8_t>& t_EncryptionKey
         );
         
+        /**
+         * @brief Quickly recovers half-resolution preview of an image using image encryption key.
+         * Only the top-left pixel of each 2x2 block is decrypted (its LSB is the location map bit,
+         * so it's recovered the same way, as in RecoverImage). No interpolation and no bitstreams extraction is done.
+         * @param t_MarkedEncryptedImage Image to recover preview from.
+         * @param t_PreviewImagePath where to save preview image (if empty, preview isn't saved).
+         * @param t_EncryptionKey Image encryption key.
+         * @return Preview image of size (height / 2) x (width / 2).
+        */
+        static BmpImage RecoverPreview(
+            const BmpImage& t_MarkedEncryptedImage,
+            const std::string t_PreviewImagePath,
+            const std::vector<uint8_t>& t_EncryptionKey
+        );
+
         /**
          * @brief Extracts data from t_MarkedEncryptedImage using dataEmbeddingKey.
+         * If the payload is framed (see Consts::IsPayloadFramed), only the real payload bytes are saved,
+         * otherwise the padding is saved as well. Tile-partitioned containers (see Consts::GetTileSize) are extracted tile by tile concurrently.
          * @param t_MarkedEncryptedImage Image to extract data from.
-         * @param t_ExtractedDataPath where to save extracted data.
+         * @param t_ExtractedDataPath where to save extracted data ("-" means standard output).
          * @param t_DataEmbeddingKey data embedding key.
         */
         static void ExtractData(
@@ -33,14 +79,70 @@ namespace rdh {
             std::vector<uint8_t>& t_DataEmbeddingKey
         );
 
+        /**
+         * @brief Extracts key-independent raw bitstream and location map from marked-encrypted image.
+         * @param t_MarkedEncryptedImage Image to extract bitstream from.
+         * @return Raw (still shuffled) bitstream.
+        */
+        static RawBitStream ExtractRawBitStream(const BmpImage& t_MarkedEncryptedImage);
+
+        /**
+         * @brief Extracts user-data bitstream from the shared raw bitstream for each of the keys.
+         * Keys are processed in parallel, each one does only deshuffling and parsing.
+         * @param t_RawBitStream Raw bitstream, extracted using ExtractRawBitStream.
+         * @param t_DataEmbeddingKeys Data embedding keys to try.
+         * @return User-data bitstream for each key (in the same order as keys). Empty, if the stream can't be parsed using the key.
+        */
+        static std::vector<std::string> ExtractUserDataWithKeys(
+            const RawBitStream& t_RawBitStream,
+            const std::vector<std::vector<uint8_t>>& t_DataEmbeddingKeys
+        );
+
+        /**
+         * @brief Default number of LSB-compressed groups, that are recovered to check the data embedding key.
+        */
+        static constexpr uint32_t c_ProbeSampledGroups{ 4 };
+
+        /**
+         * @brief Cheaply checks, whether image was marked using t_DataEmbeddingKey and current parameters
+         * (threshold, lambda, alpha, lsb layers, hash size). Parses the stream header and recovers only
+         * a few LSB-compressed groups, instead of running the full extraction.
+         * @param t_MarkedEncryptedImage Image to check.
+         * @param t_DataEmbeddingKey data embedding key.
+         * @param t_SampledGroups number of LSB-compressed groups to recover.
+         * @return true, if the key and parameters look correct, false if they are definitely wrong.
+        */
+        static bool ProbeEmbeddingKey(
+            const BmpImage& t_MarkedEncryptedImage,
+            const std::vector<uint8_t>& t_DataEmbeddingKey,
+            uint32_t t_SampledGroups = c_ProbeSampledGroups
+        );
+
+        /**
+         * @brief Finds embedding parameters of the marked-encrypted image. Candidate parameter sets are probed
+         * concurrently (see ProbeEmbeddingKey), raw bitstreams are shared between sets with the same lambda and lsb layers.
+         * Each raw bitstream is extracted only, when it's needed first, and released after the last set, that uses it.
+         * Sets, that pass the probe, are confirmed by recovering all of the LSB-compressed groups.
+         * @param t_MarkedEncryptedImage Image to check.
+         * @param t_DataEmbeddingKey data embedding key.
+         * @param t_CandidateParams candidate parameter sets.
+         * @return The first parameter set from t_CandidateParams, that passes the probe, std::nullopt if none of them does.
+        */
+        static std::optional<Consts> DiscoverParameters(
+            const BmpImage& t_MarkedEncryptedImage,
+            const std::vector<uint8_t>& t_DataEmbeddingKey,
+            const std::vector<Consts>& t_CandidateParams
+        );
+
         /**
          * @brief Extracts data and recovers image from t_MarkedEncryptedImage using 
          * both encryption and dataEmbedding keys.
          * @param t_MarkedEncryptedImage Image to extract data and recover original image from
          * @param t_RecoveredImagePath where to save recovered image.
-         * @param t_ExtractedDataPath where to save extracted data.
+         * @param t_ExtractedDataPath where to save extracted data ("-" means standard output).
          * @param t_DataEmbeddingKey data embedding key.
          * @param t_EncryptionKey Image encryption key.
+         * If Consts::GetTileSize is not zero, image is treated as a tile-partitioned container, and tiles are processed concurrently.
         */
         static void RecoverImageAndExract(
             BmpImage& t_MarkedEncryptedImage,
@@ -50,10 +152,105 @@ namespace rdh {
             std::vector<uint8_t>& t_EncryptionKey
         );
     private:
+        /**
+         * @brief Horizontal tile (band of 2x2 blocks rows), that is recovered by a single thread.
+         * Holds directly decrypted top-left and down-right pixels of its blocks, including one halo row
+         * of blocks above and below the tile, so that the remaining pixels can be interpolated
+         * without reading neighbouring tiles.
+        */
+        struct RecoveryTile {
+            /**
+             * @brief First blocks row of the tile (including).
+            */
+            uint32_t m_BlockYStart;
+
+            /**
+             * @brief Last blocks row of the tile (excluding).
+            */
+            uint32_t m_BlockYEnd;
+
+            /**
+             * @brief Decrypted top-left pixels of blocks rows [m_BlockYStart - 1, m_BlockYEnd].
+            */
+            std::vector<Color8u> m_TopLeft;
+
+            /**
+             * @brief Decrypted (or interpolated) down-right pixels of blocks rows [m_BlockYStart - 1, m_BlockYEnd).
+            */
+            std::vector<Color8u> m_DownRight;
+        };
+
+        /**
+         * @brief Decrypts top-left pixels and recovers down-right pixels of all blocks of the tile (and of its halo rows).
+         * Image itself is not modified.
+         * @param t_MarkedEncryptedImage Image to recover from.
+         * @param t_EncryptionKey Image encryption key.
+         * @param t_Tile Tile to fill.
+        */
+        static void DecryptTileCorners(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, RecoveryTile& t_Tile);
+
+        /**
+         * @brief Recovers top-right and down-left pixels of the tile and writes all recovered tile pixels into the image.
+         * @param t_MarkedEncryptedImage Image to recover. Only the rows of the current tile are modified.
+         * @param t_EncryptionKey Image encryption key.
+         * @param t_Tile Tile, that was filled by DecryptTileCorners.
+        */
+        static void RecoverTile(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, const RecoveryTile& t_Tile);
+
+        /**
+         * @brief Recovers image and extracts user-data bitstream, using both encryption and data embedding keys.
+         * @param[in,out] t_MarkedEncryptedImage Image to extract data and recover original image from (Edited in place).
+         * @param[in] t_DataEmbeddingKey data embedding key.
+         * @param[in] t_EncryptionKey Image encryption key.
+         * @param[out] t_UserDataBitStream Bitstream of user-embedded data.
+        */
+        static void RecoverImageAndExtractBitStream(
+            BmpImage& t_MarkedEncryptedImage,
+            std::vector<uint8_t>& t_DataEmbeddingKey,
+            std::vector<uint8_t>& t_EncryptionKey,
+            std::string& t_UserDataBitStream
+        );
+
+        /**
+         * @brief Writes recovered LSBs of the grouped \omega_2 blocks back into the image, and decrypts these blocks.
+         * Kernel for the parameters Params (see DispatchEmbeddingParams).
+         * @param t_MarkedEncryptedImage Image to recover (Edited in place).
+         * @param t_BinaryLocationMap location map of the image.
+         * @param t_RestoredGroups recovered LSB groups.
+         * @param t_EncryptionKey Image encryption key.
+         * @param t_KeyCursor index of the encryption key byte for the first block.
+        */
+        template <class Params>
+        static void PackRestoredGroups(
+            BmpImage& t_MarkedEncryptedImage,
+            const std::vector<bool>& t_BinaryLocationMap,
+            const std::vector<Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>>& t_RestoredGroups,
+            const std::vector<uint8_t>& t_EncryptionKey,
+            uint32_t t_KeyCursor
+        );
+
+        /**
+         * @brief Writes user data bitstreams one after another into t_ExtractedDataPath as packed bytes.
+         * @param t_ExtractedDataPath where to save extracted data ("-" means standard output).
+         * @param t_UserDataBitStreams user data bitstreams (one per tile for the tile-partitioned containers).
+        */
+        static void SaveUserData(const std::string& t_ExtractedDataPath, const std::vector<std::string>& t_UserDataBitStreams);
+
+        /**
+         * @brief Builds encryption key of a single tile: blocks of the whole image are encrypted
+         * with key bytes in raster order, so the tile gets the bytes of its own blocks.
+         * @param t_MarkedEncryptedImage the whole image.
+         * @param t_EncryptionKey Image encryption key.
+         * @param t_Tile tile of the image.
+         * @return Encryption key of the tile (one byte per block of the tile).
+        */
+        static std::vector<uint8_t> TileEncryptionKey(const BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey, const Embedder::ContainerTile& t_Tile);
+
         /**
          * @brief Extracts all of the bitstreams from marked-encrypted image.
          * @param[in] t_MarkedEncryptedImage Image to extract bitstreams from.
          * @param[in] t_DataEmbeddingKey Key, that was used to embed additional data.
+         * @param[out] t_HuffmanCoder Huffman code for rlc-compressed blocks (left unchanged, if the default one was used).
          * @param[out] t_RlcCompressedBlocksLengths std::vector<uint16_t> of lengths for rlc-compressed blocks.
          * @param[out] t_RlcCompressedBitStream Bitstream of rlc-compressed blocks.
          * @param[out] t_LsbCompressedGroups vector of Bitstreams of lsb-compressed groups.
@@ -65,6 +262,7 @@ namespace rdh {
         static void ExtractBitStreams(
             const BmpImage& t_MarkedEncryptedImage,
             std::vector<uint8_t>& t_DataEmbeddingKey, 
+            std::optional<std::reference_wrapper<RlcHuffmanCode>> t_HuffmanCoder,
             std::optional<std::reference_wrapper<std::vector<uint16_t>>> t_RlcCompressedBlocksLengths,
             std::optional<std::reference_wrapper<std::string>> t_RlcCompressedBitStream,
             std::optional<std::reference_wrapper<std::vector<std::string>>> t_LsbCompressedGroups,
@@ -73,5 +271,81 @@ namespace rdh {
             std::optional<std::reference_wrapper<std::string>> t_UserDataBitStream,
             std::optional<std::reference_wrapper<std::vector<bool>>> t_BinaryLocationMap
         );
+
+        /**
+         * @brief Same as ProbeEmbeddingKey, but uses already extracted raw bitstream.
+         * @param t_MarkedEncryptedImage Image to check.
+         * @param t_RawBitStream Raw bitstream, extracted from t_MarkedEncryptedImage using the current parameters.
+         * @param t_DataEmbeddingKey data embedding key.
+         * @param t_SampledGroups number of LSB-compressed groups to recover.
+         * @return true, if the key and parameters look correct.
+        */
+        static bool ProbeRawBitStream(
+            const BmpImage& t_MarkedEncryptedImage,
+            const RawBitStream& t_RawBitStream,
+            const std::vector<uint8_t>& t_DataEmbeddingKey,
+            uint32_t t_SampledGroups
+        );
+
+        /**
+         * @brief Prepares candidate search for LSB-compressed groups using psi and hash matrices, generated from t_DataEmbeddingKey.
+         * @param t_DataEmbeddingKey data embedding key.
+         * @return Candidate search object.
+        */
+        static CandidateSearch CreateCandidateSearch(const std::vector<uint8_t>& t_DataEmbeddingKey);
+
+        /**
+         * @brief Checks, that the parsed stream header is consistent with the current parameters:
+         * every RLC-compressed block should be shorter than the threshold.
+         * @param t_RlcCompressedBlocksLengths lengths of rlc-compressed blocks.
+         * @return true, if header is consistent.
+        */
+        static bool IsHeaderConsistent(const std::vector<uint16_t>& t_RlcCompressedBlocksLengths);
+
+        /**
+         * @brief Recovers t_SampledGroups LSB-compressed groups, evenly spread over the image.
+         * @param t_LsbCompressedGroups LSB-compressed groups.
+         * @param t_GroupHashesBitStream hashes of the groups.
+         * @param t_OmegaTwoEncryptedBlocks contiguous blocks of all groups (lambda blocks per group).
+         * @param t_CandidateSearch Candidate search object to use.
+         * @param t_HuffmanCoder Huffman coder object to use.
+         * @param t_SampledGroups number of groups to recover.
+         * @return true, if all of the sampled groups were recovered.
+        */
+        static bool AreSampledGroupsRecoverable(
+            const std::vector<std::string>& t_LsbCompressedGroups,
+            const std::vector<std::string>& t_GroupHashesBitStream,
+            std::span<CandidateSearch::PackedBlock> t_OmegaTwoEncryptedBlocks,
+            CandidateSearch& t_CandidateSearch,
+            const RlcHuffmanCode& t_HuffmanCoder,
+            uint32_t t_SampledGroups
+        );
+
+        /**
+         * @brief Deshuffles raw bitstream using t_DataEmbeddingKey and splits it into separate bitstreams.
+         * @param[in] t_RawBitStream Raw bitstream, extracted using ExtractRawBitStream.
+         * @param[in] t_DataEmbeddingKey Key, that was used to embed additional data.
+         * @param[out] t_HuffmanCoder Huffman code for rlc-compressed blocks (left unchanged, if the default one was used).
+         * @param[out] t_RlcCompressedBlocksLengths std::vector<uint16_t> of lengths for rlc-compressed blocks.
+         * @param[out] t_RlcCompressedBitStream Bitstream of rlc-compressed blocks.
+         * @param[out] t_LsbCompressedGroups vector of Bitstreams of lsb-compressed groups.
+         * @param[out] t_GroupHashesBitStream Bitstream vector of Bitstreams of lsb-compressed groups hashes.
+         * @param[out] t_LsbsBitStream Bitstream of LSBs for each block.
+         * @param[out] t_UserDataBitStream Bitstream of user-embedded data.
+         * @throw std::invalid_argument if the bitstream is too short (wrong key or parameters), or framed payload is corrupted.
+        */
+        static void ParseBitStreams(
+            const RawBitStream& t_RawBitStream,
+            const std::vector<uint8_t>& t_DataEmbeddingKey,
+            std::optional<std::reference_wrapper<RlcHuffmanCode>> t_HuffmanCoder,
+            std::optional<std::reference_wrapper<std::vector<uint16_t>>> t_RlcCompressedBlocksLengths,
+            std::optional<std::reference_wrapper<std::string>> t_RlcCompressedBitStream,
+            std::optional<std::reference_wrapper<std::vector<std::string>>> t_LsbCompressedGroups,
+            std::optional<std::reference_wrapper<std::vector<std::string>>> t_GroupHashesBitStream,
+            std::optional<std::reference_wrapper<std::string>> t_LsbsBitStream,
+            std::optional<std::reference_wrapper<std::string>> t_UserDataBitStream
+        );
+
+        friend class bench::Kernels;
     };
 }
\ No newline at end of file
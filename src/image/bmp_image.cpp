@@ -105,6 +105,11 @@ namespace rdh {
         return m_ImageMatrix;
     }
 
+    const ImageMatrix<Color8u>& BmpImage::GetImageMatrix() const
+    {
+        return m_ImageMatrix;
+    }
+
     void BmpImage::Show() const
     {
         CImg<Color8u> image(m_ImageMatrix.GetWidth(), m_ImageMatrix.GetHeight(), 1, 1, 0);
@@ -105,6 +105,12 @@ namespace rdh {
         */
         ImageMatrix<Color8u>& GetImageMatrix();
 
+        /**
+         * @brief Return const ImageMatrix of a current image
+         * @return ImageMatrix
+        */
+        const ImageMatrix<Color8u>& GetImageMatrix() const;
+
         /**
          * @brief Display image
         */
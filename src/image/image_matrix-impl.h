@@ -108,7 +108,7 @@ namespace rdh {
         // Copy matrix pixel-by-pixel
         for (uint32_t y = t_YStart; y <= t_YEnd; ++y) {
             for (uint32_t x = t_XStart; x <= t_XEnd; ++x) {
-                slicedMatrix.SetPixel(x, y, GetPixel(x, y));
+                slicedMatrix.SetPixel(y - t_YStart, x - t_XStart, GetPixel(y, x));
             }
         }
 
@@ -133,6 +133,12 @@ namespace rdh {
         return m_ImageMatrix.at(t_Y);
     }
 
+    template <typename T>
+    const std::vector<T>& ImageMatrix<T>::GetRow(uint32_t t_Y) const
+    {
+        return m_ImageMatrix.at(t_Y);
+    }
+
     template <typename T>
     std::vector<std::vector<T>>& ImageMatrix<T>::GetMatrixRaw()
     {
@@ -111,6 +111,12 @@ namespace rdh {
         */
         std::vector<T>& GetRow(uint32_t t_Y);
 
+        /**
+         * @brief Returns const reference to a specific row
+         * @return std::vector<T> that represents row
+        */
+        const std::vector<T>& GetRow(uint32_t t_Y) const;
+
         /**
          * @brief Returns whole 2d array as a reference
          * @return reference to a 2d array, that represents matrix
@@ -1,79 +1,402 @@
 #include "image/image_quality.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "embedder/consts.h"
 
 namespace rdh {
     double ImageQuality::CalculatePSNR(const BmpImage& t_Img1, const BmpImage& t_Img2)
+    {
+        return MSEToPSNR(CalculateMSE(t_Img1, t_Img2));
+    }
+
+    double ImageQuality::MSEToPSNR(double t_MeanSquaredError)
+    {
+        /* If MSE is almost 0, return +infinity */
+        if (t_MeanSquaredError <= 1E-10) {
+            return +std::numeric_limits<double>::infinity();
+        }
+
+        return 10.0f * std::log10f(std::powf(255, 2) / t_MeanSquaredError);
+    }
+
+    double ImageQuality::CalculateMSE(const BmpImage& t_Img1, const BmpImage& t_Img2)
     {
         if ((t_Img1.GetHeight() != t_Img2.GetHeight()) || (t_Img1.GetWidth() != t_Img2.GetWidth())) {
             throw std::invalid_argument("The dimensions of the images must be the same!");
         }
 
-        double meanSquaredError = 0;
+        const uint32_t height = t_Img1.GetHeight();
+        const uint32_t width = t_Img1.GetWidth();
+
+        /* Each band of rows has its own sum. Sums are integers, so the result doesn't depend on the split. */
+        std::vector<uint64_t> rowsSums(height, 0);
+        ForEachRowBand(height, static_cast<uint64_t>(height) * width, [&](uint32_t t_RowBegin, uint32_t t_RowEnd) {
+            for (uint32_t imgY = t_RowBegin; imgY < t_RowEnd; ++imgY) {
+                rowsSums[imgY] = SquaredDifferencesSum(
+                    t_Img1.GetImageMatrix().GetRow(imgY).data(), t_Img2.GetImageMatrix().GetRow(imgY).data(), width
+                );
+            }
+        });
+
+        /* Exact up to 2^53, which is the same, as summing squared differences in double. */
+        const uint64_t squaredDifferencesSum = std::accumulate(rowsSums.begin(), rowsSums.end(), uint64_t{ 0 });
+
+        return (double)squaredDifferencesSum / ((double)height * (double)width);
+    }
+
+    uint64_t ImageQuality::SquaredDifferencesSum(const Color8u* t_Row1, const Color8u* t_Row2, uint32_t t_Width)
+    {
+        uint64_t sum{ 0 };
+        uint32_t imgX{ 0 };
+
+#if defined(__SSE2__) || defined(_M_X64)
+        /**
+         * 16 pixels per iteration: bytes are widened to 16-bit, subtracted, and squared differences
+         * of neighbouring pixels are summed into 32-bit lanes (madd). Each iteration adds at most 4 * 255^2
+         * to a lane, so lanes are flushed into 64-bit totals long before they can overflow.
+         */
+        constexpr uint32_t c_PixelsPerIteration{ 16 };
+        constexpr uint32_t c_IterationsPerFlush{ 4096 };
+
+        const __m128i zero = _mm_setzero_si128();
+        __m128i totals = _mm_setzero_si128();
+
+        while (t_Width - imgX >= c_PixelsPerIteration) {
+            const uint32_t flushEnd = imgX + std::min(t_Width - imgX, c_PixelsPerIteration * c_IterationsPerFlush) / c_PixelsPerIteration * c_PixelsPerIteration;
+
+            __m128i lanes = _mm_setzero_si128();
+            for (; imgX < flushEnd; imgX += c_PixelsPerIteration) {
+                const __m128i pixels1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_Row1 + imgX));
+                const __m128i pixels2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_Row2 + imgX));
+
+                const __m128i diffLow = _mm_sub_epi16(_mm_unpacklo_epi8(pixels1, zero), _mm_unpacklo_epi8(pixels2, zero));
+                const __m128i diffHigh = _mm_sub_epi16(_mm_unpackhi_epi8(pixels1, zero), _mm_unpackhi_epi8(pixels2, zero));
 
-        for (uint32_t imgY = 0; imgY < t_Img1.GetHeight(); imgY += 1) {
-            for (uint32_t imgX = 0; imgX < t_Img1.GetWidth(); imgX += 1) {
-                meanSquaredError += std::powf(
-                    (float)t_Img1.GetPixel(imgY, imgX) - 
-                    (float)t_Img2.GetPixel(imgY, imgX), 2);
+                lanes = _mm_add_epi32(lanes, _mm_madd_epi16(diffLow, diffLow));
+                lanes = _mm_add_epi32(lanes, _mm_madd_epi16(diffHigh, diffHigh));
             }
+
+            /* Lanes are non-negative, so they are zero-extended into 64-bit totals. */
+            totals = _mm_add_epi64(totals, _mm_unpacklo_epi32(lanes, zero));
+            totals = _mm_add_epi64(totals, _mm_unpackhi_epi32(lanes, zero));
         }
 
-        meanSquaredError /= ((double)t_Img1.GetHeight() * (double)t_Img1.GetWidth());
+        alignas(16) std::array<uint64_t, 2> totalsArray;
+        _mm_store_si128(reinterpret_cast<__m128i*>(totalsArray.data()), totals);
+        sum = totalsArray[0] + totalsArray[1];
+#endif
 
-        /* If MSE is almost 0, return +infinity */
-        if (meanSquaredError <= 1E-10) {
-            return +std::numeric_limits<double>::infinity();
+        for (; imgX < t_Width; ++imgX) {
+            const int32_t diff = static_cast<int32_t>(t_Row1[imgX]) - static_cast<int32_t>(t_Row2[imgX]);
+            sum += static_cast<uint64_t>(diff * diff);
         }
 
-        return 10.0f * std::log10f(std::powf(255, 2) / meanSquaredError);
+        return sum;
     }
 
     double ImageQuality::CalculateSSIM(const BmpImage& t_Img1, const BmpImage& t_Img2)
+    {
+        return CalculateSSIM(t_Img1, t_Img2, SsimWindow::Block2x2);
+    }
+
+    double ImageQuality::CalculateSSIM(const BmpImage& t_Img1, const BmpImage& t_Img2, SsimWindow t_Window)
     {
         if ((t_Img1.GetHeight() != t_Img2.GetHeight()) || (t_Img1.GetWidth() != t_Img2.GetWidth())) {
             throw std::invalid_argument("The dimensions of the images must be the same!");
         }
 
-        double ssim = 0;
-
-        for (uint32_t imgY = 0; imgY < t_Img1.GetHeight(); imgY += 2) {
-            for (uint32_t imgX = 0; imgX < t_Img1.GetWidth(); imgX += 2) {
-                ssim += Phi(
-                    Block(
-                        t_Img1.GetPixel(imgY, imgX),
-                        t_Img1.GetPixel(imgY, imgX + 1),
-                        t_Img1.GetPixel(imgY + 1, imgX),
-                        t_Img1.GetPixel(imgY + 1, imgX + 1)
-                    ),
-                    Block(
-                        t_Img2.GetPixel(imgY, imgX),
-                        t_Img2.GetPixel(imgY, imgX + 1),
-                        t_Img2.GetPixel(imgY + 1, imgX),
-                        t_Img2.GetPixel(imgY + 1, imgX + 1)
-                    )
+        const uint32_t windowSize = (t_Window == SsimWindow::Block2x2) ? 2 : (t_Window == SsimWindow::Box8x8) ? 8 : 11;
+        if (t_Img1.GetHeight() < windowSize || t_Img1.GetWidth() < windowSize) {
+            throw std::invalid_argument("The images are smaller than the SSIM window!");
+        }
+
+        /* Non-overlapping blocks for the 2x2 mode, sliding windows otherwise. */
+        const uint32_t windowStep = (t_Window == SsimWindow::Block2x2) ? 2 : 1;
+        const uint32_t windowRows = (t_Img1.GetHeight() - windowSize) / windowStep + 1;
+        const uint32_t windowColumns = (t_Img1.GetWidth() - windowSize) / windowStep + 1;
+
+        /* SSIM sum is saved for each row of windows, and summed in the same order regardless of the number of threads. */
+        std::vector<double> rowsSsim(windowRows, 0.0);
+        ForEachRowBand(windowRows, static_cast<uint64_t>(t_Img1.GetHeight()) * t_Img1.GetWidth(), [&](uint32_t t_RowBegin, uint32_t t_RowEnd) {
+            switch (t_Window) {
+            case SsimWindow::Block2x2:
+                SsimRowsBlock2x2(t_Img1, t_Img2, t_RowBegin, t_RowEnd, rowsSsim);
+                break;
+            case SsimWindow::Box8x8:
+                SsimRowsBox8x8(t_Img1, t_Img2, t_RowBegin, t_RowEnd, rowsSsim);
+                break;
+            case SsimWindow::Gaussian11x11:
+                SsimRowsGaussian11x11(t_Img1, t_Img2, t_RowBegin, t_RowEnd, rowsSsim);
+                break;
+            }
+        });
+
+        return std::accumulate(rowsSsim.begin(), rowsSsim.end(), 0.0) / ((double)windowRows * (double)windowColumns);
+    }
+
+    void ImageQuality::SsimRowsBlock2x2(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim)
+    {
+        const uint32_t blocksInRow = t_Img1.GetWidth() / 2;
+
+        for (uint32_t blockY = t_RowBegin; blockY < t_RowEnd; ++blockY) {
+            const Color8u* top1 = t_Img1.GetImageMatrix().GetRow(2 * blockY).data();
+            const Color8u* bottom1 = t_Img1.GetImageMatrix().GetRow(2 * blockY + 1).data();
+            const Color8u* top2 = t_Img2.GetImageMatrix().GetRow(2 * blockY).data();
+            const Color8u* bottom2 = t_Img2.GetImageMatrix().GetRow(2 * blockY + 1).data();
+
+            double rowSsim{ 0.0 };
+            for (uint32_t blockX = 0; blockX < blocksInRow; ++blockX) {
+                const std::array<int32_t, 4> px1{ top1[2 * blockX], top1[2 * blockX + 1], bottom1[2 * blockX], bottom1[2 * blockX + 1] };
+                const std::array<int32_t, 4> px2{ top2[2 * blockX], top2[2 * blockX + 1], bottom2[2 * blockX], bottom2[2 * blockX + 1] };
+
+                int32_t sumX{ 0 }, sumY{ 0 }, sumXX{ 0 }, sumYY{ 0 }, sumXY{ 0 };
+                for (uint32_t pxIdx = 0; pxIdx < 4; ++pxIdx) {
+                    sumX += px1[pxIdx];
+                    sumY += px2[pxIdx];
+                    sumXX += px1[pxIdx] * px1[pxIdx];
+                    sumYY += px2[pxIdx] * px2[pxIdx];
+                    sumXY += px1[pxIdx] * px2[pxIdx];
+                }
+
+                /* Sample (co)variance of 4 pixels: (4 * sum(xy) - sum(x) * sum(y)) / (4 * 3). Numerators are exact. */
+                rowSsim += WindowSsim(
+                    sumX / 4.0, sumY / 4.0,
+                    (4 * sumXX - sumX * sumX) / 12.0, (4 * sumYY - sumY * sumY) / 12.0, (4 * sumXY - sumX * sumY) / 12.0
                 );
             }
+
+            t_RowsSsim[blockY] = rowSsim;
         }
+    }
+
+    namespace {
+        /**
+         * @brief Sums of x, y, x^2, y^2 and xy over a column of the window, for every column of the image.
+         */
+        struct ColumnSums {
+            explicit ColumnSums(uint32_t t_Width)
+                : m_X(t_Width, 0), m_Y(t_Width, 0), m_XX(t_Width, 0), m_YY(t_Width, 0), m_XY(t_Width, 0)
+            {}
+
+            std::vector<uint32_t> m_X;
+            std::vector<uint32_t> m_Y;
+            std::vector<uint32_t> m_XX;
+            std::vector<uint32_t> m_YY;
+            std::vector<uint32_t> m_XY;
+        };
+
+        /**
+         * @brief Slides column sums one row down: adds row t_Added (of both images) and subtracts row t_Removed.
+         * Sums are kept modulo 2^32, so the order of adding and subtracting doesn't matter.
+         */
+        void SlideColumnSums(ColumnSums& t_Sums, const Color8u* t_Added1, const Color8u* t_Added2, const Color8u* t_Removed1, const Color8u* t_Removed2, uint32_t t_Width)
+        {
+            uint32_t imgX{ 0 };
+
+#if defined(__SSE2__) || defined(_M_X64)
+            /* 8 pixels per iteration: bytes are widened to 16-bit, products (at most 255^2) fit into unsigned 16-bit lanes. */
+            const __m128i zero = _mm_setzero_si128();
+
+            const auto updateLanes = [&zero](uint32_t* t_Sums, __m128i t_Added, __m128i t_Removed) {
+                __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_Sums));
+                __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_Sums + 4));
 
-        ssim /= ((double)t_Img1.GetHeight() * (double)t_Img1.GetWidth() / 4.0f);
+                low = _mm_sub_epi32(_mm_add_epi32(low, _mm_unpacklo_epi16(t_Added, zero)), _mm_unpacklo_epi16(t_Removed, zero));
+                high = _mm_sub_epi32(_mm_add_epi32(high, _mm_unpackhi_epi16(t_Added, zero)), _mm_unpackhi_epi16(t_Removed, zero));
 
-        assert(ssim >= 0 && ssim <= 1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(t_Sums), low);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(t_Sums + 4), high);
+            };
 
-        return ssim;
+            for (; imgX + 8 <= t_Width; imgX += 8) {
+                const __m128i added1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t_Added1 + imgX)), zero);
+                const __m128i added2 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t_Added2 + imgX)), zero);
+                const __m128i removed1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t_Removed1 + imgX)), zero);
+                const __m128i removed2 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(t_Removed2 + imgX)), zero);
+
+                updateLanes(t_Sums.m_X.data() + imgX, added1, removed1);
+                updateLanes(t_Sums.m_Y.data() + imgX, added2, removed2);
+                updateLanes(t_Sums.m_XX.data() + imgX, _mm_mullo_epi16(added1, added1), _mm_mullo_epi16(removed1, removed1));
+                updateLanes(t_Sums.m_YY.data() + imgX, _mm_mullo_epi16(added2, added2), _mm_mullo_epi16(removed2, removed2));
+                updateLanes(t_Sums.m_XY.data() + imgX, _mm_mullo_epi16(added1, added2), _mm_mullo_epi16(removed1, removed2));
+            }
+#endif
+
+            for (; imgX < t_Width; ++imgX) {
+                const uint32_t added1 = t_Added1[imgX], added2 = t_Added2[imgX];
+                const uint32_t removed1 = t_Removed1[imgX], removed2 = t_Removed2[imgX];
+
+                t_Sums.m_X[imgX] += added1 - removed1;
+                t_Sums.m_Y[imgX] += added2 - removed2;
+                t_Sums.m_XX[imgX] += added1 * added1 - removed1 * removed1;
+                t_Sums.m_YY[imgX] += added2 * added2 - removed2 * removed2;
+                t_Sums.m_XY[imgX] += added1 * added2 - removed1 * removed2;
+            }
+        }
+    }
+
+    void ImageQuality::SsimRowsBox8x8(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim)
+    {
+        constexpr uint32_t c_WindowSize{ 8 };
+        constexpr int64_t c_WindowPixels{ c_WindowSize * c_WindowSize };
+
+        const uint32_t width = t_Img1.GetWidth();
+        const std::vector<Color8u> zeroRow(width, 0);
+
+        const auto row1 = [&t_Img1](uint32_t t_Y) { return t_Img1.GetImageMatrix().GetRow(t_Y).data(); };
+        const auto row2 = [&t_Img2](uint32_t t_Y) { return t_Img2.GetImageMatrix().GetRow(t_Y).data(); };
+
+        /* Column sums of the first window of the band. */
+        ColumnSums columnSums(width);
+        for (uint32_t imgY = t_RowBegin; imgY < t_RowBegin + c_WindowSize - 1; ++imgY) {
+            SlideColumnSums(columnSums, row1(imgY), row2(imgY), zeroRow.data(), zeroRow.data(), width);
+        }
+
+        for (uint32_t windowY = t_RowBegin; windowY < t_RowEnd; ++windowY) {
+            const uint32_t addedRow = windowY + c_WindowSize - 1;
+            if (windowY == t_RowBegin) {
+                SlideColumnSums(columnSums, row1(addedRow), row2(addedRow), zeroRow.data(), zeroRow.data(), width);
+            }
+            else {
+                SlideColumnSums(columnSums, row1(addedRow), row2(addedRow), row1(windowY - 1), row2(windowY - 1), width);
+            }
+
+            /* Running sums over c_WindowSize columns. */
+            int64_t sumX{ 0 }, sumY{ 0 }, sumXX{ 0 }, sumYY{ 0 }, sumXY{ 0 };
+            for (uint32_t imgX = 0; imgX < c_WindowSize - 1; ++imgX) {
+                sumX += columnSums.m_X[imgX];
+                sumY += columnSums.m_Y[imgX];
+                sumXX += columnSums.m_XX[imgX];
+                sumYY += columnSums.m_YY[imgX];
+                sumXY += columnSums.m_XY[imgX];
+            }
+
+            double rowSsim{ 0.0 };
+            for (uint32_t windowX = 0; windowX + c_WindowSize <= width; ++windowX) {
+                const uint32_t addedColumn = windowX + c_WindowSize - 1;
+                sumX += columnSums.m_X[addedColumn];
+                sumY += columnSums.m_Y[addedColumn];
+                sumXX += columnSums.m_XX[addedColumn];
+                sumYY += columnSums.m_YY[addedColumn];
+                sumXY += columnSums.m_XY[addedColumn];
+
+                /* Population (co)variance: (N * sum(xy) - sum(x) * sum(y)) / N^2. Numerators are exact. */
+                constexpr double c_WindowPixelsSquared{ static_cast<double>(c_WindowPixels * c_WindowPixels) };
+                rowSsim += WindowSsim(
+                    sumX / (double)c_WindowPixels, sumY / (double)c_WindowPixels,
+                    (c_WindowPixels * sumXX - sumX * sumX) / c_WindowPixelsSquared,
+                    (c_WindowPixels * sumYY - sumY * sumY) / c_WindowPixelsSquared,
+                    (c_WindowPixels * sumXY - sumX * sumY) / c_WindowPixelsSquared
+                );
+
+                sumX -= columnSums.m_X[windowX];
+                sumY -= columnSums.m_Y[windowX];
+                sumXX -= columnSums.m_XX[windowX];
+                sumYY -= columnSums.m_YY[windowX];
+                sumXY -= columnSums.m_XY[windowX];
+            }
+
+            t_RowsSsim[windowY] = rowSsim;
+        }
     }
 
-    double ImageQuality::Phi(const Block& block1, const Block& block2)
+    void ImageQuality::SsimRowsGaussian11x11(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim)
     {
-        double numerator = 
-            (2 * block1.CalculateMean() * block2.CalculateMean() + s_Const1) * 
-            (2 * block1.Covariance(block2) + s_Const2);
-        double denominator = 
-            (std::powf(block1.CalculateMean(), 2) + std::powf(block2.CalculateMean(), 2) + s_Const1) *
-            (std::powf(block1.CalculateStandardDeviation(), 2) + std::powf(block2.CalculateStandardDeviation(), 2) + s_Const2);
-
-        return numerator / denominator;
+        constexpr uint32_t c_WindowSize{ 11 };
+        constexpr double c_Sigma{ 1.5 };
+
+        /* Normalized 1D Gaussian weights. The 2D window is their outer product, so the sums are separable. */
+        std::array<double, c_WindowSize> weights;
+        for (uint32_t tap = 0; tap < c_WindowSize; ++tap) {
+            const double offset = static_cast<double>(tap) - (c_WindowSize - 1) / 2.0;
+            weights[tap] = std::exp(-offset * offset / (2 * c_Sigma * c_Sigma));
+        }
+        const double weightsSum = std::accumulate(weights.begin(), weights.end(), 0.0);
+        for (auto& weight : weights) {
+            weight /= weightsSum;
+        }
+
+        const uint32_t width = t_Img1.GetWidth();
+
+        /* Weighted vertical sums for every column, then weighted horizontal sums for every window. */
+        std::vector<double> columnX(width), columnY(width), columnXX(width), columnYY(width), columnXY(width);
+
+        for (uint32_t windowY = t_RowBegin; windowY < t_RowEnd; ++windowY) {
+            std::fill(columnX.begin(), columnX.end(), 0.0);
+            std::fill(columnY.begin(), columnY.end(), 0.0);
+            std::fill(columnXX.begin(), columnXX.end(), 0.0);
+            std::fill(columnYY.begin(), columnYY.end(), 0.0);
+            std::fill(columnXY.begin(), columnXY.end(), 0.0);
+
+            for (uint32_t tap = 0; tap < c_WindowSize; ++tap) {
+                const Color8u* row1 = t_Img1.GetImageMatrix().GetRow(windowY + tap).data();
+                const Color8u* row2 = t_Img2.GetImageMatrix().GetRow(windowY + tap).data();
+                const double weight = weights[tap];
+
+                /* Contiguous independent lanes, vectorized by the compiler. */
+                for (uint32_t imgX = 0; imgX < width; ++imgX) {
+                    const double px1 = row1[imgX];
+                    const double px2 = row2[imgX];
+                    columnX[imgX] += weight * px1;
+                    columnY[imgX] += weight * px2;
+                    columnXX[imgX] += weight * px1 * px1;
+                    columnYY[imgX] += weight * px2 * px2;
+                    columnXY[imgX] += weight * px1 * px2;
+                }
+            }
+
+            double rowSsim{ 0.0 };
+            for (uint32_t windowX = 0; windowX + c_WindowSize <= width; ++windowX) {
+                double meanX{ 0.0 }, meanY{ 0.0 }, meanXX{ 0.0 }, meanYY{ 0.0 }, meanXY{ 0.0 };
+                for (uint32_t tap = 0; tap < c_WindowSize; ++tap) {
+                    meanX += weights[tap] * columnX[windowX + tap];
+                    meanY += weights[tap] * columnY[windowX + tap];
+                    meanXX += weights[tap] * columnXX[windowX + tap];
+                    meanYY += weights[tap] * columnYY[windowX + tap];
+                    meanXY += weights[tap] * columnXY[windowX + tap];
+                }
+
+                rowSsim += WindowSsim(meanX, meanY, meanXX - meanX * meanX, meanYY - meanY * meanY, meanXY - meanX * meanY);
+            }
+
+            t_RowsSsim[windowY] = rowSsim;
+        }
+    }
+
+    void ImageQuality::ForEachRowBand(uint32_t t_RowsCount, uint64_t t_TotalPixels, const std::function<void(uint32_t, uint32_t)>& t_Worker)
+    {
+        const uint32_t threadsCount = static_cast<uint32_t>(std::clamp<uint64_t>(
+            std::min<uint64_t>(Consts::Instance().GetThreadsCount(), t_TotalPixels / s_MinPixelsPerThread), 1, std::max<uint32_t>(t_RowsCount, 1)
+        ));
+
+        const auto bandBounds = [&](uint32_t t_BandIdx) {
+            return static_cast<uint32_t>(static_cast<uint64_t>(t_RowsCount) * t_BandIdx / threadsCount);
+        };
+
+        if (threadsCount == 1) {
+            t_Worker(0, t_RowsCount);
+            return;
+        }
+
+        std::vector<std::thread> threadpool;
+        for (uint32_t threadIdx = 0; threadIdx < threadsCount; ++threadIdx) {
+            threadpool.emplace_back(t_Worker, bandBounds(threadIdx), bandBounds(threadIdx + 1));
+        }
+
+        for (auto& th : threadpool) {
+            th.join();
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,8 @@
 #pragma once 
 
+#include <functional>
+#include <vector>
+
 #include "image/bmp_image.h"
 #include "types.h"
 
@@ -15,13 +18,53 @@ namespace rdh {
         static double CalculatePSNR(const BmpImage& t_Img1, const BmpImage& t_Img2);
 
         /**
-         * @brief Calculates SSIM (Structural Similarity) between two images. 
+         * @brief Calculates MSE (Mean Squared Error) between two images. Squared differences are summed
+         * exactly using integers (SIMD kernel), image rows are split between threads.
+         * @param t_Img1 first image.
+         * @param t_Img2 second image.
+         * @return MSE value.
+         */
+        static double CalculateMSE(const BmpImage& t_Img1, const BmpImage& t_Img2);
+
+        /**
+         * @brief Converts MSE (Mean Squared Error) of 8-bit images into PSNR.
+         * @param t_MeanSquaredError MSE value.
+         * @return PSNR value (can be +infinity).
+         */
+        static double MSEToPSNR(double t_MeanSquaredError);
+
+        /**
+         * @brief Windows, over which local SSIM statistics are calculated.
+         */
+        enum class SsimWindow {
+            /* Non-overlapping 2x2 blocks (sample variance and covariance), as described in the article. */
+            Block2x2,
+            /* Sliding 8x8 window with uniform weights. */
+            Box8x8,
+            /* Sliding 11x11 Gaussian window (sigma = 1.5), the standard SSIM. */
+            Gaussian11x11
+        };
+
+        /**
+         * @brief Calculates SSIM (Structural Similarity) between two images using non-overlapping 2x2 blocks.
          * The value of SSIM index belongs to [0, 1].
          * @param t_Img1 first image.
          * @param t_Img2 second image.
          * @return SSIM value (can be +infinity). 
          */
         static double CalculateSSIM(const BmpImage& t_Img1, const BmpImage& t_Img2);
+
+        /**
+         * @brief Calculates mean SSIM (Structural Similarity) over all of the windows, that fit into the images.
+         * Per-window sums of x, y, x^2, y^2 and xy are computed once using running column sums
+         * (separable weighted sums for the Gaussian window), image rows are split between threads.
+         * @param t_Img1 first image.
+         * @param t_Img2 second image.
+         * @param t_Window window type.
+         * @return SSIM value.
+         * @throw std::invalid_argument if the images have different dimensions, or are smaller than the window.
+         */
+        static double CalculateSSIM(const BmpImage& t_Img1, const BmpImage& t_Img2, SsimWindow t_Window);
     
         /**
          * @brief Represents 2x2 pixels block.
@@ -73,7 +116,58 @@ namespace rdh {
             }
         };
     private:
-        static double Phi(const Block& block1, const Block& block2);
+        /**
+         * @brief SSIM for a single window from its local statistics.
+         * @param t_MeanX mean of the first image window.
+         * @param t_MeanY mean of the second image window.
+         * @param t_VarianceX variance of the first image window.
+         * @param t_VarianceY variance of the second image window.
+         * @param t_Covariance covariance of the windows.
+         * @return SSIM value.
+         */
+        static double WindowSsim(double t_MeanX, double t_MeanY, double t_VarianceX, double t_VarianceY, double t_Covariance)
+        {
+            return ((2 * t_MeanX * t_MeanY + s_Const1) * (2 * t_Covariance + s_Const2)) /
+                ((t_MeanX * t_MeanX + t_MeanY * t_MeanY + s_Const1) * (t_VarianceX + t_VarianceY + s_Const2));
+        }
+
+        /**
+         * @brief Sum of SSIM of 2x2 blocks in block rows [t_RowBegin, t_RowEnd), for each block row.
+         */
+        static void SsimRowsBlock2x2(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim);
+
+        /**
+         * @brief Sum of SSIM of 8x8 windows, whose top rows are in [t_RowBegin, t_RowEnd), for each row.
+         */
+        static void SsimRowsBox8x8(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim);
+
+        /**
+         * @brief Sum of SSIM of 11x11 Gaussian windows, whose top rows are in [t_RowBegin, t_RowEnd), for each row.
+         */
+        static void SsimRowsGaussian11x11(const BmpImage& t_Img1, const BmpImage& t_Img2, uint32_t t_RowBegin, uint32_t t_RowEnd, std::vector<double>& t_RowsSsim);
+
+        /**
+         * @brief Splits t_RowsCount rows into bands and calls t_Worker(rowBegin, rowEnd) for each band in its own thread.
+         * Number of threads is bounded by Consts::GetThreadsCount (of the calling thread, see Consts::ThreadOverride).
+         * @param t_RowsCount number of rows.
+         * @param t_TotalPixels number of pixels to process (used to decide on the number of threads).
+         * @param t_Worker callable.
+         */
+        static void ForEachRowBand(uint32_t t_RowsCount, uint64_t t_TotalPixels, const std::function<void(uint32_t, uint32_t)>& t_Worker);
+
+        /**
+         * @brief Calculates sum of squared differences between two rows of pixels.
+         * @param t_Row1 first row.
+         * @param t_Row2 second row.
+         * @param t_Width number of pixels in each row.
+         * @return sum of squared differences.
+         */
+        static uint64_t SquaredDifferencesSum(const Color8u* t_Row1, const Color8u* t_Row2, uint32_t t_Width);
+
+        /**
+         * @brief Images with fewer pixels per thread are processed in a single thread (the kernel is memory-bound).
+         */
+        static constexpr uint64_t s_MinPixelsPerThread{ 1 << 18 };
 
         static constexpr double s_Const1{ 6.5025f };
         static constexpr double s_Const2{ 58.5225f };
@@ -0,0 +1,266 @@
+#include "image/quality_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "embedder/consts.h"
+#include "image/bmp_image.h"
+
+namespace rdh {
+    std::vector<QualityBatch::Pair> QualityBatch::ParseManifest(std::istream& t_Manifest, const std::filesystem::path& t_BaseDir)
+    {
+        const auto resolvePath = [&t_BaseDir](std::string t_Path) {
+            /* Trim spaces around the path. */
+            t_Path.erase(0, t_Path.find_first_not_of(" \t\r"));
+            t_Path.erase(t_Path.find_last_not_of(" \t\r") + 1);
+
+            const std::filesystem::path path(t_Path);
+            return (path.is_relative() && !t_BaseDir.empty()) ? (t_BaseDir / path).string() : t_Path;
+        };
+
+        std::vector<Pair> pairs;
+
+        std::string line;
+        std::size_t lineNumber{ 0 };
+        while (std::getline(t_Manifest, line)) {
+            lineNumber++;
+
+            if (line.find_first_not_of(" \t\r") == std::string::npos || line[line.find_first_not_of(" \t\r")] == '#') {
+                continue;
+            }
+
+            const std::size_t separatorPos = line.find_first_of(",\t");
+            if (separatorPos == std::string::npos || line.find_first_of(",\t", separatorPos + 1) != std::string::npos) {
+                throw std::invalid_argument("Manifest line " + std::to_string(lineNumber) + " should contain exactly two paths!");
+            }
+
+            Pair pair{ resolvePath(line.substr(0, separatorPos)), resolvePath(line.substr(separatorPos + 1)) };
+            if (pair.m_ReferencePath.empty() || pair.m_TestPath.empty()) {
+                throw std::invalid_argument("Manifest line " + std::to_string(lineNumber) + " should contain exactly two paths!");
+            }
+
+            pairs.push_back(std::move(pair));
+        }
+
+        return pairs;
+    }
+
+    void QualityBatch::Evaluate(const std::vector<Pair>& t_Pairs, ImageQuality::SsimWindow t_Window, uint32_t t_ThreadsCount,
+        const std::function<void(const Result&)>& t_OnResult)
+    {
+        using SharedImage = std::shared_ptr<const BmpImage>;
+
+        /**
+         * Each reference is decoded by the first thread, that needs it. Other threads wait for the same future.
+         * The entry is dropped after its last use, so only references of in-flight pairs are kept in memory.
+         */
+        struct ReferenceEntry {
+            std::optional<std::shared_future<SharedImage>> m_Image;
+            std::size_t m_RemainingUses{ 0 };
+        };
+
+        std::mutex referencesMutex;
+        std::unordered_map<std::string, ReferenceEntry> references;
+        for (const auto& pair : t_Pairs) {
+            references[pair.m_ReferencePath].m_RemainingUses++;
+        }
+
+        const auto acquireReference = [&](const std::string& t_Path) {
+            std::promise<SharedImage> promise;
+            std::shared_future<SharedImage> image;
+            {
+                std::lock_guard<std::mutex> lock(referencesMutex);
+                ReferenceEntry& entry = references.at(t_Path);
+                if (entry.m_Image) {
+                    return entry.m_Image->get();
+                }
+
+                entry.m_Image = promise.get_future().share();
+                image = *entry.m_Image;
+            }
+
+            try {
+                promise.set_value(std::make_shared<const BmpImage>(t_Path));
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+
+            return image.get();
+        };
+
+        const auto releaseReference = [&](const std::string& t_Path) {
+            std::lock_guard<std::mutex> lock(referencesMutex);
+            auto entryIt = references.find(t_Path);
+            if (--entryIt->second.m_RemainingUses == 0) {
+                references.erase(entryIt);
+            }
+        };
+
+        /* Results are reported in the manifest order: finished pairs wait, until all of the preceding ones are reported. */
+        std::mutex resultsMutex;
+        std::vector<std::optional<Result>> pendingResults(t_Pairs.size());
+        std::size_t nextToReport{ 0 };
+
+        const auto reportResult = [&](Result&& t_Result) {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            pendingResults[t_Result.m_Index] = std::move(t_Result);
+
+            while (nextToReport < pendingResults.size() && pendingResults[nextToReport]) {
+                t_OnResult(*pendingResults[nextToReport]);
+                pendingResults[nextToReport].reset();
+                nextToReport++;
+            }
+        };
+
+        const uint32_t totalThreads = (t_ThreadsCount == 0) ? std::max<uint32_t>(std::thread::hardware_concurrency(), 1) : t_ThreadsCount;
+        const std::size_t threadsCount = std::clamp<std::size_t>(totalThreads, 1, std::max<std::size_t>(t_Pairs.size(), 1));
+
+        /**
+         * Pairs are already processed in parallel, so metrics of each pair get only the threads, that the pool doesn't use
+         * (a single one, unless there are fewer pairs, than threads). Otherwise every pair would spawn its own row-band threads.
+         */
+        Consts metricsParams = Consts::Instance();
+        metricsParams.UpdateThreadsCount(static_cast<uint16_t>(std::clamp<std::size_t>(totalThreads / threadsCount, 1, std::numeric_limits<uint16_t>::max())));
+
+        std::atomic<std::size_t> nextPair{ 0 };
+        auto worker = [&]() {
+            Consts::ThreadOverride paramsOverride(metricsParams);
+
+            for (std::size_t pairIdx = nextPair++; pairIdx < t_Pairs.size(); pairIdx = nextPair++) {
+                const Pair& pair = t_Pairs[pairIdx];
+                Result result;
+                result.m_Index = pairIdx;
+                result.m_ReferencePath = pair.m_ReferencePath;
+                result.m_TestPath = pair.m_TestPath;
+
+                try {
+                    const SharedImage reference = acquireReference(pair.m_ReferencePath);
+                    const BmpImage test(pair.m_TestPath);
+
+                    result.m_Psnr = ImageQuality::CalculatePSNR(*reference, test);
+                    result.m_Ssim = ImageQuality::CalculateSSIM(*reference, test, t_Window);
+                }
+                catch (const std::exception& ex) {
+                    result.m_Psnr = result.m_Ssim = std::numeric_limits<double>::quiet_NaN();
+                    result.m_Error = ex.what();
+                }
+
+                releaseReference(pair.m_ReferencePath);
+                reportResult(std::move(result));
+            }
+        };
+
+        if (threadsCount == 1) {
+            worker();
+        }
+        else {
+            std::vector<std::thread> threadpool;
+            for (std::size_t threadIdx = 0; threadIdx < threadsCount; ++threadIdx) {
+                threadpool.emplace_back(worker);
+            }
+
+            for (auto& th : threadpool) {
+                th.join();
+            }
+        }
+    }
+
+    std::size_t QualityBatch::Run(const std::vector<Pair>& t_Pairs, ImageQuality::SsimWindow t_Window, OutputFormat t_Format, std::ostream& t_Output, uint32_t t_ThreadsCount)
+    {
+        if (t_Format == OutputFormat::CSV) {
+            t_Output << "reference,test,psnr,ssim,error\n";
+        }
+
+        std::size_t failedPairs{ 0 };
+        Evaluate(t_Pairs, t_Window, t_ThreadsCount, [&](const Result& t_Result) {
+            failedPairs += t_Result.m_Error.empty() ? 0 : 1;
+            WriteResult(t_Output, t_Result, t_Format);
+        });
+
+        t_Output.flush();
+
+        return failedPairs;
+    }
+
+    void QualityBatch::WriteResult(std::ostream& t_Output, const Result& t_Result, OutputFormat t_Format)
+    {
+        std::ostringstream line;
+        line << std::setprecision(10);
+
+        if (t_Format == OutputFormat::CSV) {
+            line << EscapeCsv(t_Result.m_ReferencePath) << ',' << EscapeCsv(t_Result.m_TestPath) << ',';
+            if (t_Result.m_Error.empty()) {
+                line << t_Result.m_Psnr << ',' << t_Result.m_Ssim << ',';
+            }
+            else {
+                line << ",," << EscapeCsv(t_Result.m_Error);
+            }
+        }
+        else {
+            const auto writeNumber = [&line](double t_Value) {
+                if (std::isfinite(t_Value)) {
+                    line << t_Value;
+                }
+                else {
+                    line << "null";
+                }
+            };
+
+            line << "{\"reference\":\"" << EscapeJson(t_Result.m_ReferencePath) << "\",\"test\":\"" << EscapeJson(t_Result.m_TestPath) << "\",\"psnr\":";
+            writeNumber(t_Result.m_Psnr);
+            line << ",\"ssim\":";
+            writeNumber(t_Result.m_Ssim);
+            if (!t_Result.m_Error.empty()) {
+                line << ",\"error\":\"" << EscapeJson(t_Result.m_Error) << '"';
+            }
+            line << '}';
+        }
+
+        line << '\n';
+        t_Output << line.str();
+    }
+
+    std::string QualityBatch::EscapeCsv(const std::string& t_Field)
+    {
+        if (t_Field.find_first_of(",\"\r\n") == std::string::npos) {
+            return t_Field;
+        }
+
+        std::string escaped{ "\"" };
+        for (char symbol : t_Field) {
+            escaped += (symbol == '"') ? "\"\"" : std::string(1, symbol);
+        }
+
+        return escaped + "\"";
+    }
+
+    std::string QualityBatch::EscapeJson(const std::string& t_String)
+    {
+        std::ostringstream escaped;
+
+        for (unsigned char symbol : t_String) {
+            if (symbol == '"' || symbol == '\\') {
+                escaped << '\\' << symbol;
+            }
+            else if (symbol < 0x20) {
+                escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<uint32_t>(symbol) << std::dec;
+            }
+            else {
+                escaped << symbol;
+            }
+        }
+
+        return escaped.str();
+    }
+}
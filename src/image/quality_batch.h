@@ -0,0 +1,97 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image/image_quality.h"
+
+namespace rdh {
+    /**
+     * @brief Calculates PSNR and SSIM for many (reference, test) image pairs at once.
+     */
+    class QualityBatch {
+    public:
+        /**
+         * @brief Format of the results stream.
+         */
+        enum class OutputFormat {
+            /* Header line, then one comma-separated line per pair. */
+            CSV,
+            /* One JSON object per line (JSON Lines), non-finite values are written as null. */
+            JSON
+        };
+
+        /**
+         * @brief Pair of images to compare.
+         */
+        struct Pair {
+            std::string m_ReferencePath;
+            std::string m_TestPath;
+        };
+
+        /**
+         * @brief Quality metrics for a single pair.
+         */
+        struct Result {
+            std::size_t m_Index{ 0 };
+            std::string m_ReferencePath;
+            std::string m_TestPath;
+            double m_Psnr{ 0 };
+            double m_Ssim{ 0 };
+            /* Empty, if the metrics were calculated successfully. */
+            std::string m_Error;
+        };
+
+        /**
+         * @brief Parses manifest: each line holds reference and test image paths separated by comma or tab.
+         * Empty lines and lines starting with '#' are skipped. Relative paths are resolved against t_BaseDir.
+         * @param t_Manifest manifest stream.
+         * @param t_BaseDir directory, that relative paths are relative to.
+         * @return pairs in the manifest order.
+         * @throw std::invalid_argument if some line doesn't contain exactly two paths.
+         */
+        static std::vector<Pair> ParseManifest(std::istream& t_Manifest, const std::filesystem::path& t_BaseDir = {});
+
+        /**
+         * @brief Calculates PSNR and SSIM for every pair using a pool of threads. Every reference image is decoded
+         * once, and released as soon as the last pair, that uses it, is processed.
+         * Pairs, that fail (e.g. image can't be loaded), get a non-empty Result::m_Error, and don't stop the batch.
+         * @param t_Pairs pairs to compare.
+         * @param t_Window SSIM window.
+         * @param t_ThreadsCount total number of threads, shared by the pool and the metrics of each pair (0 means hardware concurrency).
+         * @param t_OnResult called for each pair in the manifest order (never concurrently), as soon as the pair and all of the preceding ones are processed.
+         */
+        static void Evaluate(const std::vector<Pair>& t_Pairs, ImageQuality::SsimWindow t_Window, uint32_t t_ThreadsCount,
+            const std::function<void(const Result&)>& t_OnResult);
+
+        /**
+         * @brief Evaluates all pairs and streams results into t_Output.
+         * @param t_Pairs pairs to compare.
+         * @param t_Window SSIM window.
+         * @param t_Format output format.
+         * @param t_Output stream to write results to.
+         * @param t_ThreadsCount number of threads (0 means hardware concurrency).
+         * @return number of pairs, that failed.
+         */
+        static std::size_t Run(const std::vector<Pair>& t_Pairs, ImageQuality::SsimWindow t_Window, OutputFormat t_Format, std::ostream& t_Output, uint32_t t_ThreadsCount = 0);
+
+    private:
+        /**
+         * @brief Writes a single result in the given format (without the CSV header).
+         */
+        static void WriteResult(std::ostream& t_Output, const Result& t_Result, OutputFormat t_Format);
+
+        /**
+         * @brief Quotes CSV field, if it contains separators, quotes or line breaks.
+         */
+        static std::string EscapeCsv(const std::string& t_Field);
+
+        /**
+         * @brief Escapes string to be used inside of JSON string literal.
+         */
+        static std::string EscapeJson(const std::string& t_String);
+    };
+}
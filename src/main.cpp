@@ -1,4 +1,5 @@
 ﻿#include <iostream>
+#include <optional>
 #include <string>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
@@ -9,6 +10,7 @@
 #include "image/bmp_image.h"
 #include "options.h"
 #include "logging.h"
+#include "memory_stats.h"
 
 namespace po = boost::program_options;
 
@@ -24,7 +26,7 @@ int main(int argc, char* argv[])
         ("image-path", po::value<std::string>()->required(), "Path to the image to work with.")
         ("second-image", po::value<std::string>(), "Path to the second image (only used in calculate PSNR/SSIM).")
         ("result-path", po::value<std::string>(), "Path to save decrypted/encrypted image or image with embedded data.")
-        ("result-path-data", po::value<std::string>(), "Path to save extracted data from image to.")
+        ("result-path-data", po::value<std::string>(), "Path to save extracted data from image to (\"-\" writes data to the standard output).")
         ("mode", po::value<std::string>()->required(), "Specifies execution mode.\n"
             "Can be one of the follows:\n"
             "  show: \tDisplay image specified in --image-path.\n"
@@ -39,10 +41,17 @@ int main(int argc, char* argv[])
             "    Example-1 \t(image recovery mode): ./rdh.exe --mode extract --image-path ./marked-encrypted.bmp --result-path ./extracted.bmp --encryption-key AABBCC\n"
             "    Example-2 \t(image recovery and data extraction mode): ./rdh.exe --mode extract --image-path ./marked-encrypted.bmp --result-path ./extracted.bmp --result-path-data ./extracted.bin --encryption-key AABBCC --embed-key FFDDEE\n"
             "    Example-3 \t(data extraction mode): ./rdh.exe --mode extract --image-path ./marked-encrypted.bmp --result-path-data ./extracted.bin --embed-key FFDDEE\n"
+            "  preview: \tQuickly recovers half-resolution preview of the marked-encrypted image specified in --image-path using key provided in --encryption-key. "
+            "Only the top-left pixel of each 2x2 block is decrypted. Result will be saved in --result-path.\n"
+            "  discover: \tFinds embedding parameters (threshold, lsb-layers, lambda, alpha) of the image specified in --image-path, using key provided in --embed-key. "
+            "Only --lsb-hash-size should be known. Result will be printed to the console.\n"
             "  psnr: \tCalculates PSNR for images specified in --image-path and --second-image. "
             "Result will be printed to the console.\n"
             "  ssim: \tCalculates SSIM for images specified in --image-path and --second-image. "
-            "Result will be printed to the console.\n")
+            "Result will be printed to the console.\n"
+            "  quality-batch: \tCalculates PSNR and SSIM for every pair of images in the manifest specified in --image-path. "
+            "Each manifest line holds reference and test image paths separated by comma or tab (relative paths are relative to the manifest). "
+            "Results are streamed to --result-path (or to the console) in --output-format.\n")
         ("encryption-key", po::value<std::string>(), "Image encryption/decryption key.\n"
             "  Example: --encryption-key AA00BB11CC22DD33EE\n")
         ("enc-key-file", po::value<std::string>(), "Image encryption/decryption key file (key should be in binary form). (can be used instead of encryption-key)\n"
@@ -63,6 +72,26 @@ int main(int argc, char* argv[])
             "  Example: --alpha 5")
         ("lsb-hash-size", po::value<uint16_t>()->default_value(rdh::Consts::Instance().GetLsbHashSize()), "Length of hash for each group.\n"
             "  Example: --lsb-hash-size 3")
+        ("framed-payload", po::bool_switch()->default_value(false), "Prepend embedded data with its length and checksum, "
+            "so that only the real payload is extracted (without padding). Should be set both for embedding and extraction.\n"
+            "  Example: --framed-payload")
+        ("tile-size", po::value<uint16_t>()->default_value(rdh::Consts::Instance().GetTileSize()), "Split image into independent tiles of this size (in pixels), "
+            "that are embedded/extracted concurrently. Each tile holds its own framed chunk of data. 0 disables tiling. Should be set both for embedding and extraction.\n"
+            "  Example: --tile-size 256")
+        ("threads", po::value<uint16_t>()->default_value(0), "Maximum number of threads to use (for tiles, image recovery, key and parameter search, quality-batch). "
+            "0 means all of the hardware threads.\n"
+            "  Example: --threads 4")
+        ("adaptive-huffman", po::bool_switch()->default_value(false), "Build Huffman code for RLC-compressed blocks from the image itself, "
+            "and save it in the embedded bitstream (the default code is kept, if it allows to embed more data). Should be set both for embedding and extraction.\n"
+            "  Example: --adaptive-huffman")
+        ("ssim-window", po::value<std::string>()->default_value("2x2"), "Window, over which local statistics are calculated in SSIM mode. "
+            "Can be one of: 2x2 (non-overlapping blocks), 8x8 (sliding box window), 11x11 (sliding Gaussian window).\n"
+            "  Example: --ssim-window 11x11")
+        ("output-format", po::value<std::string>()->default_value("csv"), "Results format in quality-batch mode: csv, or json (one object per line).\n"
+            "  Example: --output-format json")
+        ("memory-stats", po::bool_switch()->default_value(false), "Print number of allocations, allocated bytes, peak heap size and peak RSS of the run to stderr. "
+            "Allocations are only counted, if the tool was built with ENABLE_ALLOCATION_STATS.\n"
+            "  Example: --memory-stats")
         ("log-level", po::value<boost::log::trivial::severity_level>()->default_value(boost::log::trivial::severity_level::fatal), 
             "Log level\n"
             "  Example: --log-level [trace, debug, info, warning, error, fatal]\n");
@@ -125,6 +154,18 @@ int main(int argc, char* argv[])
 
         rdh::Consts::Instance().UpdateLambda(vm["lambda"].as<uint16_t>());
         rdh::Consts::Instance().UpdateLsbHashSize(vm["lsb-hash-size"].as<uint16_t>());
+        rdh::Consts::Instance().UpdateFramedPayload(vm["framed-payload"].as<bool>());
+        rdh::Consts::Instance().UpdateAdaptiveHuffman(vm["adaptive-huffman"].as<bool>());
+        rdh::Consts::Instance().UpdateThreadsCount(vm["threads"].as<uint16_t>());
+
+        if (vm["tile-size"].as<uint16_t>() % 2 != 0) {
+            std::cout << "Tile size should be divisible by 2!" << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+        else {
+            rdh::Consts::Instance().UpdateTileSize(vm["tile-size"].as<uint16_t>());
+        }
     }
     catch (po::required_option&) {
         std::cout << "Missing one ore more required option!" << std::endl;
@@ -137,6 +178,12 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    /* Reported when main returns. */
+    std::optional<rdh::ScopedMemoryReport> memoryReport;
+    if (vm["memory-stats"].as<bool>()) {
+        memoryReport.emplace(std::cerr);
+    }
+
     try {
         if (mode == "show") {
             return rdh::Options::HandleShow(imagePath, vm, desc);
@@ -153,6 +200,12 @@ int main(int argc, char* argv[])
         else if (mode == "extract") {
             return rdh::Options::HandleExtractAndRecover(imagePath, vm, desc);
         }
+        else if (mode == "preview") {
+            return rdh::Options::HandlePreview(imagePath, vm, desc);
+        }
+        else if (mode == "discover") {
+            return rdh::Options::HandleDiscoverParameters(imagePath, vm, desc);
+        }
         else if (mode == "psnr") {
             if (vm.count("second-image") == 0) {
                 std::cout << "You must path (--second-image) to the second image." << std::endl;
@@ -171,6 +224,9 @@ int main(int argc, char* argv[])
 
             return rdh::Options::HandleCalculateSsim(imagePath, vm["second-image"].as<std::string>(), vm, desc);
         }
+        else if (mode == "quality-batch") {
+            return rdh::Options::HandleQualityBatch(imagePath, vm, desc);
+        }
         else {
             std::cout << "Incorrect operation mode selected!" << std::endl;
             std::cout << "Run " << argv[0] << " --help, to check available options" << std::endl;
@@ -0,0 +1,169 @@
+#include "memory_stats.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace rdh {
+    std::atomic<bool> MemoryStats::s_HooksInstalled{ false };
+    std::atomic<uint64_t> MemoryStats::s_AllocationsCount{ 0 };
+    std::atomic<uint64_t> MemoryStats::s_AllocatedBytes{ 0 };
+    std::atomic<uint64_t> MemoryStats::s_HeapBytes{ 0 };
+    std::atomic<uint64_t> MemoryStats::s_PeakHeapBytes{ 0 };
+    thread_local uint64_t MemoryStats::s_ThreadAllocationsCount{ 0 };
+    thread_local uint64_t MemoryStats::s_ThreadAllocatedBytes{ 0 };
+
+    AllocationCounters MemoryStats::GetAllocations()
+    {
+        return { s_AllocationsCount.load(std::memory_order_relaxed), s_AllocatedBytes.load(std::memory_order_relaxed) };
+    }
+
+    AllocationCounters MemoryStats::GetThreadAllocations()
+    {
+        return { s_ThreadAllocationsCount, s_ThreadAllocatedBytes };
+    }
+
+    void MemoryStats::RecordAllocation(std::size_t t_Bytes) noexcept
+    {
+        s_ThreadAllocationsCount++;
+        s_ThreadAllocatedBytes += t_Bytes;
+
+        s_AllocationsCount.fetch_add(1, std::memory_order_relaxed);
+        s_AllocatedBytes.fetch_add(t_Bytes, std::memory_order_relaxed);
+
+        const uint64_t heapBytes = s_HeapBytes.fetch_add(t_Bytes, std::memory_order_relaxed) + t_Bytes;
+        uint64_t peakHeapBytes = s_PeakHeapBytes.load(std::memory_order_relaxed);
+        while (heapBytes > peakHeapBytes && !s_PeakHeapBytes.compare_exchange_weak(peakHeapBytes, heapBytes, std::memory_order_relaxed)) {}
+    }
+
+    void MemoryStats::RecordDeallocation(std::size_t t_Bytes) noexcept
+    {
+        s_HeapBytes.fetch_sub(t_Bytes, std::memory_order_relaxed);
+    }
+
+    uint64_t MemoryStats::GetCurrentRss()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.WorkingSetSize;
+        }
+        return 0;
+#elif defined(__linux__)
+        /* Plain read(2), not streams: the sampler thread shouldn't allocate, so that it doesn't affect allocation counters. */
+        const int fd = open("/proc/self/statm", O_RDONLY);
+        if (fd < 0) {
+            return 0;
+        }
+
+        char buffer[128];
+        const ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length <= 0) {
+            return 0;
+        }
+        buffer[length] = '\0';
+
+        /* The second field is resident set size in pages. */
+        const char* pos = buffer;
+        while (*pos != '\0' && *pos != ' ') {
+            pos++;
+        }
+
+        uint64_t residentPages{ 0 };
+        for (pos++; *pos >= '0' && *pos <= '9'; ++pos) {
+            residentPages = residentPages * 10 + (*pos - '0');
+        }
+
+        return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    uint64_t MemoryStats::GetPeakRss()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#elif defined(__linux__)
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            /* In kilobytes on Linux. */
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+        }
+        return 0;
+#else
+        return 0;
+#endif
+    }
+
+    void MemoryStats::WriteReport(std::ostream& t_Out, const AllocationCounters& t_Allocations, uint64_t t_PeakHeapBytes, uint64_t t_PeakRss)
+    {
+        constexpr double c_MiB = 1024.0 * 1024.0;
+
+        t_Out << "Memory: ";
+        if (IsAllocationTrackingEnabled()) {
+            t_Out << t_Allocations.m_Count << " allocations, " << t_Allocations.m_Bytes / c_MiB << " MiB allocated, "
+                << t_PeakHeapBytes / c_MiB << " MiB peak heap, ";
+        }
+        else {
+            t_Out << "allocations aren't counted (build with ENABLE_ALLOCATION_STATS), ";
+        }
+        t_Out << t_PeakRss / c_MiB << " MiB peak RSS" << std::endl;
+    }
+
+    PeakRssSampler::PeakRssSampler(std::chrono::milliseconds t_Period)
+        : m_StartRss(MemoryStats::GetCurrentRss())
+        , m_PeakRss(m_StartRss)
+    {
+        m_Thread = std::thread([this, t_Period]() {
+            while (!m_Stop.load(std::memory_order_relaxed)) {
+                Sample();
+                std::this_thread::sleep_for(t_Period);
+            }
+        });
+    }
+
+    PeakRssSampler::~PeakRssSampler()
+    {
+        Stop();
+    }
+
+    void PeakRssSampler::Stop()
+    {
+        if (m_Thread.joinable()) {
+            m_Stop.store(true, std::memory_order_relaxed);
+            m_Thread.join();
+            Sample();
+        }
+    }
+
+    void PeakRssSampler::Sample()
+    {
+        const uint64_t rss = MemoryStats::GetCurrentRss();
+
+        uint64_t peakRss = m_PeakRss.load(std::memory_order_relaxed);
+        while (rss > peakRss && !m_PeakRss.compare_exchange_weak(peakRss, rss, std::memory_order_relaxed)) {}
+    }
+
+    ScopedMemoryReport::ScopedMemoryReport(std::ostream& t_Out)
+        : m_Out(t_Out)
+        , m_StartAllocations(MemoryStats::GetAllocations())
+    {
+    }
+
+    ScopedMemoryReport::~ScopedMemoryReport()
+    {
+        MemoryStats::WriteReport(m_Out, MemoryStats::GetAllocations() - m_StartAllocations, MemoryStats::GetPeakHeapBytes(), MemoryStats::GetPeakRss());
+    }
+}
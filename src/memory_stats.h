@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+namespace rdh {
+    /**
+     * @brief Heap allocations, made since some moment.
+    */
+    struct AllocationCounters {
+        uint64_t m_Count{ 0 };
+        uint64_t m_Bytes{ 0 };
+
+        AllocationCounters operator-(const AllocationCounters& t_Other) const
+        {
+            return { m_Count - t_Other.m_Count, m_Bytes - t_Other.m_Bytes };
+        }
+    };
+
+    /**
+     * @brief Process memory statistics. Allocation counters are only updated, if the counting operator new/delete
+     * (allocation_hooks.cpp) is linked into the executable (ENABLE_ALLOCATION_STATS for rdh and rdh_benchmark, always for tests).
+     * Resident set size is queried from the OS and is always available (on Linux and Windows, 0 otherwise).
+    */
+    class MemoryStats {
+    public:
+        /**
+         * @brief Checks whether allocations are being counted.
+        */
+        static bool IsAllocationTrackingEnabled() { return s_HooksInstalled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Allocations made by all threads since the start of the process.
+        */
+        static AllocationCounters GetAllocations();
+
+        /**
+         * @brief Allocations made by the calling thread since its start.
+         * Use it to measure single-threaded code, other threads (e.g. PeakRssSampler) don't affect it.
+        */
+        static AllocationCounters GetThreadAllocations();
+
+        /**
+         * @brief Bytes currently allocated on the heap by all threads (usable sizes of the blocks).
+        */
+        static uint64_t GetHeapBytes() { return s_HeapBytes.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Peak of GetHeapBytes since the start of the process, or since the last ResetPeakHeapBytes.
+        */
+        static uint64_t GetPeakHeapBytes() { return s_PeakHeapBytes.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Restarts peak tracking from the current heap size.
+        */
+        static void ResetPeakHeapBytes() { s_PeakHeapBytes.store(GetHeapBytes(), std::memory_order_relaxed); }
+
+        /**
+         * @brief Current resident set size of the process, in bytes.
+        */
+        static uint64_t GetCurrentRss();
+
+        /**
+         * @brief Peak resident set size of the process since its start, as reported by the OS, in bytes.
+        */
+        static uint64_t GetPeakRss();
+
+        /**
+         * @brief Writes a one-line report: allocations, allocated bytes, peak heap and peak RSS.
+         * @param t_Out where to write.
+         * @param t_Allocations allocations to report.
+         * @param t_PeakHeapBytes peak heap size to report.
+         * @param t_PeakRss peak RSS to report.
+        */
+        static void WriteReport(std::ostream& t_Out, const AllocationCounters& t_Allocations, uint64_t t_PeakHeapBytes, uint64_t t_PeakRss);
+
+        /**
+         * @brief Called by the counting operator new/delete. Shouldn't allocate.
+        */
+        static void OnHooksInstalled() noexcept { s_HooksInstalled.store(true, std::memory_order_relaxed); }
+        static void RecordAllocation(std::size_t t_Bytes) noexcept;
+        static void RecordDeallocation(std::size_t t_Bytes) noexcept;
+
+    private:
+        static std::atomic<bool> s_HooksInstalled;
+        static std::atomic<uint64_t> s_AllocationsCount;
+        static std::atomic<uint64_t> s_AllocatedBytes;
+        static std::atomic<uint64_t> s_HeapBytes;
+        static std::atomic<uint64_t> s_PeakHeapBytes;
+        static thread_local uint64_t s_ThreadAllocationsCount;
+        static thread_local uint64_t s_ThreadAllocatedBytes;
+    };
+
+    /**
+     * @brief Tracks peak resident set size between construction and Stop (or destruction), by polling it from a background thread.
+     * Unlike MemoryStats::GetPeakRss, works for any part of the process lifetime.
+    */
+    class PeakRssSampler {
+    public:
+        /**
+         * @brief Starts sampling.
+         * @param t_Period sampling period.
+        */
+        explicit PeakRssSampler(std::chrono::milliseconds t_Period = std::chrono::milliseconds(1));
+        ~PeakRssSampler();
+
+        PeakRssSampler(const PeakRssSampler&) = delete;
+        PeakRssSampler& operator=(const PeakRssSampler&) = delete;
+
+        /**
+         * @brief Stops sampling (takes the last sample). Can be called several times.
+        */
+        void Stop();
+
+        /**
+         * @brief RSS at the start of the sampling, in bytes.
+        */
+        uint64_t GetStartRss() const { return m_StartRss; }
+
+        /**
+         * @brief Biggest RSS sampled so far, in bytes.
+        */
+        uint64_t GetPeakRss() const { return m_PeakRss.load(std::memory_order_relaxed); }
+
+    private:
+        void Sample();
+
+        uint64_t m_StartRss{ 0 };
+        std::atomic<uint64_t> m_PeakRss{ 0 };
+        std::atomic<bool> m_Stop{ false };
+        std::thread m_Thread;
+    };
+
+    /**
+     * @brief Writes memory report of its lifetime to the stream on destruction: allocations (if they are counted),
+     * peak heap size and peak RSS of the process.
+    */
+    class ScopedMemoryReport {
+    public:
+        explicit ScopedMemoryReport(std::ostream& t_Out);
+        ~ScopedMemoryReport();
+
+        ScopedMemoryReport(const ScopedMemoryReport&) = delete;
+        ScopedMemoryReport& operator=(const ScopedMemoryReport&) = delete;
+
+    private:
+        std::ostream& m_Out;
+        AllocationCounters m_StartAllocations;
+    };
+}
@@ -3,10 +3,15 @@
 #include "utils.h"
 #include "encryptor/encryptor.h"
 #include "embedder/embedder.h"
+#include "embedder/params_grid.h"
 #include "extractor/extractor.h"
 #include "image/image_quality.h"
+#include "image/quality_batch.h"
 #include "image/bmp_image.h"
 
+#include <filesystem>
+#include <fstream>
+
 namespace rdh {
 
     uint32_t Options::HandleShow(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc)
@@ -83,9 +88,11 @@ namespace rdh {
             embedKey = rdh::utils::HexToBytes<uint8_t>(t_Vm["embed-key"].as<std::string>());
         }
 
-        Embedder::Embed(image, dataToEmbed, embedKey, std::nullopt, std::nullopt).Save(t_Vm["result-path"].as<std::string>());
+        EmbeddingDistortion distortion;
+        Embedder::Embed(image, dataToEmbed, embedKey, std::nullopt, std::nullopt, distortion).Save(t_Vm["result-path"].as<std::string>());
 
         std::cout << "Image with embedded data saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
+        std::cout << "Distortion of the encrypted image: MSE = " << distortion.GetMSE() << ", PSNR = " << distortion.GetPSNR() << std::endl;
 
         return 0;
     }
@@ -126,20 +133,23 @@ namespace rdh {
         Mode mode = Mode::NONE;
         rdh::BmpImage image(t_ImagePath);
 
+        /* Extracted data can be written to the standard output, so that messages go to stderr in this case. */
+        std::ostream& messages = (t_Vm.count("result-path-data") && t_Vm["result-path-data"].as<std::string>() == "-") ? std::cerr : std::cout;
+
         if ((t_Vm.count("embed-key") == 1 || t_Vm.count("embed-key-file") == 1) &&
             (t_Vm.count("encryption-key") == 1 || t_Vm.count("enc-key-file") == 1)) {
             mode = Mode::DATA_EXTRACT_IMAGE_RECOVERY;
-            std::cout << "Running in Image recovery + data extraction mode." << std::endl;
+            messages << "Running in Image recovery + data extraction mode." << std::endl;
 
             if (t_Vm.count("result-path") == 0) {
-                std::cout << "You must provide result path (--result-path), to write recovered image to." << std::endl;
-                std::cout << "Run with --help to read the docs" << std::endl;
+                messages << "You must provide result path (--result-path), to write recovered image to." << std::endl;
+                messages << "Run with --help to read the docs" << std::endl;
                 return 1;
             }
 
             if (t_Vm.count("result-path-data") == 0) {
-                std::cout << "You must provide result path data (--result-path-data), to write extracted data to." << std::endl;
-                std::cout << "Run with --help to read the docs" << std::endl;
+                messages << "You must provide result path data (--result-path-data), to write extracted data to." << std::endl;
+                messages << "Run with --help to read the docs" << std::endl;
                 return 1;
             }
 
@@ -161,15 +171,15 @@ namespace rdh {
 
             Extractor::RecoverImageAndExract(image, t_Vm["result-path"].as<std::string>(), t_Vm["result-path-data"].as<std::string>(), embedKey, decryptionKey);
 
-            std::cout << "Recovered image saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
-            std::cout << "Extracted data saved to: " << t_Vm["result-path-data"].as<std::string>() << std::endl;
+            messages << "Recovered image saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
+            messages << "Extracted data saved to: " << t_Vm["result-path-data"].as<std::string>() << std::endl;
         } else if (t_Vm.count("embed-key") == 1 || t_Vm.count("embed-key-file") == 1) {
             mode = Mode::DATA_EXTRACT;
-            std::cout << "Running in data extraction mode." << std::endl;
+            messages << "Running in data extraction mode." << std::endl;
 
             if (t_Vm.count("result-path-data") == 0) {
-                std::cout << "You must provide result path data (--result-path-data), to write extracted data to." << std::endl;
-                std::cout << "Run with --help to read the docs" << std::endl;
+                messages << "You must provide result path data (--result-path-data), to write extracted data to." << std::endl;
+                messages << "Run with --help to read the docs" << std::endl;
                 return 1;
             }
 
@@ -183,14 +193,14 @@ namespace rdh {
 
             Extractor::ExtractData(image, t_Vm["result-path-data"].as<std::string>(), embedKey);
 
-            std::cout << "Extracted data saved to: " << t_Vm["result-path-data"].as<std::string>() << std::endl;
+            messages << "Extracted data saved to: " << t_Vm["result-path-data"].as<std::string>() << std::endl;
         } else if (t_Vm.count("encryption-key") == 1 || t_Vm.count("enc-key-file") == 1) {
             mode = Mode::IMAGE_RECOVERY;
-            std::cout << "Running in Image recovery mode." << std::endl;
+            messages << "Running in Image recovery mode." << std::endl;
 
             if (t_Vm.count("result-path") == 0) {
-                std::cout << "You must provide result path (--result-path), to write recovered image to." << std::endl;
-                std::cout << "Run with --help to read the docs" << std::endl;
+                messages << "You must provide result path (--result-path), to write recovered image to." << std::endl;
+                messages << "Run with --help to read the docs" << std::endl;
                 return 1;
             }
 
@@ -204,14 +214,99 @@ namespace rdh {
 
             Extractor::RecoverImage(image, t_Vm["result-path"].as<std::string>(), decryptionKey);;
 
-            std::cout << "Recovered image saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
+            messages << "Recovered image saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
         }
         else {
-            std::cout << "You must provide one of these keys: embed-key, encryption-key. Or both." << std::endl;
+            messages << "You must provide one of these keys: embed-key, encryption-key. Or both." << std::endl;
+            messages << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    uint32_t Options::HandlePreview(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc)
+    {
+        if (t_Vm.count("encryption-key") == 0 && t_Vm.count("enc-key-file") == 0) {
+            std::cout << "You must provide decryption key via argument (--encryption-key), or use decryption key file (--enc-key-file)!" << std::endl;
             std::cout << "Run with --help to read the docs" << std::endl;
             return 1;
         }
 
+        if (t_Vm.count("result-path") == 0) {
+            std::cout << "You must provide result path (--result-path), to write preview image to." << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+
+        std::vector<uint8_t> decryptionKey;
+        rdh::BmpImage image(t_ImagePath);
+
+        if (t_Vm.count("enc-key-file")) {
+            decryptionKey = utils::LoadFileData<uint8_t>(t_Vm["enc-key-file"].as<std::string>());
+        }
+        else {
+            decryptionKey = rdh::utils::HexToBytes<uint8_t>(t_Vm["encryption-key"].as<std::string>());
+        }
+
+        Extractor::RecoverPreview(image, t_Vm["result-path"].as<std::string>(), decryptionKey);
+
+        std::cout << "Preview image saved to: " << t_Vm["result-path"].as<std::string>() << std::endl;
+
+        return 0;
+    }
+
+    uint32_t Options::HandleDiscoverParameters(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc)
+    {
+        if (t_Vm.count("embed-key") == 0 && t_Vm.count("embed-key-file") == 0) {
+            std::cout << "You must provide data embedding key via argument (--embed-key), or use embed key file (--embed-key-file)!" << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+
+        std::vector<uint8_t> embedKey;
+        rdh::BmpImage image(t_ImagePath);
+
+        if (t_Vm.count("embed-key-file")) {
+            embedKey = utils::LoadFileData<uint8_t>(t_Vm["embed-key-file"].as<std::string>());
+        }
+        else {
+            embedKey = rdh::utils::HexToBytes<uint8_t>(t_Vm["embed-key"].as<std::string>());
+        }
+
+        /**
+         * Candidate parameter sets: the same grid, that is used in benchmarks.
+         * All of the other parameters (--lsb-hash-size, --adaptive-huffman, ...) are taken from the command line.
+         * Sets with the same lambda and lsb layers go one after another, so that their raw bitstream is released early.
+         */
+        std::vector<Consts> candidateParams;
+        for (uint16_t lambda : consts::grid::c_Lambdas) {
+            for (uint16_t lsbLayers : consts::grid::c_LsbLayers) {
+                for (uint16_t threshold : consts::grid::c_Thresholds) {
+                    for (uint16_t alpha : consts::grid::c_Alphas) {
+                        Consts params = Consts::Instance();
+                        params.UpdateThreshold(threshold);
+                        params.UpdateLsbLayers(lsbLayers);
+                        params.UpdateLambda(lambda);
+                        params.UpdateAlpha(alpha);
+                        candidateParams.push_back(params);
+                    }
+                }
+            }
+        }
+
+        std::optional<Consts> discoveredParams = Extractor::DiscoverParameters(image, embedKey, candidateParams);
+        if (!discoveredParams) {
+            std::cout << "None of " << candidateParams.size() << " parameter sets matches the image and the embedding key." << std::endl;
+            return 1;
+        }
+
+        std::cout << "Discovered parameters: --threshold " << discoveredParams->GetThreshold()
+            << " --lsb-layers " << discoveredParams->GetLsbLayers()
+            << " --lambda " << discoveredParams->GetLambda()
+            << " --alpha " << discoveredParams->GetAlpha()
+            << " --lsb-hash-size " << discoveredParams->GetLsbHashSize() << std::endl;
+
         return 0;
     }
 
@@ -228,12 +323,80 @@ namespace rdh {
 
     uint32_t Options::HandleCalculateSsim(const std::string& t_ImagePath1, const std::string& t_ImagePath2, po::variables_map& t_Vm, po::options_description& t_Desc)
     {        
+        std::optional<ImageQuality::SsimWindow> window = ParseSsimWindow(t_Vm);
+        if (!window) {
+            std::cout << "Unknown SSIM window (--ssim-window): " << t_Vm["ssim-window"].as<std::string>() << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+
         rdh::BmpImage image1(t_ImagePath1);
         rdh::BmpImage image2(t_ImagePath2);
 
         std::cout << "SSIM for image \"" << t_ImagePath1 << "\" and \"" << t_ImagePath2 << "\"." << std::endl;
-        std::cout << "SSIM = " << rdh::ImageQuality::CalculateSSIM(image1, image2) << std::endl;
+        std::cout << "SSIM = " << rdh::ImageQuality::CalculateSSIM(image1, image2, *window) << std::endl;
 
         return 0;
     }
+
+    uint32_t Options::HandleQualityBatch(const std::string& t_ManifestPath, po::variables_map& t_Vm, po::options_description& t_Desc)
+    {
+        std::optional<ImageQuality::SsimWindow> window = ParseSsimWindow(t_Vm);
+        if (!window) {
+            std::cout << "Unknown SSIM window (--ssim-window): " << t_Vm["ssim-window"].as<std::string>() << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+
+        const std::string formatName = t_Vm["output-format"].as<std::string>();
+        if (formatName != "csv" && formatName != "json") {
+            std::cout << "Unknown output format (--output-format): " << formatName << std::endl;
+            std::cout << "Run with --help to read the docs" << std::endl;
+            return 1;
+        }
+        const QualityBatch::OutputFormat format = (formatName == "csv") ? QualityBatch::OutputFormat::CSV : QualityBatch::OutputFormat::JSON;
+
+        std::ifstream manifest(t_ManifestPath);
+        if (!manifest) {
+            std::cout << "Can't open manifest file: " << t_ManifestPath << std::endl;
+            return 1;
+        }
+
+        /* Relative image paths are relative to the manifest itself. */
+        const std::vector<QualityBatch::Pair> pairs = QualityBatch::ParseManifest(manifest, std::filesystem::path(t_ManifestPath).parent_path());
+
+        std::size_t failedPairs{ 0 };
+        if (t_Vm.count("result-path")) {
+            std::ofstream output(t_Vm["result-path"].as<std::string>());
+            if (!output) {
+                std::cout << "Can't open result file: " << t_Vm["result-path"].as<std::string>() << std::endl;
+                return 1;
+            }
+
+            failedPairs = QualityBatch::Run(pairs, *window, format, output, Consts::Instance().GetThreadsCount());
+            std::cout << "Evaluated " << pairs.size() - failedPairs << " of " << pairs.size() << " pairs." << std::endl;
+        }
+        else {
+            failedPairs = QualityBatch::Run(pairs, *window, format, std::cout, Consts::Instance().GetThreadsCount());
+        }
+
+        return (failedPairs == 0) ? 0 : 1;
+    }
+
+    std::optional<ImageQuality::SsimWindow> Options::ParseSsimWindow(po::variables_map& t_Vm)
+    {
+        const std::string windowName = t_Vm["ssim-window"].as<std::string>();
+
+        if (windowName == "2x2") {
+            return ImageQuality::SsimWindow::Block2x2;
+        }
+        else if (windowName == "8x8") {
+            return ImageQuality::SsimWindow::Box8x8;
+        }
+        else if (windowName == "11x11") {
+            return ImageQuality::SsimWindow::Gaussian11x11;
+        }
+
+        return std::nullopt;
+    }
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 #include <string>
 #include <iostream>
+#include <optional>
 #include <boost/program_options.hpp>
 
+#include "image/image_quality.h"
+
 namespace rdh {
     /**
      * @brief Class that wraps handlers for all command line options.
@@ -57,6 +60,24 @@ namespace rdh {
         */
         static uint32_t HandleExtractAndRecover(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc);
 
+        /**
+         * @brief Handles preview command
+         * @param t_ImagePath path to an image
+         * @param t_Vm boost variables map
+         * @param t_Desc boost options description
+         * @return 0 if everything is OK, non-zero otherwise
+        */
+        static uint32_t HandlePreview(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc);
+
+        /**
+         * @brief Handles discover command
+         * @param t_ImagePath path to an image
+         * @param t_Vm boost variables map
+         * @param t_Desc boost options description
+         * @return 0 if everything is OK, non-zero otherwise
+        */
+        static uint32_t HandleDiscoverParameters(const std::string& t_ImagePath, po::variables_map& t_Vm, po::options_description& t_Desc);
+
         /**
          * @brief Handles "calculate PSNR" command.
          * @param t_ImagePath1 path to the first image.
@@ -76,7 +97,23 @@ namespace rdh {
          * @return 0 if everything is OK, non-zero otherwise
         */
         static uint32_t HandleCalculateSsim(const std::string& t_ImagePath1, const std::string& t_ImagePath2, po::variables_map& t_Vm, po::options_description& t_Desc);
+
+        /**
+         * @brief Handles "quality batch" command.
+         * @param t_ManifestPath path to the manifest with (reference, test) image pairs.
+         * @param t_Vm boost variables map
+         * @param t_Desc boost options description
+         * @return 0 if every pair was evaluated, non-zero otherwise
+        */
+        static uint32_t HandleQualityBatch(const std::string& t_ManifestPath, po::variables_map& t_Vm, po::options_description& t_Desc);
     private:
+        /**
+         * @brief Parses --ssim-window option.
+         * @param t_Vm boost variables map
+         * @return SSIM window, or std::nullopt if the window name is unknown
+        */
+        static std::optional<ImageQuality::SsimWindow> ParseSsimWindow(po::variables_map& t_Vm);
+
         /**
          * @brief Extraction modes for extractor module.
         */
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+
+namespace rdh {
+    /**
+     * @brief Receives begin/end notifications of the embedding and extraction phases (e.g. to read hardware counters).
+     * Notifications come from the thread, that runs the phase, phases of different threads can overlap.
+    */
+    class PhaseListener {
+    public:
+        virtual ~PhaseListener() = default;
+
+        virtual void OnPhaseBegin(const char* t_Phase) = 0;
+        virtual void OnPhaseEnd(const char* t_Phase) = 0;
+    };
+
+    /**
+     * @brief Marks a coarse phase of the embedder/extractor (the whole scope). Without a listener it costs a single atomic load,
+     * so phases shouldn't be placed inside per-block or per-group loops.
+    */
+    class PhaseScope {
+    public:
+        explicit PhaseScope(const char* t_Phase)
+            : m_Phase(t_Phase), m_Listener(s_Listener.load(std::memory_order_acquire))
+        {
+            if (m_Listener != nullptr) {
+                m_Listener->OnPhaseBegin(m_Phase);
+            }
+        }
+
+        ~PhaseScope()
+        {
+            End();
+        }
+
+        /**
+         * @brief Ends the phase before the end of the scope (e.g. after a loop). Does nothing, if the phase has already ended.
+        */
+        void End()
+        {
+            if (m_Listener != nullptr) {
+                m_Listener->OnPhaseEnd(m_Phase);
+                m_Listener = nullptr;
+            }
+        }
+
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+        /**
+         * @brief Sets the listener of all of the phases (nullptr to remove it). Should outlive the phases, that are running.
+        */
+        static void SetListener(PhaseListener* t_Listener) { s_Listener.store(t_Listener, std::memory_order_release); }
+
+    private:
+        const char* m_Phase;
+        PhaseListener* m_Listener;
+
+        static inline std::atomic<PhaseListener*> s_Listener{ nullptr };
+    };
+}
@@ -1,12 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <fstream>
+#include <iostream>
 #include <random>
 #include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 #include <bitset>
 #include <cmath>
 
 #include <boost/compute/detail/sha1.hpp>
+#include <boost/crc.hpp>
 
 #include "Eigen/Dense"
 
@@ -68,6 +80,20 @@ namespace rdh {
             sha1.get_digest(reinterpret_cast<uint32_t(&)[5]>(t_Hash[0]));
         }
 
+        /**
+         * @brief Calculates CRC-32 checksum for provided t_Data.
+         * @tparam T any type of collection, that provides data and size functions.
+         * @param t_Data data to calculate checksum from.
+         * @return calculated checksum.
+         */
+        template<typename T>
+        uint32_t CalculateCRC32(const T& t_Data)
+        {
+            boost::crc_32_type crc32;
+            crc32.process_bytes(t_Data.data(), t_Data.size());
+            return crc32.checksum();
+        }
+
         /**
          * @brief Shuffles user given collection using Fisher-Yates algorithm.
          * @tparam T type of collection. The collection should provide rbegin, rend, size functions.
@@ -133,22 +159,43 @@ namespace rdh {
             return ret;
         }
 
+        /**
+         * @brief Decodes hex string into bytes. Each character is decoded arithmetically, without branches or
+         * per-byte allocations, and validity of all characters is checked once after the loop, so the loop can be vectorized.
+         * @tparam T byte type
+         * @param t_Hex hex string (upper or lower case)
+         * @return decoded bytes
+         * @throw std::invalid_argument if the string has odd length, or contains non-hex characters.
+        */
         template<typename T>
-        std::vector<T> HexToBytes(const std::string& t_Hex)
+        std::vector<T> HexToBytes(std::string_view t_Hex)
         {
             if (t_Hex.length() % 2 != 0) {
                 throw std::invalid_argument("Hex string length should be multiple of 2!");
             }
 
-            std::vector<T> bytes;
+            std::vector<T> bytes(t_Hex.length() / 2);
 
-            for (uint32_t i = 0; i < t_Hex.length(); i += 2) {
-                std::string byteStr = t_Hex.substr(i, 2);
-                if (byteStr.find_first_not_of("0123456789ABCDEFabcdef") != std::string::npos) {
-                    throw std::invalid_argument("Incorrect hex string!");
-                }
-                T byte = static_cast<T>(strtol(byteStr.c_str(), NULL, 16));
-                bytes.push_back(byte);
+            const auto decodeNibble = [](uint8_t t_Char) {
+                /* '0'-'9' -> 0-9, 'A'-'F' and 'a'-'f' -> 10-15 (bit 6 is set only for letters). */
+                return static_cast<uint8_t>((t_Char & 0xf) + 9 * (t_Char >> 6));
+            };
+
+            const auto isHexChar = [](uint8_t t_Char) {
+                return static_cast<uint8_t>(static_cast<uint8_t>(t_Char - '0') < 10) | static_cast<uint8_t>(static_cast<uint8_t>((t_Char | 0x20) - 'a') < 6);
+            };
+
+            uint8_t allCharsValid{ 1 };
+            for (std::size_t byteIdx = 0; byteIdx < bytes.size(); ++byteIdx) {
+                const uint8_t highChar = static_cast<uint8_t>(t_Hex[2 * byteIdx]);
+                const uint8_t lowChar = static_cast<uint8_t>(t_Hex[2 * byteIdx + 1]);
+
+                allCharsValid &= isHexChar(highChar) & isHexChar(lowChar);
+                bytes[byteIdx] = static_cast<T>((decodeNibble(highChar) << 4) | decodeNibble(lowChar));
+            }
+
+            if (!allCharsValid) {
+                throw std::invalid_argument("Incorrect hex string!");
             }
 
             return bytes;
@@ -229,36 +276,49 @@ namespace rdh {
             return ~((1 << t_Nbits) - 1) & t_Num;
         }
 
+        /**
+         * @brief Loads the whole file. Size is queried once, and the data is read with a single call,
+         * straight into the resulting buffer. Non-seekable files (e.g. pipes) are read in chunks.
+         * @tparam T byte type
+         * @param t_Filename path to the file
+         * @return file contents
+         * @throw std::runtime_error if the file can't be opened or read.
+        */
         template<typename T>
         std::vector<T> LoadFileData(const std::string& t_Filename)
         {
-            // open the file:
+            static_assert(sizeof(T) == 1, "File data can only be loaded into a vector of bytes");
+
             std::ifstream file(t_Filename, std::ios::binary);
 
             if (!file.is_open()) {
                 throw std::runtime_error("Specified file " + t_Filename + " doesn't exist!");
             }
 
-            // Stop eating new lines in binary mode!!!
-            file.unsetf(std::ios::skipws);
-
-            // get its size:
-            std::streampos fileSize;
-
-            file.seekg(0, std::ios::end);
-            fileSize = file.tellg();
-            file.seekg(0, std::ios::beg);
-
-            // reserve capacity
             std::vector<T> bytes;
-            bytes.reserve(fileSize);
+            file.seekg(0, std::ios::end);
+            const std::streamoff fileSize = file.tellg();
 
-            // read the data:
-            bytes.insert(bytes.begin(),
-                std::istream_iterator<T>(file),
-                std::istream_iterator<T>());
+            if (fileSize >= 0) {
+                bytes.resize(static_cast<std::size_t>(fileSize));
+                file.seekg(0, std::ios::beg);
+                if (!file.read(reinterpret_cast<char*>(bytes.data()), fileSize)) {
+                    throw std::runtime_error("Error, while reading file: " + t_Filename);
+                }
+            }
+            else {
+                file.clear();
+
+                constexpr std::size_t c_ChunkSize{ 1 << 16 };
+                while (file) {
+                    const std::size_t oldSize = bytes.size();
+                    bytes.resize(oldSize + c_ChunkSize);
+                    file.read(reinterpret_cast<char*>(bytes.data() + oldSize), c_ChunkSize);
+                    bytes.resize(oldSize + static_cast<std::size_t>(file.gcount()));
+                }
+            }
 
-            return std::move(bytes);
+            return bytes;
         }
 
         template<typename T>
@@ -274,42 +334,192 @@ namespace rdh {
             outFile.write((char*)t_Data.data(), t_Data.size());
         }
 
-        template<typename T>
-        void SaveBitstreamToFile(const std::string& t_Filename, const std::string::iterator& t_SliceBegin, const std::string::iterator& t_SliceEnd)
+        /**
+         * @brief Packs "binary" string (consists of '0' and '1') into bytes, the first bit goes into the MSB.
+         * Last byte is padded with zeroes. Full bytes are packed 8 characters at a time without branches.
+         * @param t_Bits bits to pack.
+         * @param t_Packed [out] where to write ceil(t_Bits.size() / 8) packed bytes.
+        */
+        inline void PackBits(std::string_view t_Bits, uint8_t* t_Packed)
         {
-            std::vector<T> dataToWrite;
-            dataToWrite.reserve(std::abs(std::distance(t_SliceBegin, t_SliceEnd)) / 8);
-
-            std::string::iterator sliceBegin = t_SliceBegin;
-            std::string::iterator sliceEnd = t_SliceBegin;
-
-            std::string currByte = std::string(
-                sliceBegin,
-                Advance(sliceEnd, t_SliceEnd, 8)
-            );
-            if (currByte.size() < 8) {
-                currByte += std::string(8 - currByte.size(), '0');
+            const std::size_t fullBytes = t_Bits.size() / 8;
+
+            for (std::size_t byteIdx = 0; byteIdx < fullBytes; ++byteIdx) {
+                if constexpr (std::endian::native == std::endian::little) {
+                    /**
+                     * '0' and '1' differ only in the lowest bit. Multiplication gathers the lowest bits of all
+                     * 8 characters into the top byte, the first character becomes the MSB.
+                     */
+                    uint64_t chars;
+                    std::memcpy(&chars, t_Bits.data() + 8 * byteIdx, sizeof(chars));
+                    t_Packed[byteIdx] = static_cast<uint8_t>(((chars & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56);
+                }
+                else {
+                    uint8_t byte{ 0 };
+                    for (std::size_t bitIdx = 0; bitIdx < 8; ++bitIdx) {
+                        byte = static_cast<uint8_t>((byte << 1) | (t_Bits[8 * byteIdx + bitIdx] & 1));
+                    }
+                    t_Packed[byteIdx] = byte;
+                }
+            }
+
+            if (t_Bits.size() % 8 != 0) {
+                uint8_t byte{ 0 };
+                for (std::size_t bitIdx = 0; bitIdx < 8; ++bitIdx) {
+                    byte = static_cast<uint8_t>((byte << 1) | ((8 * fullBytes + bitIdx < t_Bits.size()) ? (t_Bits[8 * fullBytes + bitIdx] & 1) : 0));
+                }
+                t_Packed[fullBytes] = byte;
+            }
+        }
+
+        /**
+         * @brief Writes "binary" strings into a file or a stream as packed bytes. Bits are packed into a fixed-size
+         * buffer, that is written out, when it's full, so there are no per-byte allocations and no copy of the whole output.
+         * Consecutive writes are concatenated bit by bit. The last byte is padded with zeroes by Close.
+        */
+        class PackedBitWriter {
+        public:
+            /**
+             * @brief Opens t_Path for writing. "-" means standard output.
+             * File descriptors can be used through their paths (e.g. /dev/fd/3).
+             * @throw std::runtime_error if the file can't be opened.
+            */
+            explicit PackedBitWriter(const std::string& t_Path)
+            {
+                if (t_Path == "-") {
+#ifdef _WIN32
+                    /* Don't translate line endings in the binary output. */
+                    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+                    m_Output = &std::cout;
+                }
+                else {
+                    m_File.open(t_Path, std::ios::out | std::ios::binary);
+                    if (!m_File.is_open()) {
+                        throw std::runtime_error("Error, while opening file: " + t_Path);
+                    }
+                    m_Output = &m_File;
+                }
             }
-            dataToWrite.emplace_back(BinaryStringToByte(currByte));
 
-            while (sliceBegin != t_SliceEnd) {
-                std::string currByte = std::string(
-                    Advance(sliceBegin, t_SliceEnd, 8),
-                    Advance(sliceEnd, t_SliceEnd, 8)
-                );
+            /**
+             * @brief Writes into already opened stream t_Output.
+            */
+            explicit PackedBitWriter(std::ostream& t_Output)
+                : m_Output{ &t_Output }
+            {}
+
+            PackedBitWriter(const PackedBitWriter&) = delete;
+            PackedBitWriter& operator=(const PackedBitWriter&) = delete;
 
-                if (sliceBegin == sliceEnd) {
-                    break;
+            ~PackedBitWriter()
+            {
+                try {
+                    Close();
                 }
+                catch (...) {}
+            }
 
-                if (currByte.size() < 8) {
-                    currByte += std::string(8 - currByte.size(), '0');
+            /**
+             * @brief Appends bits to the output.
+             * @param t_Bits "binary" string.
+            */
+            void Write(std::string_view t_Bits)
+            {
+                /* Complete the pending byte from the previous write first. */
+                while (!t_Bits.empty() && m_PendingBitsCount != 0) {
+                    m_PendingByte[m_PendingBitsCount++] = t_Bits.front();
+                    t_Bits.remove_prefix(1);
+
+                    if (m_PendingBitsCount == 8) {
+                        PackIntoBuffer(std::string_view(m_PendingByte, 8));
+                        m_PendingBitsCount = 0;
+                    }
+                }
+
+                const std::size_t fullBitsCount = t_Bits.size() - t_Bits.size() % 8;
+                for (std::size_t bitPos = 0; bitPos < fullBitsCount; ) {
+                    const std::size_t chunkBits = std::min(fullBitsCount - bitPos, 8 * (c_BufferSize - m_BufferedBytes));
+                    PackIntoBuffer(t_Bits.substr(bitPos, chunkBits));
+                    bitPos += chunkBits;
                 }
 
-                dataToWrite.emplace_back(BinaryStringToByte(currByte));
+                for (std::size_t bitPos = fullBitsCount; bitPos < t_Bits.size(); ++bitPos) {
+                    m_PendingByte[m_PendingBitsCount++] = t_Bits[bitPos];
+                }
             }
 
-            SaveDataToFileData(t_Filename, dataToWrite);
+            /**
+             * @brief Pads the last byte with zeroes, and writes out everything, that is buffered.
+             * @throw std::runtime_error if the data can't be written.
+            */
+            void Close()
+            {
+                if (m_Output == nullptr) {
+                    return;
+                }
+
+                if (m_PendingBitsCount != 0) {
+                    PackIntoBuffer(std::string_view(m_PendingByte, m_PendingBitsCount));
+                    m_PendingBitsCount = 0;
+                }
+
+                FlushBuffer();
+                m_Output->flush();
+
+                const bool isGood = m_Output->good();
+                m_Output = nullptr;
+                if (m_File.is_open()) {
+                    m_File.close();
+                }
+
+                if (!isGood) {
+                    throw std::runtime_error("Error, while writing packed data!");
+                }
+            }
+
+        private:
+            void PackIntoBuffer(std::string_view t_Bits)
+            {
+                const std::size_t bytesCount = (t_Bits.size() + 7) / 8;
+                if (m_BufferedBytes + bytesCount > c_BufferSize) {
+                    FlushBuffer();
+                }
+
+                PackBits(t_Bits, m_Buffer.data() + m_BufferedBytes);
+                m_BufferedBytes += bytesCount;
+
+                if (m_BufferedBytes == c_BufferSize) {
+                    FlushBuffer();
+                }
+            }
+
+            void FlushBuffer()
+            {
+                m_Output->write(reinterpret_cast<const char*>(m_Buffer.data()), m_BufferedBytes);
+                m_BufferedBytes = 0;
+            }
+
+            static constexpr std::size_t c_BufferSize{ 1 << 16 };
+
+            std::ofstream m_File;
+            std::ostream* m_Output{ nullptr };
+            std::vector<uint8_t> m_Buffer = std::vector<uint8_t>(c_BufferSize);
+            std::size_t m_BufferedBytes{ 0 };
+            char m_PendingByte[8]{};
+            std::size_t m_PendingBitsCount{ 0 };
+        };
+
+        /**
+         * @brief Saves "binary" string into a file as packed bytes (the last byte is padded with zeroes).
+         * @param t_Filename path to the file ("-" means standard output).
+         * @param t_Bits bits to save.
+        */
+        inline void SaveBitstreamToFile(const std::string& t_Filename, std::string_view t_Bits)
+        {
+            PackedBitWriter writer(t_Filename);
+            writer.Write(t_Bits);
+            writer.Close();
         }
     }
 }
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include "types.h"
+#include "embedder/compressor.h"
+#include "embedder/consts.h"
+#include "extractor/candidate_search.h"
+
+using namespace rdh;
+
+namespace {
+    using BinaryMatrix = CandidateSearch::BinaryMatrix;
+    using RowVector = Eigen::Matrix<uint8_t, 1, Eigen::Dynamic>;
+
+    /* Straightforward search: try candidates in index order, return the first valid one. */
+    bool ExhaustiveSearch(const BinaryMatrix& t_Psi, const BinaryMatrix& t_HashMatrix, const std::string& t_Compressed, const std::string& t_Hash,
+        std::vector<std::vector<Color8u>> t_Blocks, uint16_t t_LsbLayers, uint16_t t_Threshold, const RlcHuffmanCode& t_HuffmanCoder, RowVector& t_Restored)
+    {
+        const uint32_t alpha = t_Psi.rows();
+        const uint32_t groupSize = t_Psi.cols();
+
+        for (uint32_t index = 0; index < (1U << alpha); ++index) {
+            RowVector candidate = RowVector::Zero(1, groupSize);
+            for (uint32_t bitPos = 0; bitPos < t_Compressed.size(); ++bitPos) {
+                candidate(0, bitPos) = (t_Compressed[bitPos] == '1') ? 1 : 0;
+            }
+            for (uint32_t rowIdx = 0; rowIdx < alpha; ++rowIdx) {
+                if ((index >> (alpha - 1 - rowIdx)) & 1) {
+                    for (uint32_t bitPos = 0; bitPos < groupSize; ++bitPos) {
+                        candidate(0, bitPos) ^= t_Psi(rowIdx, bitPos);
+                    }
+                }
+            }
+
+            bool isValid{ true };
+            uint32_t bitPos{ 0 };
+            for (auto& block : t_Blocks) {
+                for (uint32_t pxIdx = 0; pxIdx < 4; ++pxIdx) {
+                    for (uint32_t lsbPos = (pxIdx == 0) ? 1 : 0; lsbPos < t_LsbLayers; ++lsbPos) {
+                        block[pxIdx] = utils::math::SetNthBitToX(block[pxIdx], lsbPos, candidate(0, bitPos++));
+                    }
+                }
+                isValid = isValid && RlcCompressor::Compress(block[0], block[1], block[2], block[3], t_HuffmanCoder).size() >= t_Threshold;
+            }
+
+            std::string hash;
+            for (uint32_t rowIdx = 0; rowIdx < t_HashMatrix.rows(); ++rowIdx) {
+                uint32_t ones{ 0 };
+                for (uint32_t col = 0; col < groupSize; ++col) {
+                    ones += t_HashMatrix(rowIdx, col) & candidate(0, col);
+                }
+                hash += (ones & 1) ? "1" : "0";
+            }
+
+            if (isValid && hash == t_Hash) {
+                t_Restored = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+TEST(CandidateSearchTest, MatchesExhaustiveSearch_test) {
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+    const uint16_t lsbLayers = 2;
+    const uint32_t blocksInGroup = 12;
+    const uint32_t groupSize = blocksInGroup * (4 * lsbLayers - 1);
+    const uint32_t alpha = 6;
+    const uint32_t hashSize = 3;
+
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<uint16_t> bitDis(0, 1);
+    std::uniform_int_distribution<uint16_t> pixelDis(0, 255);
+
+    uint32_t restoredGroups{ 0 };
+
+    for (uint32_t round = 0; round < 200; ++round) {
+        const uint16_t threshold = 10 + round % 8;
+
+        BinaryMatrix psi(alpha, groupSize);
+        psi << BinaryMatrix::Zero(alpha, groupSize - alpha).unaryExpr([&](uint8_t) { return static_cast<uint8_t>(bitDis(generator)); }),
+            BinaryMatrix::Identity(alpha, alpha);
+        BinaryMatrix hashMatrix = BinaryMatrix::Zero(hashSize, groupSize).unaryExpr([&](uint8_t) { return static_cast<uint8_t>(bitDis(generator)); });
+
+        std::string compressed;
+        for (uint32_t bitPos = 0; bitPos < groupSize - alpha; ++bitPos) {
+            compressed += bitDis(generator) ? "1" : "0";
+        }
+
+        std::string hash;
+        for (uint32_t bitPos = 0; bitPos < hashSize; ++bitPos) {
+            hash += bitDis(generator) ? "1" : "0";
+        }
+
+        std::vector<std::vector<Color8u>> blocks;
+        for (uint32_t blockIdx = 0; blockIdx < blocksInGroup; ++blockIdx) {
+            /* Mix smooth and noisy blocks, so that both outcomes of the threshold check occur. */
+            const Color8u base = static_cast<Color8u>(pixelDis(generator));
+            const uint16_t spread = (blockIdx % 3 == 0) ? 4 : 255;
+            std::vector<Color8u> block;
+            for (uint32_t pxIdx = 0; pxIdx < 4; ++pxIdx) {
+                block.push_back(static_cast<Color8u>(base + pixelDis(generator) % spread));
+            }
+            blocks.push_back(block);
+        }
+
+        RowVector expected;
+        const bool expectedFound = ExhaustiveSearch(psi, hashMatrix, compressed, hash, blocks, lsbLayers, threshold, huffmanCoder, expected);
+
+        std::vector<CandidateSearch::PackedBlock> packedBlocks;
+        for (const auto& block : blocks) {
+            packedBlocks.push_back(CandidateSearch::PackBlock(block[0], block[1], block[2], block[3]));
+        }
+
+        RowVector restored;
+        CandidateSearch candidateSearch(psi, hashMatrix, lsbLayers, threshold);
+        const bool found = candidateSearch.Recover(compressed, hash, packedBlocks, huffmanCoder, restored);
+
+        ASSERT_EQ(found, expectedFound);
+        if (found) {
+            ASSERT_EQ(restored, expected);
+            restoredGroups++;
+        }
+    }
+
+    /* Make sure the test actually exercises the search. */
+    ASSERT_GT(restoredGroups, 0);
+}
+
+TEST(CandidateSearchTest, PackBlock_test) {
+    const CandidateSearch::PackedBlock block = CandidateSearch::PackBlock(1, 2, 254, 255);
+
+    ASSERT_EQ(CandidateSearch::GetBlockPixel(block, 0), 1);
+    ASSERT_EQ(CandidateSearch::GetBlockPixel(block, 1), 2);
+    ASSERT_EQ(CandidateSearch::GetBlockPixel(block, 2), 254);
+    ASSERT_EQ(CandidateSearch::GetBlockPixel(block, 3), 255);
+}
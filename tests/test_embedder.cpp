@@ -1,10 +1,36 @@
 #include "gtest/gtest.h"
 
+#include <limits>
+#include <random>
+
 #include "types.h"
 #include "embedder/embedder.h"
+#include "encryptor/encryptor.h"
+#include "image/image_quality.h"
+#include "phase_scope.h"
 
 using namespace rdh;
 
+namespace {
+    /* Encrypted gradient image, so that both RLC- and LSB-compressed blocks are present. */
+    BmpImage EncryptedGradientImage(uint32_t t_Height, uint32_t t_Width, std::vector<uint8_t>& t_EncryptionKey)
+    {
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<uint16_t> noiseDis(0, 3);
+        ImageMatrix<Color8u> imageMatrix(t_Height, t_Width, 0);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                const uint16_t noise = ((imgY / 8 + imgX / 8) % 2) ? noiseDis(generator) * 40 : noiseDis(generator);
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(imgY + imgX + noise));
+            }
+        }
+
+        BmpImage image(std::move(imageMatrix));
+        return Encryptor::Encrypt(image, t_EncryptionKey);
+    }
+}
+
 TEST(EmbedderTest, Image_4x4px_test) {
     /**
      * 1st block - LSB
@@ -19,19 +45,22 @@ TEST(EmbedderTest, Image_4x4px_test) {
         {0b10100001, 0b10100100, 0b00010101, 0b00111111}
     }));
 
+    /* Generated with consts::huffman::c_DefaultCode. */
     BmpImage imageReference(ImageMatrix<Color8u>({
-        {0b00000000, 0b11111001, 0b00100001, 0b11110000},
-        {0b01001000, 0b11110000, 0b01001101, 0b10001011},
-        {0b10100001, 0b10000011, 0b00000000, 0b10110000},
-        {0b00110010, 0b01011100, 0b00010101, 0b00111111}
+        {0b00000000, 0b11111001, 0b00100001, 0b01111100},
+        {0b01001001, 0b11110000, 0b01000111, 0b11001101},
+        {0b10100001, 0b00101100, 0b00000000, 0b10110000},
+        {0b00111110, 0b00111110, 0b00010101, 0b00111110}
     }));
 
     std::vector<uint8_t> data{ 0b11010010 };
     std::vector<uint8_t> dataEmbedkey{ 0x11, 0x12, 0x13, 0x14 };
 
+    Consts::Instance().UpdateThreshold(14);
     Consts::Instance().UpdateLambda(2);
     Consts::Instance().UpdateAlpha(4);
     Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLsbHashSize(3);
 
     Embedder::Embed(image, data, dataEmbedkey, std::nullopt, std::nullopt);
 
@@ -41,3 +70,201 @@ TEST(EmbedderTest, Image_4x4px_test) {
         }
     }
 }
+
+
+TEST(EmbedderTest, UpdatePayload_test) {
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef, 0x00, 0x01, 0x02, 0x03 };
+    std::vector<uint8_t> patch{ 0x42, 0x24, 0xff };
+    const uint32_t offset = 3;
+
+    std::vector<uint8_t> updatedData = data;
+    std::copy(patch.begin(), patch.end(), updatedData.begin() + offset);
+
+    for (uint16_t lsbLayers : { 1, 2, 3 }) {
+        for (bool framedPayload : { false, true }) {
+            Consts::Instance().UpdateLsbLayers(lsbLayers);
+            Consts::Instance().UpdateFramedPayload(framedPayload);
+            /* Per-image Huffman code moves the user data. */
+            Consts::Instance().UpdateAdaptiveHuffman(framedPayload);
+
+            BmpImage image = EncryptedGradientImage(64, 64, encryptionKey);
+            Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+            Embedder::UpdatePayload(image, dataEmbedKey, offset, patch);
+
+            /* Updated image should be the same, as if the updated data was embedded from scratch. */
+            BmpImage reference = EncryptedGradientImage(64, 64, encryptionKey);
+            Embedder::Embed(reference, updatedData, dataEmbedKey, std::nullopt, std::nullopt);
+
+            for (uint32_t imgY = 0; imgY < image.GetHeight(); ++imgY) {
+                for (uint32_t imgX = 0; imgX < image.GetWidth(); ++imgX) {
+                    ASSERT_EQ(image.GetPixel(imgY, imgX), reference.GetPixel(imgY, imgX));
+                }
+            }
+
+            /* Offset, that wraps around in 32-bit bit arithmetic, shouldn't overwrite the beginning of the user data. */
+            ASSERT_THROW(Embedder::UpdatePayload(image, dataEmbedKey, 0x20000000, patch), std::invalid_argument);
+            ASSERT_THROW(Embedder::UpdatePayload(image, dataEmbedKey, std::numeric_limits<uint32_t>::max(), patch), std::invalid_argument);
+
+            if (framedPayload) {
+                ASSERT_THROW(Embedder::UpdatePayload(image, dataEmbedKey, data.size() - 1, patch), std::invalid_argument);
+                ASSERT_THROW(Embedder::UpdatePayload(image, { 0x11, 0x12, 0x13, 0x15 }, offset, patch), std::invalid_argument);
+            }
+
+            for (uint32_t imgY = 0; imgY < image.GetHeight(); ++imgY) {
+                for (uint32_t imgX = 0; imgX < image.GetWidth(); ++imgX) {
+                    ASSERT_EQ(image.GetPixel(imgY, imgX), reference.GetPixel(imgY, imgX));
+                }
+            }
+        }
+    }
+
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateFramedPayload(false);
+    Consts::Instance().UpdateAdaptiveHuffman(false);
+}
+
+TEST(EmbedderTest, PreparedCarrier_test) {
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(2);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+
+    const BmpImage image = EncryptedGradientImage(64, 96, encryptionKey);
+    const PreparedCarrier carrier = Embedder::Prepare(image, dataEmbedKey);
+
+    ASSERT_EQ(carrier.GetLocationMap().size(), 64 * 96 / 4);
+
+    for (const std::vector<uint8_t>& data : { std::vector<uint8_t>{ 0xde, 0xad }, std::vector<uint8_t>{ 0xbe, 0xef, 0x01 } }) {
+        const BmpImage markedImage = carrier.Embed(data);
+
+        /* Carrier should produce the same image, as the one-shot embedding. */
+        BmpImage reference = EncryptedGradientImage(64, 96, encryptionKey);
+        uint32_t maxUserDataBits{ 0 };
+        Embedder::Embed(reference, data, dataEmbedKey, std::nullopt, maxUserDataBits);
+        ASSERT_EQ(carrier.GetMaxUserDataBits(), maxUserDataBits);
+
+        for (uint32_t imgY = 0; imgY < reference.GetHeight(); ++imgY) {
+            for (uint32_t imgX = 0; imgX < reference.GetWidth(); ++imgX) {
+                ASSERT_EQ(markedImage.GetPixel(imgY, imgX), reference.GetPixel(imgY, imgX));
+            }
+        }
+    }
+
+    /* Source image is left untouched. */
+    const BmpImage untouched = EncryptedGradientImage(64, 96, encryptionKey);
+    for (uint32_t imgY = 0; imgY < image.GetHeight(); ++imgY) {
+        for (uint32_t imgX = 0; imgX < image.GetWidth(); ++imgX) {
+            ASSERT_EQ(image.GetPixel(imgY, imgX), untouched.GetPixel(imgY, imgX));
+        }
+    }
+
+    Consts::Instance().UpdateLsbLayers(1);
+}
+
+TEST(EmbedderTest, DispatchEmbeddingParams_test) {
+    Consts params;
+
+    DispatchEmbeddingParams(params, [&](auto t_Params) {
+        using Params = decltype(t_Params);
+        ASSERT_TRUE(Params::c_IsSpecialized);
+        ASSERT_EQ(Params::GetGroupSizeBeforeCompression(params), 1200);
+        ASSERT_EQ(Params::GetGroupSizeAfterCompression(params), 1194);
+    });
+
+    params.UpdateLsbLayers(3);
+    DispatchEmbeddingParams(params, [&](auto t_Params) {
+        using Params = decltype(t_Params);
+        ASSERT_TRUE(Params::c_IsSpecialized);
+        ASSERT_EQ(Params::GetGroupSizeBeforeCompression(params), 4400);
+    });
+
+    /* Any other parameters fall back to the generic kernels. */
+    params.UpdateLambda(8);
+    DispatchEmbeddingParams(params, [&](auto t_Params) {
+        using Params = decltype(t_Params);
+        ASSERT_FALSE(Params::c_IsSpecialized);
+        ASSERT_EQ(Params::GetGroupSizeBeforeCompression(params), 88);
+    });
+}
+
+TEST(EmbedderTest, EmbeddingDistortion_test) {
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    const std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    /* Plain, framed and tiled embedding with different number of LSB layers. */
+    for (uint16_t lsbLayers : { 1, 2, 3 }) {
+        for (uint16_t tileSize : { 0, 32 }) {
+            Consts::Instance().UpdateLsbLayers(lsbLayers);
+            Consts::Instance().UpdateFramedPayload(tileSize != 0);
+            Consts::Instance().UpdateTileSize(tileSize);
+
+            const BmpImage image = EncryptedGradientImage(64, 96, encryptionKey);
+            BmpImage markedImage(image);
+
+            EmbeddingDistortion distortion;
+            Embedder::Embed(markedImage, data, dataEmbedKey, std::nullopt, std::nullopt, distortion);
+
+            ASSERT_EQ(distortion.m_PixelsCount, 64 * 96);
+            ASSERT_EQ(distortion.GetMSE(), ImageQuality::CalculateMSE(image, markedImage)) << lsbLayers << " " << tileSize;
+            ASSERT_EQ(distortion.GetPSNR(), ImageQuality::CalculatePSNR(image, markedImage));
+            ASSERT_GT(distortion.m_SquaredErrorSum, 0);
+
+            if (tileSize == 0) {
+                EmbeddingDistortion carrierDistortion;
+                const BmpImage carrierImage = Embedder::Prepare(image, dataEmbedKey).Embed(data, carrierDistortion);
+                ASSERT_EQ(carrierDistortion.m_SquaredErrorSum, distortion.m_SquaredErrorSum);
+            }
+        }
+    }
+
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateFramedPayload(false);
+    Consts::Instance().UpdateTileSize(0);
+}
+
+TEST(EmbedderTest, ReportsPhases_test) {
+    /* Records phases in the order they end. */
+    class PhaseRecorder : public PhaseListener {
+    public:
+        void OnPhaseBegin(const char* t_Phase) override { m_Open.push_back(t_Phase); }
+        void OnPhaseEnd(const char* t_Phase) override
+        {
+            ASSERT_FALSE(m_Open.empty());
+            ASSERT_EQ(m_Open.back(), t_Phase);
+            m_Open.pop_back();
+            m_Ended.push_back(t_Phase);
+        }
+
+        std::vector<std::string> m_Open;
+        std::vector<std::string> m_Ended;
+    };
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    BmpImage image = EncryptedGradientImage(64, 96, encryptionKey);
+
+    PhaseRecorder recorder;
+    PhaseScope::SetListener(&recorder);
+    Embedder::Embed(image, { 0xde, 0xad }, dataEmbedKey, std::nullopt, std::nullopt);
+    PhaseScope::SetListener(nullptr);
+
+    ASSERT_TRUE(recorder.m_Open.empty());
+    ASSERT_EQ(recorder.m_Ended, (std::vector<std::string>{ "Embed.CompressBlocks", "Embed.Shuffle", "Embed.WriteBlocks" }));
+}
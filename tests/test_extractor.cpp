@@ -0,0 +1,783 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+
+#include "embedder/embedder.h"
+#include "encryptor/encryptor.h"
+#include "extractor/extractor.h"
+#include "image/bmp_image.h"
+#include "image/image_matrix.h"
+
+using namespace rdh;
+
+namespace {
+    /* Straightforward four-pass direct decryption, that is used as a reference. */
+    void RecoverImageFourPasses(BmpImage& t_MarkedEncryptedImage, const std::vector<uint8_t>& t_EncryptionKey)
+    {
+        uint32_t keyCursor = 0;
+        /** 
+         * First direct decryption pass. 
+         * Decrypts top-left pixel in RLC-compressed blocks.
+         * Decrypts all pixels in LSB-compressed blocks.
+         */
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
+                /* What type of block we are currently looking at? */
+                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
+                    /* RLC-compressed block, so decrypt only the first pixel */
+                    Color8u decPixelA = t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+
+                    /* Update pixel value, and set location map bit */
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, decPixelA | 1);
+                }
+                else {
+                    /* LSB-compressed block, so decrypt all pixels in current block */
+                    Color8u decPixelA = t_MarkedEncryptedImage.GetPixel(imgY, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+                    Color8u decPixelB = t_MarkedEncryptedImage.GetPixel(imgY, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+                    Color8u decPixelC = t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+                    Color8u decPixelD = t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) ^ t_EncryptionKey[keyCursor % t_EncryptionKey.size()];
+
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, decPixelA);
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, decPixelB);
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, decPixelC);
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, decPixelD);
+                
+                    /* reset location map pixel */
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX, t_MarkedEncryptedImage.GetPixel(imgY, imgX) & ~1);
+                }
+
+                ++keyCursor;
+            }
+        }
+
+        /**
+         * Second direct decryption pass.
+         * Decrypts down-right pixel in RLC-compressed blocks by averaging it's neighbors.
+         */
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
+                /* What type of block we are currently looking at? */
+                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
+                    /* RLC-compressed block, so decrypt down-right pixel */
+                    uint16_t avgPixelValue{ 0 };
+                    uint8_t avgOfNPixels{ 1 };
+
+                    /* This pixel exists always */
+                    avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+
+                    if (imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
+                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
+                        avgOfNPixels++;
+                    }
+
+                    if (imgY + 2 < t_MarkedEncryptedImage.GetHeight()) {
+                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
+                        avgOfNPixels++;
+                    }
+
+                    if (imgY + 2 < t_MarkedEncryptedImage.GetHeight() && imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
+                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX + 2);
+                        avgOfNPixels++;
+                    }
+
+                    /* Set new average pixel value */
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX + 1, avgPixelValue / (uint16_t)avgOfNPixels);
+                }
+            }
+        }
+
+        /**
+         * Third direct decryption pass.
+         * Decrypts pixels from RLC-compressed blocks, that are located borders of the image.
+         */
+        for (uint32_t imgY = 0; imgY < t_MarkedEncryptedImage.GetHeight(); imgY += 2) {
+            /* First or the last row */
+            if (imgY == 0 || imgY == t_MarkedEncryptedImage.GetHeight() - 2) {
+                for (uint32_t imgX = 0; imgX < t_MarkedEncryptedImage.GetWidth(); imgX += 2) {
+                    /* What type of block we are currently looking at? */
+                    if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
+                        uint16_t avgPixelValue = 0;
+                        uint8_t avgOfNPixels{ 2 };
+
+                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                        avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+
+                        /* First row */
+                        if (imgY == 0) {
+                            if (imgX + 2 < t_MarkedEncryptedImage.GetWidth()) {
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
+                                avgOfNPixels++;
+                            }
+
+                            /* Set new average pixel value */
+                            t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / avgOfNPixels);
+
+                            /**
+                             * If we are not in the top-left block, calculate average pixel value 
+                             * for the down-left pixel.
+                             */
+                            if (imgX != 0) {
+                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
+                                t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / 4);
+                            }
+                        }
+                        else {
+                            /* Last row */
+                            if (imgX >= 2) {
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
+                                avgOfNPixels++;
+                            }
+
+                            /* Set new average pixel value */
+                            t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / (uint16_t)avgOfNPixels);
+
+                            /**
+                             * If we are not in the down-right block, calculate average pixel value
+                             * for the down-right pixel.
+                             */
+                            if (imgX != t_MarkedEncryptedImage.GetWidth() - 2) {
+                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
+                                t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / 4);
+                            }
+                        }
+                    }
+                }
+            }
+            else {
+                /* First or the last column */
+                for (uint32_t imgX : std::array<uint32_t, 2>{ 0, t_MarkedEncryptedImage.GetWidth() - 2 }) {
+                    /* What type of block we are currently looking at? */
+                    if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
+                        uint16_t avgPixelValue = 0;
+                        uint8_t avgOfNPixels{ 0 };
+
+                        /* First column */
+                        if (imgX == 0) {
+                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                            avgOfNPixels += 2;
+
+                            if (imgY + 2 < t_MarkedEncryptedImage.GetHeight()) {
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
+                                avgOfNPixels++;
+                            }
+
+                            /* Set new average pixel value */
+                            t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / (uint16_t)avgOfNPixels);
+
+                            /**
+                             * If we are not in the top-left block, calculate average pixel value
+                             * for the top-right pixel.
+                             */
+                            if (imgY != 0) {
+                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
+                                t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / 4);
+                            }
+                        }
+                        else {
+                            /* Last column */
+                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                            avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                            avgOfNPixels += 2;
+
+                            if (imgY >= 2) {
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1);
+                                avgOfNPixels++;
+                            }
+
+                            /* Set new average pixel value */
+                            t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue / (uint16_t)avgOfNPixels);
+
+                            /**
+                             * If we are not in the down-right block, calculate average pixel value
+                             * for the down-left pixel.
+                             */
+                            if (imgY != t_MarkedEncryptedImage.GetHeight() - 2) {
+                                avgPixelValue = t_MarkedEncryptedImage.GetPixel(imgY, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX);
+                                avgPixelValue += t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1);
+                                t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue / 4);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Fourth direct decryption pass.
+         * Decrypts remaining pixels.
+         */
+        for (uint32_t imgY = 2; imgY < t_MarkedEncryptedImage.GetHeight() - 2; imgY += 2) {
+            for (uint32_t imgX = 2; imgX < t_MarkedEncryptedImage.GetWidth() - 2; imgX += 2) {
+                /* What type of block we are currently looking at? */
+                if (t_MarkedEncryptedImage.GetPixel(imgY, imgX) & 1) {
+                    uint16_t avgPixelValue = (
+                        t_MarkedEncryptedImage.GetPixel(imgY - 1, imgX + 1) +
+                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1) +
+                        t_MarkedEncryptedImage.GetPixel(imgY, imgX) +
+                        t_MarkedEncryptedImage.GetPixel(imgY, imgX + 2)
+                    ) / 4;
+
+                    t_MarkedEncryptedImage.SetPixel(imgY, imgX + 1, avgPixelValue);
+
+                    avgPixelValue = (
+                        t_MarkedEncryptedImage.GetPixel(imgY, imgX) +
+                        t_MarkedEncryptedImage.GetPixel(imgY + 2, imgX) +
+                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX - 1) +
+                        t_MarkedEncryptedImage.GetPixel(imgY + 1, imgX + 1)
+                    ) / 4;
+                    t_MarkedEncryptedImage.SetPixel(imgY + 1, imgX, avgPixelValue);
+                }
+            }
+        }
+    }
+
+    ImageMatrix<Color8u> RandomImageMatrix(uint32_t t_Height, uint32_t t_Width, std::mt19937& t_Generator)
+    {
+        std::uniform_int_distribution<uint16_t> pixelDis(0, 255);
+        ImageMatrix<Color8u> imageMatrix(t_Height, t_Width, 0);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(pixelDis(t_Generator)));
+            }
+        }
+
+        return imageMatrix;
+    }
+
+    /* Smooth image with a bit of noise, so that it contains both RLC- and LSB-compressed blocks. */
+    ImageMatrix<Color8u> SmoothImageMatrix(uint32_t t_Height, uint32_t t_Width, std::mt19937& t_Generator)
+    {
+        std::uniform_int_distribution<uint16_t> noiseDis(0, 3);
+        ImageMatrix<Color8u> imageMatrix(t_Height, t_Width, 0);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                const uint16_t noise = ((imgY / 8 + imgX / 8) % 2) ? noiseDis(t_Generator) * 40 : noiseDis(t_Generator);
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(imgY + imgX + noise));
+            }
+        }
+
+        return imageMatrix;
+    }
+
+    /* Image with natural statistics: slowly varying content with small per-pixel noise in every block. */
+    ImageMatrix<Color8u> NaturalImageMatrix(uint32_t t_Height, uint32_t t_Width, std::mt19937& t_Generator)
+    {
+        std::normal_distribution<double> noiseDis(0.0, 2.0);
+        ImageMatrix<Color8u> imageMatrix(t_Height, t_Width, 0);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                const double color = 128.0 + 60.0 * std::sin(imgY / 9.0) * std::cos(imgX / 7.0) + noiseDis(t_Generator);
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(std::clamp(color, 0.0, 255.0)));
+            }
+        }
+
+        return imageMatrix;
+    }
+}
+
+TEST(ExtractorTest, RecoverImageMatchesFourPasses_test) {
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<uint16_t> byteDis(0, 255);
+
+    for (auto [height, width] : std::array<std::pair<uint32_t, uint32_t>, 6>{ { { 4, 4 }, { 4, 8 }, { 8, 4 }, { 6, 10 }, { 64, 64 }, { 130, 98 } } }) {
+        std::vector<uint8_t> encryptionKey(1 + byteDis(generator));
+        for (auto& keyByte : encryptionKey) {
+            keyByte = static_cast<uint8_t>(byteDis(generator));
+        }
+
+        /* Generate the same random image twice */
+        std::mt19937 imageGenerator = generator;
+        BmpImage expected(RandomImageMatrix(height, width, imageGenerator));
+        BmpImage recovered(RandomImageMatrix(height, width, generator));
+
+        RecoverImageFourPasses(expected, encryptionKey);
+        Extractor::RecoverImage(recovered, "", encryptionKey);
+
+        ASSERT_EQ(recovered.GetImageMatrix().GetMatrixRaw(), expected.GetImageMatrix().GetMatrixRaw()) << height << "x" << width;
+    }
+}
+
+TEST(ExtractorTest, RecoverImageThreadsCount_test) {
+    std::mt19937 generator(7331);
+    std::uniform_int_distribution<uint16_t> byteDis(0, 255);
+
+    std::vector<uint8_t> encryptionKey(97);
+    for (auto& keyByte : encryptionKey) {
+        keyByte = static_cast<uint8_t>(byteDis(generator));
+    }
+
+    const BmpImage image(RandomImageMatrix(130, 98, generator));
+
+    BmpImage expected(image);
+    RecoverImageFourPasses(expected, encryptionKey);
+
+    /* Number of threads changes only the bands, that the image is split into. */
+    for (uint16_t threadsCount : { 1, 2, 3, 7, 64 }) {
+        Consts params = Consts::Instance();
+        params.UpdateThreadsCount(threadsCount);
+        Consts::ThreadOverride paramsOverride(params);
+
+        BmpImage recovered(image);
+        Extractor::RecoverImage(recovered, "", encryptionKey);
+
+        ASSERT_EQ(recovered.GetImageMatrix().GetMatrixRaw(), expected.GetImageMatrix().GetMatrixRaw()) << threadsCount;
+    }
+}
+
+TEST(ExtractorTest, RecoverPreviewMatchesRecoveredTopLeftPixels_test) {
+    std::mt19937 generator(7331);
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+
+    for (auto [height, width] : std::array<std::pair<uint32_t, uint32_t>, 3>{ { { 4, 4 }, { 6, 10 }, { 64, 32 } } }) {
+        std::mt19937 imageGenerator = generator;
+        BmpImage markedEncrypted(RandomImageMatrix(height, width, imageGenerator));
+        BmpImage recovered(RandomImageMatrix(height, width, generator));
+
+        BmpImage preview = Extractor::RecoverPreview(markedEncrypted, "", encryptionKey);
+        Extractor::RecoverImage(recovered, "", encryptionKey);
+
+        ASSERT_EQ(preview.GetHeight(), height / 2);
+        ASSERT_EQ(preview.GetWidth(), width / 2);
+
+        for (uint32_t blockY = 0; blockY < height / 2; ++blockY) {
+            for (uint32_t blockX = 0; blockX < width / 2; ++blockX) {
+                ASSERT_EQ(preview.GetPixel(blockY, blockX), recovered.GetPixel(2 * blockY, 2 * blockX));
+            }
+        }
+    }
+}
+
+TEST(ExtractorTest, ExtractUserDataWithKeys_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> wrongDataEmbedKey{ 0x11, 0x12, 0x13, 0x15 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(64, 64, generator)), encryptionKey);
+    Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+
+    const Extractor::RawBitStream rawBitStream = Extractor::ExtractRawBitStream(image);
+    ASSERT_EQ(rawBitStream.m_BinaryLocationMap.size(), rawBitStream.m_TotalBlocks);
+    ASSERT_GT(rawBitStream.m_OmegaOneBlocks, 0);
+
+    const std::vector<std::string> userDataBitStreams = Extractor::ExtractUserDataWithKeys(
+        rawBitStream, { wrongDataEmbedKey, dataEmbedKey, wrongDataEmbedKey, dataEmbedKey }
+    );
+
+    ASSERT_EQ(userDataBitStreams.size(), 4);
+    ASSERT_EQ(userDataBitStreams[1].substr(0, 8 * data.size()), utils::BytesToBinaryString(data));
+    ASSERT_EQ(userDataBitStreams[1], userDataBitStreams[3]);
+    ASSERT_EQ(userDataBitStreams[0], userDataBitStreams[2]);
+    ASSERT_NE(userDataBitStreams[0], userDataBitStreams[1]);
+}
+
+TEST(ExtractorTest, FramedPayload_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+    Consts::Instance().UpdateFramedPayload(true);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> wrongDataEmbedKey{ 0x11, 0x12, 0x13, 0x15 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef, 0x00, 0x01 };
+
+    std::mt19937 sameImageGenerator = generator;
+    BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(64, 64, generator)), encryptionKey);
+    uint32_t maxUserDataBits{ 0 };
+    Embedder::Embed(image, data, dataEmbedKey, std::nullopt, maxUserDataBits);
+    ASSERT_GT(maxUserDataBits, 8 * data.size() + 64);
+
+    const std::vector<std::string> userDataBitStreams = Extractor::ExtractUserDataWithKeys(
+        Extractor::ExtractRawBitStream(image), { dataEmbedKey, wrongDataEmbedKey }
+    );
+
+    /* Only the real payload is extracted, a wrong key fails the checksum. */
+    ASSERT_EQ(userDataBitStreams[0], utils::BytesToBinaryString(data));
+    ASSERT_TRUE(userDataBitStreams[1].empty());
+
+    /* Header is counted towards the capacity. */
+    BmpImage fullImage = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(64, 64, sameImageGenerator)), encryptionKey);
+    std::vector<uint8_t> fullData(maxUserDataBits / 8, 0xaa);
+    ASSERT_THROW(Embedder::Embed(fullImage, fullData, dataEmbedKey, std::nullopt, std::nullopt), std::invalid_argument);
+
+    Consts::Instance().UpdateFramedPayload(false);
+}
+
+TEST(ExtractorTest, ThreadOverrideWorkers_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(4);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+    Consts::Instance().UpdateFramedPayload(false);
+
+    /* Worker threads, that read the global parameters instead of the overridden ones, can't parse the stream */
+    {
+        Consts params = Consts::Instance();
+        params.UpdateLambda(8);
+        params.UpdateFramedPayload(true);
+        params.UpdateThreadsCount(4);
+        Consts::ThreadOverride paramsOverride(params);
+
+        std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+        std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+        std::vector<uint8_t> wrongDataEmbedKey{ 0x11, 0x12, 0x13, 0x15 };
+        std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+        BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(64, 64, generator)), encryptionKey);
+        Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+
+        const std::vector<std::string> userDataBitStreams = Extractor::ExtractUserDataWithKeys(
+            Extractor::ExtractRawBitStream(image), { wrongDataEmbedKey, dataEmbedKey, wrongDataEmbedKey, dataEmbedKey }
+        );
+
+        ASSERT_EQ(userDataBitStreams[1], utils::BytesToBinaryString(data));
+        ASSERT_EQ(userDataBitStreams[3], utils::BytesToBinaryString(data));
+        ASSERT_TRUE(userDataBitStreams[0].empty());
+        ASSERT_TRUE(userDataBitStreams[2].empty());
+    }
+
+    Consts::Instance().UpdateLambda(8);
+}
+
+TEST(ExtractorTest, AdaptiveHuffman_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+    Consts::Instance().UpdateFramedPayload(true);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef, 0x00, 0x01 };
+
+    const std::mt19937 imageGenerator = generator;
+    const auto makeEncryptedImage = [&]() {
+        std::mt19937 sameImageGenerator = imageGenerator;
+        return Encryptor::Encrypt(BmpImage(SmoothImageMatrix(128, 128, sameImageGenerator)), encryptionKey);
+    };
+
+    BmpImage defaultImage = makeEncryptedImage();
+    uint32_t defaultMaxUserDataBits{ 0 };
+    Embedder::Embed(defaultImage, data, dataEmbedKey, std::nullopt, defaultMaxUserDataBits);
+
+    Consts::Instance().UpdateAdaptiveHuffman(true);
+
+    BmpImage image = makeEncryptedImage();
+    uint32_t maxUserDataBits{ 0 };
+    Embedder::Embed(image, data, dataEmbedKey, std::nullopt, maxUserDataBits);
+
+    /* Code is built for this image, so more data fits, even with the code saved in the bitstream. */
+    ASSERT_GT(maxUserDataBits, defaultMaxUserDataBits);
+
+    ASSERT_EQ(Extractor::ExtractUserDataWithKeys(Extractor::ExtractRawBitStream(image), { dataEmbedKey })[0], utils::BytesToBinaryString(data));
+    ASSERT_TRUE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey));
+    ASSERT_FALSE(Extractor::ProbeEmbeddingKey(image, { 0x11, 0x12, 0x13, 0x15 }));
+
+    const std::string recoveredDataPath = ::testing::TempDir() + "rdh_adaptive_huffman_data.bin";
+    Extractor::RecoverImageAndExract(image, "", recoveredDataPath, dataEmbedKey, encryptionKey);
+    ASSERT_EQ(utils::LoadFileData<uint8_t>(recoveredDataPath), data);
+
+    /* Flat image: the default code is kept. */
+    BmpImage flatImage = Encryptor::Encrypt(BmpImage(ImageMatrix<Color8u>(64, 64, 1)), encryptionKey);
+    Embedder::Embed(flatImage, data, dataEmbedKey, std::nullopt, std::nullopt);
+    ASSERT_EQ(Extractor::ExtractUserDataWithKeys(Extractor::ExtractRawBitStream(flatImage), { dataEmbedKey })[0], utils::BytesToBinaryString(data));
+
+    Consts::Instance().UpdateAdaptiveHuffman(false);
+    Consts::Instance().UpdateFramedPayload(false);
+}
+
+TEST(ExtractorTest, ProbeEmbeddingKey_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(64, 64, generator)), encryptionKey);
+    Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+
+    ASSERT_TRUE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey));
+
+    for (uint8_t lastByte = 0x15; lastByte < 0x25; ++lastByte) {
+        ASSERT_FALSE(Extractor::ProbeEmbeddingKey(image, { 0x11, 0x12, 0x13, lastByte }));
+    }
+
+    /* Wrong parameters */
+    Consts::Instance().UpdateLambda(10);
+    ASSERT_FALSE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey));
+
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateThreshold(18);
+    ASSERT_FALSE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey));
+}
+
+TEST(ExtractorTest, ProbeEmbeddingKeyNaturalImage_test) {
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    /* Top-left LSBs of omega_2 blocks are overwritten by the embedding, so the probe must restore them before the candidate search */
+    for (uint32_t seed = 0; seed < 4; ++seed) {
+        std::mt19937 generator(seed);
+        BmpImage image = Encryptor::Encrypt(BmpImage(NaturalImageMatrix(64, 64, generator)), encryptionKey);
+        Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+
+        ASSERT_TRUE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey)) << seed;
+        ASSERT_TRUE(Extractor::ProbeEmbeddingKey(image, dataEmbedKey, UINT32_MAX)) << seed;
+    }
+}
+
+TEST(ExtractorTest, DiscoverParameters_test) {
+    std::mt19937 generator(42);
+
+    const auto makeParams = [](uint16_t t_Threshold, uint16_t t_LsbLayers, uint16_t t_Lambda, uint16_t t_Alpha) {
+        Consts params;
+        params.UpdateThreshold(t_Threshold);
+        params.UpdateLsbLayers(t_LsbLayers);
+        params.UpdateLambda(t_Lambda);
+        params.UpdateAlpha(t_Alpha);
+        params.UpdateLsbHashSize(3);
+        return params;
+    };
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(128, 128, generator)), encryptionKey);
+    {
+        Consts embeddingParams = makeParams(16, 1, 20, 5);
+        Consts::ThreadOverride constsOverride(embeddingParams);
+        ASSERT_EQ(&Consts::Instance(), &embeddingParams);
+
+        Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+    }
+    ASSERT_NE(Consts::Instance().GetThreshold(), 16);
+
+    std::vector<Consts> candidateParams;
+    for (uint16_t threshold : { 12, 16, 20 }) {
+        for (uint16_t lambda : { 16, 20, 24 }) {
+            for (uint16_t alpha : { 4, 5 }) {
+                candidateParams.push_back(makeParams(threshold, 1, lambda, alpha));
+            }
+        }
+    }
+
+    std::optional<Consts> discoveredParams = Extractor::DiscoverParameters(image, dataEmbedKey, candidateParams);
+    ASSERT_TRUE(discoveredParams.has_value());
+    ASSERT_EQ(discoveredParams->GetThreshold(), 16);
+    ASSERT_EQ(discoveredParams->GetLambda(), 20);
+    ASSERT_EQ(discoveredParams->GetAlpha(), 5);
+
+    ASSERT_FALSE(Extractor::DiscoverParameters(image, { 0x11, 0x12, 0x13, 0x15 }, candidateParams).has_value());
+}
+
+TEST(ExtractorTest, DiscoverParametersAdaptiveHuffman_test) {
+    std::mt19937 generator(42);
+
+    Consts::Instance().UpdateLsbHashSize(3);
+    Consts::Instance().UpdateAdaptiveHuffman(true);
+
+    /* Like in the discover mode, only the searched parameters differ from the current ones */
+    const auto makeParams = [](uint16_t t_Threshold, uint16_t t_Lambda, uint16_t t_Alpha) {
+        Consts params = Consts::Instance();
+        params.UpdateThreshold(t_Threshold);
+        params.UpdateLsbLayers(1);
+        params.UpdateLambda(t_Lambda);
+        params.UpdateAlpha(t_Alpha);
+        return params;
+    };
+
+    std::vector<uint8_t> encryptionKey{ 0x10, 0x34, 0x11, 0xfe, 0x01 };
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+    std::vector<uint8_t> data{ 0xde, 0xad, 0xbe, 0xef };
+
+    BmpImage image = Encryptor::Encrypt(BmpImage(SmoothImageMatrix(128, 128, generator)), encryptionKey);
+    {
+        Consts embeddingParams = makeParams(16, 20, 5);
+        Consts::ThreadOverride constsOverride(embeddingParams);
+
+        Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+    }
+
+    std::vector<Consts> candidateParams;
+    for (uint16_t threshold : { 12, 16, 20 }) {
+        for (uint16_t lambda : { 16, 20, 24 }) {
+            for (uint16_t alpha : { 4, 5 }) {
+                candidateParams.push_back(makeParams(threshold, lambda, alpha));
+            }
+        }
+    }
+
+    std::optional<Consts> discoveredParams = Extractor::DiscoverParameters(image, dataEmbedKey, candidateParams);
+    ASSERT_TRUE(discoveredParams.has_value());
+    ASSERT_TRUE(discoveredParams->IsHuffmanAdaptive());
+    ASSERT_EQ(discoveredParams->GetThreshold(), 16);
+    ASSERT_EQ(discoveredParams->GetLambda(), 20);
+    ASSERT_EQ(discoveredParams->GetAlpha(), 5);
+
+    /* Without the flag the per-image code is parsed as a part of the header */
+    for (auto& params : candidateParams) {
+        params.UpdateAdaptiveHuffman(false);
+    }
+    ASSERT_FALSE(Extractor::DiscoverParameters(image, dataEmbedKey, candidateParams).has_value());
+
+    Consts::Instance().UpdateAdaptiveHuffman(false);
+}
+
+TEST(ExtractorTest, TiledContainer_test) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<uint16_t> byteDis(0, 255);
+
+    Consts::Instance().UpdateThreshold(14);
+    Consts::Instance().UpdateLsbLayers(1);
+    Consts::Instance().UpdateLambda(8);
+    Consts::Instance().UpdateAlpha(4);
+    Consts::Instance().UpdateLsbHashSize(3);
+    Consts::Instance().UpdateTileSize(32);
+
+    std::vector<uint8_t> encryptionKey(1000);
+    for (auto& keyByte : encryptionKey) {
+        keyByte = static_cast<uint8_t>(byteDis(generator));
+    }
+    std::vector<uint8_t> dataEmbedKey{ 0x11, 0x12, 0x13, 0x14 };
+
+    /* Edge tiles are smaller than the others. */
+    const std::mt19937 imageGenerator = generator;
+    auto makeEncryptedImage = [&]() {
+        std::mt19937 sameImageGenerator = imageGenerator;
+        return Encryptor::Encrypt(BmpImage(SmoothImageMatrix(80, 112, sameImageGenerator)), encryptionKey);
+    };
+
+    uint32_t maxUserDataBits{ 0 };
+    {
+        BmpImage image = makeEncryptedImage();
+        Embedder::Embed(image, {}, dataEmbedKey, std::nullopt, maxUserDataBits);
+    }
+
+    /* Data spans several tiles. */
+    std::vector<uint8_t> data(maxUserDataBits / 8 - 5);
+    for (auto& dataByte : data) {
+        dataByte = static_cast<uint8_t>(byteDis(generator));
+    }
+
+    BmpImage image = makeEncryptedImage();
+    Embedder::Embed(image, data, dataEmbedKey, std::nullopt, std::nullopt);
+
+    const std::string dataPath = ::testing::TempDir() + "rdh_tiled_data.bin";
+    Extractor::ExtractData(image, dataPath, dataEmbedKey);
+    ASSERT_EQ(utils::LoadFileData<uint8_t>(dataPath), data);
+
+    const BmpImage markedImage = image;
+
+    /* Tiled container can't be updated in place, and is left untouched. */
+    {
+        BmpImage updatedImage = markedImage;
+        ASSERT_THROW(Embedder::UpdatePayload(updatedImage, dataEmbedKey, 0, { 0x42 }), std::invalid_argument);
+
+        for (uint32_t imgY = 0; imgY < markedImage.GetHeight(); ++imgY) {
+            for (uint32_t imgX = 0; imgX < markedImage.GetWidth(); ++imgX) {
+                ASSERT_EQ(updatedImage.GetPixel(imgY, imgX), markedImage.GetPixel(imgY, imgX));
+            }
+        }
+    }
+
+    const std::string recoveredDataPath = ::testing::TempDir() + "rdh_tiled_recovered_data.bin";
+    Extractor::RecoverImageAndExract(image, "", recoveredDataPath, dataEmbedKey, encryptionKey);
+    ASSERT_EQ(utils::LoadFileData<uint8_t>(recoveredDataPath), data);
+
+    /* Every tile is recovered the same way, as a standalone framed image with its own keys. */
+    {
+        Consts tileParams = Consts::Instance();
+        tileParams.UpdateTileSize(0);
+        tileParams.UpdateFramedPayload(true);
+        Consts::ThreadOverride constsOverride(tileParams);
+
+        uint32_t tileIdx{ 0 };
+        for (uint32_t tileY = 0; tileY < markedImage.GetHeight(); tileY += 32) {
+            for (uint32_t tileX = 0; tileX < markedImage.GetWidth(); tileX += 32, ++tileIdx) {
+                const uint32_t tileHeight = std::min<uint32_t>(32, markedImage.GetHeight() - tileY);
+                const uint32_t tileWidth = std::min<uint32_t>(32, markedImage.GetWidth() - tileX);
+
+                std::vector<uint8_t> tileDataEmbedKey(dataEmbedKey);
+                for (uint32_t bytePos = 0; bytePos < 4; ++bytePos) {
+                    tileDataEmbedKey.push_back(static_cast<uint8_t>(tileIdx >> (8 * bytePos)));
+                }
+
+                std::vector<uint8_t> tileEncryptionKey;
+                for (uint32_t blockY = tileY / 2; blockY < (tileY + tileHeight) / 2; ++blockY) {
+                    for (uint32_t blockX = tileX / 2; blockX < (tileX + tileWidth) / 2; ++blockX) {
+                        tileEncryptionKey.push_back(encryptionKey[(blockY * markedImage.GetWidth() / 2 + blockX) % encryptionKey.size()]);
+                    }
+                }
+
+                BmpImage tileImage = BmpImage(markedImage).Crop(tileY, tileY + tileHeight - 1, tileX, tileX + tileWidth - 1);
+                Extractor::RecoverImageAndExract(tileImage, "", "", tileDataEmbedKey, tileEncryptionKey);
+
+                for (uint32_t imgY = 0; imgY < tileHeight; ++imgY) {
+                    for (uint32_t imgX = 0; imgX < tileWidth; ++imgX) {
+                        ASSERT_EQ(image.GetPixel(tileY + imgY, tileX + imgX), tileImage.GetPixel(imgY, imgX));
+                    }
+                }
+            }
+        }
+        ASSERT_EQ(tileIdx, 12);
+    }
+
+    std::vector<uint8_t> tooBigData(maxUserDataBits / 8 + 1);
+    BmpImage anotherImage = makeEncryptedImage();
+    ASSERT_THROW(Embedder::Embed(anotherImage, tooBigData, dataEmbedKey, std::nullopt, std::nullopt), std::invalid_argument);
+
+    std::remove(dataPath.c_str());
+    std::remove(recoveredDataPath.c_str());
+    Consts::Instance().UpdateTileSize(0);
+}
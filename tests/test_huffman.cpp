@@ -1,9 +1,12 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <cmath>
 #include <unordered_map>
 
 #include "embedder/huffman.h"
+#include "embedder/rlc_huffman_code.h"
+#include "embedder/consts.h"
 #include "types.h"
 
 using namespace rdh;
@@ -61,3 +64,98 @@ TEST(HuffmanTest, EncodePairs_test) {
         ASSERT_EQ(decoded.at(i), original.at(i));
     }
 }
+
+/* Default code is built at compile time. */
+static_assert(consts::huffman::c_DefaultCode.GetCodeLength(RlcHuffmanCode::Symbol(0, 1)) != 0);
+static_assert(consts::huffman::c_DefaultCode.GetCodeLength(RlcHuffmanCode::Symbol(0, 0)) == 0);
+
+TEST(HuffmanTest, CanonicalEncodeDecodeString_test) {
+    RlcHuffmanCode::Frequencies frequencies{};
+    frequencies[RlcHuffmanCode::SymbolIndex({ 0, 1 })] = 50;
+    frequencies[RlcHuffmanCode::SymbolIndex({ 0, -1 })] = 30;
+    frequencies[RlcHuffmanCode::SymbolIndex({ 1, 2 })] = 15;
+    frequencies[RlcHuffmanCode::SymbolIndex({ 2, 3 })] = 5;
+
+    /* The same lengths, as for the tree-based coder, but codes are assigned in canonical order. */
+    const RlcHuffmanCode huffmanCoder(frequencies);
+
+    std::string encoded = "00010110110111";
+    std::vector<RlcHuffmanCode::Symbol> original{ { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, -1 }, { 1, 2 }, { 1, 2 }, { 2, 3 } };
+
+    ASSERT_EQ(huffmanCoder.Encode(original), encoded);
+    ASSERT_EQ(huffmanCoder.Decode(encoded), original);
+
+    ASSERT_THROW(huffmanCoder.Decode("00011"), std::invalid_argument);
+    ASSERT_THROW(huffmanCoder.Encode({ { 0, 2 } }), std::invalid_argument);
+}
+
+TEST(HuffmanTest, CanonicalDefaultCode_test) {
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+    /* Huffman code is optimal, so it has the same cost, as the tree-based one. */
+    Huffman<std::pair<uint16_t, Color16s>, pair_hash> treeCoder(std::pair<uint16_t, Color16s>(-1, 0));
+    std::unordered_map<std::pair<uint16_t, Color16s>, uint32_t, pair_hash> frequencies;
+    for (const auto& [symbol, freq] : consts::huffman::c_DefaultFrequencies) {
+        if (freq != 0) {
+            frequencies[symbol] = freq;
+        }
+    }
+    treeCoder.SetFrequencies(frequencies);
+
+    uint64_t canonicalCost{ 0 };
+    uint64_t treeCost{ 0 };
+    double kraftSum{ 0.0 };
+    for (const auto& [symbol, freq] : frequencies) {
+        const uint8_t codeLength = huffmanCoder.GetCodeLength(symbol);
+        ASSERT_NE(codeLength, 0);
+
+        canonicalCost += static_cast<uint64_t>(freq) * codeLength;
+        treeCost += static_cast<uint64_t>(freq) * treeCoder.GetCodesTable().at(symbol).size();
+        kraftSum += std::ldexp(1.0, -codeLength);
+
+        /* Every symbol, that RLC can produce, is decoded back. */
+        if (symbol == RlcHuffmanCode::Symbol(2, 0)) {
+            continue;
+        }
+        ASSERT_EQ(huffmanCoder.Decode(huffmanCoder.Encode({ symbol })), std::vector<RlcHuffmanCode::Symbol>{ symbol });
+    }
+
+    ASSERT_EQ(canonicalCost, treeCost);
+    ASSERT_DOUBLE_EQ(kraftSum, 1.0);
+}
+
+TEST(HuffmanTest, CanonicalLimitedSerializedCode_test) {
+    const RlcHuffmanCode::CodeLengths limitedLengths = RlcHuffmanCode::LimitCodeLengths(
+        consts::huffman::c_DefaultCode.GetCodeLengths(), RlcHuffmanCode::c_MaxSerializedCodeLength
+    );
+
+    /* Every symbol keeps its code, and the code is still complete. */
+    double kraftSum{ 0.0 };
+    for (uint32_t symbolIdx = 0; symbolIdx < RlcHuffmanCode::c_AlphabetSize; ++symbolIdx) {
+        ASSERT_EQ(limitedLengths[symbolIdx] != 0, consts::huffman::c_DefaultCode.GetCodeLengths()[symbolIdx] != 0);
+        ASSERT_LE(limitedLengths[symbolIdx], RlcHuffmanCode::c_MaxSerializedCodeLength);
+        if (limitedLengths[symbolIdx] != 0) {
+            kraftSum += std::ldexp(1.0, -limitedLengths[symbolIdx]);
+        }
+    }
+    ASSERT_DOUBLE_EQ(kraftSum, 1.0);
+
+    /* Lengths, that are already short enough, are left as is. */
+    ASSERT_EQ(RlcHuffmanCode::LimitCodeLengths(limitedLengths, RlcHuffmanCode::c_MaxSerializedCodeLength), limitedLengths);
+
+    const RlcHuffmanCode limitedCoder(limitedLengths);
+    ASSERT_EQ(RlcHuffmanCode::Deserialize(limitedCoder.Serialize()).GetCodeLengths(), limitedLengths);
+    ASSERT_THROW(consts::huffman::c_DefaultCode.Serialize(), std::invalid_argument);
+
+    /* Gap 1 (symbol 0), length 1; gap 2 (symbol 2), length 1. */
+    RlcHuffmanCode::CodeLengths codeLengths{};
+    codeLengths[0] = 1;
+    codeLengths[2] = 1;
+    ASSERT_EQ(RlcHuffmanCode(codeLengths).Serialize(), "10001" "0100001");
+
+    ASSERT_THROW(RlcHuffmanCode::Deserialize("1000"), std::invalid_argument);
+    ASSERT_THROW(RlcHuffmanCode::Deserialize("10000"), std::invalid_argument);
+    ASSERT_THROW(RlcHuffmanCode::Deserialize("000000000000000"), std::invalid_argument);
+    /* Three codes of length 1 are not a prefix code. */
+    ASSERT_THROW(RlcHuffmanCode::Deserialize("10001" "10001" "10001"), std::invalid_argument);
+}
@@ -0,0 +1,261 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "image/bmp_image.h"
+#include "image/image_matrix.h"
+#include "image/image_quality.h"
+#include "image/quality_batch.h"
+
+using namespace rdh;
+
+namespace {
+    /* Straightforward per-pixel PSNR, that is used as a reference. */
+    double CalculatePSNRReference(const BmpImage& t_Img1, const BmpImage& t_Img2)
+    {
+        double meanSquaredError = 0;
+
+        for (uint32_t imgY = 0; imgY < t_Img1.GetHeight(); imgY += 1) {
+            for (uint32_t imgX = 0; imgX < t_Img1.GetWidth(); imgX += 1) {
+                meanSquaredError += std::powf((float)t_Img1.GetPixel(imgY, imgX) - (float)t_Img2.GetPixel(imgY, imgX), 2);
+            }
+        }
+
+        meanSquaredError /= ((double)t_Img1.GetHeight() * (double)t_Img1.GetWidth());
+
+        if (meanSquaredError <= 1E-10) {
+            return +std::numeric_limits<double>::infinity();
+        }
+
+        return 10.0f * std::log10f(std::powf(255, 2) / meanSquaredError);
+    }
+
+    /* 2x2 blocks SSIM, calculated using the Block helper. */
+    double CalculateSSIMReference(const BmpImage& t_Img1, const BmpImage& t_Img2)
+    {
+        double ssim = 0;
+
+        for (uint32_t imgY = 0; imgY + 1 < t_Img1.GetHeight(); imgY += 2) {
+            for (uint32_t imgX = 0; imgX + 1 < t_Img1.GetWidth(); imgX += 2) {
+                ImageQuality::Block block1(t_Img1.GetPixel(imgY, imgX), t_Img1.GetPixel(imgY, imgX + 1), t_Img1.GetPixel(imgY + 1, imgX), t_Img1.GetPixel(imgY + 1, imgX + 1));
+                ImageQuality::Block block2(t_Img2.GetPixel(imgY, imgX), t_Img2.GetPixel(imgY, imgX + 1), t_Img2.GetPixel(imgY + 1, imgX), t_Img2.GetPixel(imgY + 1, imgX + 1));
+
+                const double mean1 = block1.CalculateMean();
+                const double mean2 = block2.CalculateMean();
+                const double deviation1 = block1.CalculateStandardDeviation();
+                const double deviation2 = block2.CalculateStandardDeviation();
+
+                ssim += ((2 * mean1 * mean2 + 6.5025) * (2 * block1.Covariance(block2) + 58.5225)) /
+                    ((mean1 * mean1 + mean2 * mean2 + 6.5025) * (deviation1 * deviation1 + deviation2 * deviation2 + 58.5225));
+            }
+        }
+
+        return ssim / ((double)(t_Img1.GetHeight() / 2) * (double)(t_Img1.GetWidth() / 2));
+    }
+
+    /* Mean SSIM over all sliding windows, calculated directly from the window pixels. */
+    double CalculateWindowedSSIMReference(const BmpImage& t_Img1, const BmpImage& t_Img2, const std::vector<double>& t_Weights)
+    {
+        const uint32_t windowSize = t_Weights.size();
+        double ssim = 0;
+        uint32_t windowsCount = 0;
+
+        for (uint32_t windowY = 0; windowY + windowSize <= t_Img1.GetHeight(); ++windowY) {
+            for (uint32_t windowX = 0; windowX + windowSize <= t_Img1.GetWidth(); ++windowX) {
+                double meanX = 0, meanY = 0;
+                for (uint32_t dy = 0; dy < windowSize; ++dy) {
+                    for (uint32_t dx = 0; dx < windowSize; ++dx) {
+                        meanX += t_Weights[dy] * t_Weights[dx] * t_Img1.GetPixel(windowY + dy, windowX + dx);
+                        meanY += t_Weights[dy] * t_Weights[dx] * t_Img2.GetPixel(windowY + dy, windowX + dx);
+                    }
+                }
+
+                double varianceX = 0, varianceY = 0, covariance = 0;
+                for (uint32_t dy = 0; dy < windowSize; ++dy) {
+                    for (uint32_t dx = 0; dx < windowSize; ++dx) {
+                        const double diffX = t_Img1.GetPixel(windowY + dy, windowX + dx) - meanX;
+                        const double diffY = t_Img2.GetPixel(windowY + dy, windowX + dx) - meanY;
+                        varianceX += t_Weights[dy] * t_Weights[dx] * diffX * diffX;
+                        varianceY += t_Weights[dy] * t_Weights[dx] * diffY * diffY;
+                        covariance += t_Weights[dy] * t_Weights[dx] * diffX * diffY;
+                    }
+                }
+
+                ssim += ((2 * meanX * meanY + 6.5025) * (2 * covariance + 58.5225)) /
+                    ((meanX * meanX + meanY * meanY + 6.5025) * (varianceX + varianceY + 58.5225));
+                windowsCount++;
+            }
+        }
+
+        return ssim / windowsCount;
+    }
+
+    std::vector<double> GaussianWeights(uint32_t t_Size, double t_Sigma)
+    {
+        std::vector<double> weights;
+        double weightsSum = 0;
+        for (uint32_t tap = 0; tap < t_Size; ++tap) {
+            const double offset = tap - (t_Size - 1) / 2.0;
+            weights.push_back(std::exp(-offset * offset / (2 * t_Sigma * t_Sigma)));
+            weightsSum += weights.back();
+        }
+
+        for (auto& weight : weights) {
+            weight /= weightsSum;
+        }
+
+        return weights;
+    }
+
+    /* Smooth image with noise, so that SSIM is neither 0 nor 1. */
+    BmpImage DistortedImage(const BmpImage& t_Image, std::mt19937& t_Generator)
+    {
+        std::uniform_int_distribution<int16_t> noiseDis(-20, 20);
+        ImageMatrix<Color8u> imageMatrix(t_Image.GetHeight(), t_Image.GetWidth(), 0);
+
+        for (uint32_t imgY = 0; imgY < t_Image.GetHeight(); ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Image.GetWidth(); ++imgX) {
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(std::clamp<int16_t>(t_Image.GetPixel(imgY, imgX) + noiseDis(t_Generator), 0, 255)));
+            }
+        }
+
+        return BmpImage(std::move(imageMatrix));
+    }
+
+    BmpImage RandomImage(uint32_t t_Height, uint32_t t_Width, std::mt19937& t_Generator)
+    {
+        std::uniform_int_distribution<uint16_t> pixelDis(0, 255);
+        ImageMatrix<Color8u> imageMatrix(t_Height, t_Width, 0);
+
+        for (uint32_t imgY = 0; imgY < t_Height; ++imgY) {
+            for (uint32_t imgX = 0; imgX < t_Width; ++imgX) {
+                imageMatrix.SetPixel(imgY, imgX, static_cast<Color8u>(pixelDis(t_Generator)));
+            }
+        }
+
+        return BmpImage(std::move(imageMatrix));
+    }
+}
+
+TEST(ImageQualityTest, PSNRMatchesReference_test) {
+    std::mt19937 generator(1337);
+
+    /* Widths, that aren't multiple of the SIMD width, and an image, that is split between threads. */
+    for (const auto& [height, width] : std::vector<std::pair<uint32_t, uint32_t>>{ { 1, 1 }, { 3, 15 }, { 17, 33 }, { 64, 64 }, { 8, 70000 }, { 1024, 1030 } }) {
+        BmpImage image1 = RandomImage(height, width, generator);
+        BmpImage image2 = RandomImage(height, width, generator);
+
+        ASSERT_EQ(ImageQuality::CalculatePSNR(image1, image2), CalculatePSNRReference(image1, image2)) << height << "x" << width;
+        ASSERT_EQ(ImageQuality::CalculatePSNR(image1, image1), +std::numeric_limits<double>::infinity());
+    }
+
+    /* Maximum difference in every pixel: 32-bit lanes have to be flushed. */
+    BmpImage black(4, 100000, 0);
+    BmpImage white(4, 100000, 255);
+    ASSERT_EQ(ImageQuality::CalculateMSE(black, white), 255.0 * 255.0);
+    ASSERT_EQ(ImageQuality::CalculatePSNR(black, white), CalculatePSNRReference(black, white));
+
+    ASSERT_THROW(ImageQuality::CalculatePSNR(BmpImage(2, 2), BmpImage(2, 4)), std::invalid_argument);
+}
+
+TEST(ImageQualityTest, SSIMMatchesReference_test) {
+    std::mt19937 generator(1337);
+
+    for (const auto& [height, width] : std::vector<std::pair<uint32_t, uint32_t>>{ { 11, 11 }, { 12, 19 }, { 33, 50 }, { 64, 64 } }) {
+        BmpImage image1 = RandomImage(height, width, generator);
+        BmpImage image2 = DistortedImage(image1, generator);
+        BmpImage image3 = RandomImage(height, width, generator);
+
+        for (const auto& image : { image2, image3 }) {
+            ASSERT_NEAR(ImageQuality::CalculateSSIM(image1, image), CalculateSSIMReference(image1, image), 1e-5) << height << "x" << width;
+            ASSERT_NEAR(
+                ImageQuality::CalculateSSIM(image1, image, ImageQuality::SsimWindow::Box8x8),
+                CalculateWindowedSSIMReference(image1, image, std::vector<double>(8, 1.0 / 8)), 1e-9
+            ) << height << "x" << width;
+            ASSERT_NEAR(
+                ImageQuality::CalculateSSIM(image1, image, ImageQuality::SsimWindow::Gaussian11x11),
+                CalculateWindowedSSIMReference(image1, image, GaussianWeights(11, 1.5)), 1e-9
+            ) << height << "x" << width;
+        }
+
+        for (const auto window : { ImageQuality::SsimWindow::Block2x2, ImageQuality::SsimWindow::Box8x8, ImageQuality::SsimWindow::Gaussian11x11 }) {
+            ASSERT_NEAR(ImageQuality::CalculateSSIM(image1, image1, window), 1.0, 1e-12);
+        }
+    }
+
+    /* Image, that is split between threads. */
+    BmpImage image1 = RandomImage(600, 600, generator);
+    BmpImage image2 = DistortedImage(image1, generator);
+    const double ssim = ImageQuality::CalculateSSIM(image1, image2, ImageQuality::SsimWindow::Box8x8);
+    ASSERT_GT(ssim, 0.0);
+    ASSERT_LT(ssim, 1.0);
+
+    ASSERT_THROW(ImageQuality::CalculateSSIM(BmpImage(10, 10), BmpImage(10, 10), ImageQuality::SsimWindow::Gaussian11x11), std::invalid_argument);
+    ASSERT_THROW(ImageQuality::CalculateSSIM(BmpImage(16, 6), BmpImage(16, 6), ImageQuality::SsimWindow::Box8x8), std::invalid_argument);
+    ASSERT_THROW(ImageQuality::CalculateSSIM(BmpImage(2, 2), BmpImage(2, 4)), std::invalid_argument);
+}
+
+TEST(ImageQualityTest, QualityBatch_test) {
+    std::mt19937 generator(1337);
+
+    /* Two references, each of them is compared with several test images (and with itself). */
+    std::vector<BmpImage> images;
+    std::vector<std::string> paths;
+    for (uint32_t imageIdx = 0; imageIdx < 6; ++imageIdx) {
+        images.push_back((imageIdx < 2) ? RandomImage(32, 48, generator) : DistortedImage(images[imageIdx % 2], generator));
+        paths.push_back("rdh_quality_batch_" + std::to_string(imageIdx) + ".bmp");
+        images.back().Save(::testing::TempDir() + paths.back());
+    }
+
+    std::stringstream manifest;
+    manifest << "# reference, test\n\n";
+    for (uint32_t imageIdx = 0; imageIdx < 6; ++imageIdx) {
+        manifest << paths[imageIdx % 2] << ", " << paths[imageIdx] << "\n";
+    }
+    manifest << paths[0] << "\tmissing.bmp\n";
+
+    const std::vector<QualityBatch::Pair> pairs = QualityBatch::ParseManifest(manifest, ::testing::TempDir());
+    ASSERT_EQ(pairs.size(), 7);
+    ASSERT_EQ(pairs[3].m_ReferencePath, ::testing::TempDir() + paths[1]);
+    ASSERT_EQ(pairs[3].m_TestPath, ::testing::TempDir() + paths[3]);
+
+    for (uint32_t threadsCount : { 1, 3 }) {
+        std::vector<QualityBatch::Result> results;
+        QualityBatch::Evaluate(pairs, ImageQuality::SsimWindow::Box8x8, threadsCount, [&](const QualityBatch::Result& t_Result) {
+            results.push_back(t_Result);
+        });
+
+        /* Results come in the manifest order, failed pair doesn't stop the batch. */
+        ASSERT_EQ(results.size(), 7);
+        for (uint32_t imageIdx = 0; imageIdx < 6; ++imageIdx) {
+            ASSERT_EQ(results[imageIdx].m_Index, imageIdx);
+            ASSERT_TRUE(results[imageIdx].m_Error.empty());
+            ASSERT_EQ(results[imageIdx].m_Psnr, ImageQuality::CalculatePSNR(images[imageIdx % 2], images[imageIdx]));
+            ASSERT_EQ(results[imageIdx].m_Ssim, ImageQuality::CalculateSSIM(images[imageIdx % 2], images[imageIdx], ImageQuality::SsimWindow::Box8x8));
+        }
+        ASSERT_FALSE(results[6].m_Error.empty());
+    }
+
+    std::stringstream csv;
+    ASSERT_EQ(QualityBatch::Run(pairs, ImageQuality::SsimWindow::Block2x2, QualityBatch::OutputFormat::CSV, csv, 2), 1);
+    std::string line;
+    std::getline(csv, line);
+    ASSERT_EQ(line, "reference,test,psnr,ssim,error");
+    std::getline(csv, line);
+    ASSERT_EQ(line, ::testing::TempDir() + paths[0] + "," + ::testing::TempDir() + paths[0] + ",inf,1,");
+
+    std::stringstream json;
+    ASSERT_EQ(QualityBatch::Run(pairs, ImageQuality::SsimWindow::Block2x2, QualityBatch::OutputFormat::JSON, json, 2), 1);
+    std::getline(json, line);
+    ASSERT_EQ(line, "{\"reference\":\"" + ::testing::TempDir() + paths[0] + "\",\"test\":\"" + ::testing::TempDir() + paths[0] + "\",\"psnr\":null,\"ssim\":1}");
+
+    std::stringstream malformed("a.bmp,b.bmp,c.bmp\n");
+    ASSERT_THROW(QualityBatch::ParseManifest(malformed), std::invalid_argument);
+
+    for (const auto& path : paths) {
+        std::remove((::testing::TempDir() + path).c_str());
+    }
+}
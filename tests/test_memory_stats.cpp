@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <random>
+
+#include "types.h"
+#include "memory_stats.h"
+#include "embedder/compressor.h"
+#include "embedder/consts.h"
+#include "extractor/candidate_search.h"
+
+using namespace rdh;
+
+/**
+ * Allocation budgets of the steady-state hot paths (per block/group). If a change makes one of these paths
+ * allocate more, the budget should only be raised deliberately.
+ */
+namespace {
+    constexpr uint64_t c_TryCompressBudget{ 0 };
+    /* Result, Huffman-decoded symbols and RLC-decoded differences, plus reallocations of the result. */
+    constexpr uint64_t c_DecompressBudget{ 9 };
+    /* Candidate, its bookkeeping bitsets, scratch buffer for the compressed blocks and the found candidate. */
+    constexpr uint64_t c_RecoverGroupBudget{ 5 };
+
+    std::vector<std::array<Color8u, 4>> RandomBlocks(uint32_t t_BlocksCount, uint16_t t_Spread)
+    {
+        std::mt19937 generator(1337);
+        std::uniform_int_distribution<uint16_t> pixelDis(0, 255);
+
+        std::vector<std::array<Color8u, 4>> blocks(t_BlocksCount);
+        for (auto& block : blocks) {
+            const Color8u base = static_cast<Color8u>(pixelDis(generator) % (256 - t_Spread));
+            for (auto& pixel : block) {
+                pixel = static_cast<Color8u>(base + pixelDis(generator) % t_Spread);
+            }
+        }
+
+        return blocks;
+    }
+}
+
+TEST(MemoryStatsTest, CountsAllocations_test) {
+    ASSERT_TRUE(MemoryStats::IsAllocationTrackingEnabled());
+
+    const AllocationCounters before = MemoryStats::GetThreadAllocations();
+    const uint64_t heapBefore = MemoryStats::GetHeapBytes();
+
+    auto value = std::make_unique<std::array<uint64_t, 16>>();
+    const AllocationCounters allocated = MemoryStats::GetThreadAllocations() - before;
+    ASSERT_EQ(allocated.m_Count, 1);
+    ASSERT_GE(allocated.m_Bytes, sizeof(*value));
+    ASSERT_GE(MemoryStats::GetPeakHeapBytes(), MemoryStats::GetHeapBytes());
+
+    value.reset();
+    ASSERT_EQ(MemoryStats::GetHeapBytes(), heapBefore);
+}
+
+TEST(MemoryStatsTest, PeakRssSampler_test) {
+    constexpr size_t c_BufferSize{ 64 * 1024 * 1024 };
+
+    PeakRssSampler sampler;
+
+    /* Touch every page, so that the buffer is resident. */
+    std::vector<uint8_t> buffer(c_BufferSize, 1);
+    sampler.Stop();
+
+    ASSERT_GE(sampler.GetPeakRss(), sampler.GetStartRss() + c_BufferSize / 2);
+    ASSERT_GE(MemoryStats::GetPeakRss(), sampler.GetPeakRss() / 2);
+}
+
+TEST(MemoryStatsTest, TryCompressBudget_test) {
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+    const auto blocks = RandomBlocks(4096, 16);
+
+    /* Output buffer is reused by the embedder, so it grows only during the first blocks. */
+    std::string compressed;
+    compressed.reserve(RlcHuffmanCode::c_MaxCodeLength * 3);
+
+    const AllocationCounters before = MemoryStats::GetThreadAllocations();
+    for (const auto& block : blocks) {
+        RlcCompressor::TryCompress(block[0], block[1], block[2], block[3], huffmanCoder, compressed);
+    }
+    const AllocationCounters allocated = MemoryStats::GetThreadAllocations() - before;
+
+    ASSERT_LE(allocated.m_Count, c_TryCompressBudget * blocks.size());
+}
+
+TEST(MemoryStatsTest, DecompressBudget_test) {
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+    const auto blocks = RandomBlocks(4096, 8);
+
+    std::vector<std::string> compressedBlocks;
+    for (const auto& block : blocks) {
+        compressedBlocks.push_back(RlcCompressor::Compress(block[0], block[1], block[2], block[3], huffmanCoder));
+    }
+
+    const AllocationCounters before = MemoryStats::GetThreadAllocations();
+    for (uint32_t blockIdx = 0; blockIdx < blocks.size(); ++blockIdx) {
+        const auto decompressed = RlcCompressor::Decompress(blocks[blockIdx][0], compressedBlocks[blockIdx], huffmanCoder);
+        ASSERT_EQ(decompressed.size(), 4);
+    }
+    const AllocationCounters allocated = MemoryStats::GetThreadAllocations() - before;
+
+    ASSERT_LE(allocated.m_Count, c_DecompressBudget * blocks.size());
+}
+
+TEST(MemoryStatsTest, RecoverGroupBudget_test) {
+    using BinaryMatrix = CandidateSearch::BinaryMatrix;
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
+
+    const uint16_t lsbLayers = 1;
+    const uint16_t threshold = 14;
+    const uint32_t blocksInGroup = 100;
+    const uint32_t groupSize = blocksInGroup * (4 * lsbLayers - 1);
+    const uint32_t alpha = 6;
+    const uint32_t hashSize = 3;
+    const uint32_t groupsCount = 64;
+
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<uint16_t> bitDis(0, 1);
+
+    BinaryMatrix psi(alpha, groupSize);
+    psi << BinaryMatrix::Zero(alpha, groupSize - alpha).unaryExpr([&](uint8_t) { return static_cast<uint8_t>(bitDis(generator)); }),
+        BinaryMatrix::Identity(alpha, alpha);
+    const BinaryMatrix hashMatrix = BinaryMatrix::Zero(hashSize, groupSize).unaryExpr([&](uint8_t) { return static_cast<uint8_t>(bitDis(generator)); });
+
+    std::string compressed;
+    for (uint32_t bitPos = 0; bitPos < groupSize - alpha; ++bitPos) {
+        compressed += bitDis(generator) ? "1" : "0";
+    }
+    const std::string hash{ "101" };
+
+    std::vector<CandidateSearch::PackedBlock> packedBlocks;
+    for (const auto& block : RandomBlocks(blocksInGroup * groupsCount, 255)) {
+        packedBlocks.push_back(CandidateSearch::PackBlock(block[0], block[1], block[2], block[3]));
+    }
+
+    CandidateSearch candidateSearch(psi, hashMatrix, lsbLayers, threshold);
+    Eigen::Matrix<uint8_t, 1, Eigen::Dynamic> restored;
+
+    /* The first group sizes the restored group. */
+    candidateSearch.Recover(compressed, hash, std::span(packedBlocks).first(blocksInGroup), huffmanCoder, restored);
+
+    const AllocationCounters before = MemoryStats::GetThreadAllocations();
+    for (uint32_t groupIdx = 1; groupIdx < groupsCount; ++groupIdx) {
+        candidateSearch.Recover(compressed, hash, std::span(packedBlocks).subspan(groupIdx * blocksInGroup, blocksInGroup), huffmanCoder, restored);
+    }
+    const AllocationCounters allocated = MemoryStats::GetThreadAllocations() - before;
+
+    ASSERT_LE(allocated.m_Count, c_RecoverGroupBudget * (groupsCount - 1));
+}
@@ -2,17 +2,14 @@
 
 #include "types.h"
 #include "embedder/compressor.h"
-#include "embedder/huffman.h"
+#include "embedder/rlc_huffman_code.h"
 #include "embedder/consts.h"
 
 using namespace rdh;
 
 TEST(RlcCompressTest, AllDifferencesAreZeroes_test) {
-    /* Create Huffman-coder object, which will be used to encode RLC sequences */
-    Huffman<std::pair<uint16_t, Color16s>, pair_hash> huffmanCoder(consts::c_DefaultNode);
-
-    /* Set default frequencies (found using statistical approach) */
-    huffmanCoder.SetFrequencies(consts::huffman::c_DefaultFrequencies);
+    /* Default Huffman code for RLC sequences (built at compile time from frequencies, found using statistical approach) */
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
     
     std::vector<Color8u> origPixels{ 112, 112, 112, 112 };
 
@@ -28,11 +25,8 @@ TEST(RlcCompressTest, AllDifferencesAreZeroes_test) {
 }
 
 TEST(RlcCompressTest, LastDifferenceIsZero_test) {
-    /* Create Huffman-coder object, which will be used to encode RLC sequences */
-    Huffman<std::pair<uint16_t, Color16s>, pair_hash> huffmanCoder(consts::c_DefaultNode);
-
-    /* Set default frequencies (found using statistical approach) */
-    huffmanCoder.SetFrequencies(consts::huffman::c_DefaultFrequencies);
+    /* Default Huffman code for RLC sequences (built at compile time from frequencies, found using statistical approach) */
+    const RlcHuffmanCode& huffmanCoder = consts::huffman::c_DefaultCode;
 
     std::vector<Color8u> origPixels{ 115, 79, 180, 115 };
 
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include <random>
+#include <sstream>
 
 #include "types.h"
 #include "embedder/embedder.h"
@@ -80,3 +81,84 @@ TEST(UtilsTest, Ceil_test) {
     ASSERT_EQ(utils::math::Ceil(123.0), 123);
     ASSERT_EQ(utils::math::Ceil(123.4), 124);
 }
+
+TEST(UtilsTest, HexToBytes_test) {
+    ASSERT_EQ(utils::HexToBytes<uint8_t>(""), std::vector<uint8_t>{});
+    ASSERT_EQ(utils::HexToBytes<uint8_t>("AA00bb11Cc22dD33eE9f"), (std::vector<uint8_t>{ 0xaa, 0x00, 0xbb, 0x11, 0xcc, 0x22, 0xdd, 0x33, 0xee, 0x9f }));
+
+    /* Every byte value round-trips. */
+    std::string hex;
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        const char* digits = "0123456789abcdef";
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0xf];
+    }
+    const std::vector<uint8_t> bytes = utils::HexToBytes<uint8_t>(hex);
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        ASSERT_EQ(bytes[byte], byte);
+    }
+
+    ASSERT_THROW(utils::HexToBytes<uint8_t>("ABC"), std::invalid_argument);
+    for (const char* invalid : { "0G", "g0", "@0", "0`", "/0", "0:", "0 ", "\x80" "0", "0\xC1" }) {
+        ASSERT_THROW(utils::HexToBytes<uint8_t>(invalid), std::invalid_argument) << invalid;
+    }
+}
+
+TEST(UtilsTest, LoadFileData_test) {
+    const std::string path = ::testing::TempDir() + "rdh_load_file_data.bin";
+
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<uint16_t> byteDis(0, 255);
+    for (uint32_t size : { 0, 1, 10, 1 << 20 }) {
+        std::vector<uint8_t> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(byteDis(generator));
+        }
+
+        utils::SaveDataToFileData(path, data);
+        ASSERT_EQ(utils::LoadFileData<uint8_t>(path), data);
+    }
+
+    std::remove(path.c_str());
+    ASSERT_THROW(utils::LoadFileData<uint8_t>(path), std::runtime_error);
+}
+
+TEST(UtilsTest, PackedBitWriter_test) {
+    std::mt19937 generator(1337);
+    std::uniform_int_distribution<uint16_t> bitDis(0, 1);
+
+    /* Straightforward packing: MSB first, the last byte is padded with zeroes. */
+    const auto packReference = [](const std::string& t_Bits) {
+        std::string packed((t_Bits.size() + 7) / 8, '\0');
+        for (std::size_t bitPos = 0; bitPos < t_Bits.size(); ++bitPos) {
+            packed[bitPos / 8] |= static_cast<char>((t_Bits[bitPos] == '1') << (7 - bitPos % 8));
+        }
+        return packed;
+    };
+
+    for (std::size_t bitsCount : { 0, 1, 7, 8, 9, 64, 1001, 8 * (1 << 16) + 13 }) {
+        std::string bits;
+        for (std::size_t bitPos = 0; bitPos < bitsCount; ++bitPos) {
+            bits += bitDis(generator) ? '1' : '0';
+        }
+
+        /* Single write, and the same bits split into uneven writes. */
+        std::ostringstream single;
+        utils::PackedBitWriter(single).Write(bits);
+        ASSERT_EQ(single.str(), packReference(bits)) << bitsCount;
+
+        std::ostringstream split;
+        {
+            utils::PackedBitWriter writer(split);
+            for (std::size_t bitPos = 0; bitPos < bitsCount; bitPos += 3 + bitPos % 11) {
+                writer.Write(std::string_view(bits).substr(bitPos, 3 + bitPos % 11));
+            }
+        }
+        ASSERT_EQ(split.str(), packReference(bits)) << bitsCount;
+    }
+
+    const std::string path = ::testing::TempDir() + "rdh_packed_bits.bin";
+    utils::SaveBitstreamToFile(path, "1101111010101101101");
+    ASSERT_EQ(utils::LoadFileData<uint8_t>(path), (std::vector<uint8_t>{ 0xde, 0xad, 0xa0 }));
+    std::remove(path.c_str());
+}